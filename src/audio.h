@@ -10,6 +10,7 @@
 
 #include "resource/sfx.h"
 #include "resource/bgm.h"
+#include "intern.h"
 
 #define LOOPTIMEOUTFRAMES 10
 #define DEFAULT_SFX_VOLUME 100
@@ -68,6 +69,7 @@ void update_sounds(void); // checks if loops need to be stopped
 int get_default_sfx_volume(const char *sfx);
 
 Sound* get_sound(const char *name);
+Sound* get_sound_interned(const InternedString *name);
 Music* get_music(const char *music);
 
 void start_bgm(const char *name);
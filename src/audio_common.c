@@ -19,19 +19,22 @@ static char *saved_bgm;
 static Hashtable *bgm_descriptions;
 static Hashtable *sfx_volumes;
 
+// allocated from the stage arena; the queue is dropped by reset_sounds()
 static struct enqueued_sound {
 	List chain;
-	char *name;
+	const InternedString *name;
 	int time;
 	int cooldown;
 	bool replace;
 } *sound_queue;
 
+static void play_sound_resolved(Sound *snd, bool is_ui, int cooldown, bool replace);
+
 static void play_sound_internal(const char *name, bool is_ui, int cooldown, bool replace, int delay) {
 	if(delay > 0) {
-		struct enqueued_sound *s = (struct enqueued_sound*)list_push((List**)&sound_queue, malloc(sizeof(struct enqueued_sound)));
+		struct enqueued_sound *s = (struct enqueued_sound*)list_push((List**)&sound_queue, marena_alloc(&stage_arena, sizeof(struct enqueued_sound)));
 		s->time = global.frames + delay;
-		s->name = strdup(name);
+		s->name = intern_string(name);
 		s->cooldown = cooldown;
 		s->replace = replace;
 		return;
@@ -41,8 +44,10 @@ static void play_sound_internal(const char *name, bool is_ui, int cooldown, bool
 		return;
 	}
 
-	Sound *snd = get_sound(name);
+	play_sound_resolved(get_sound(name), is_ui, cooldown, replace);
+}
 
+static void play_sound_resolved(Sound *snd, bool is_ui, int cooldown, bool replace) {
 	if(!snd || (!is_ui && snd->lastplayframe + 3 + cooldown >= global.frames) || snd->islooping) {
 		return;
 	}
@@ -53,19 +58,14 @@ static void play_sound_internal(const char *name, bool is_ui, int cooldown, bool
 		(snd->impl, is_ui ? SNDGROUP_UI : SNDGROUP_MAIN);
 }
 
-static void* discard_enqueued_sound(List **queue, List *vsnd, void *arg) {
-	struct enqueued_sound *snd = (struct enqueued_sound*)vsnd;
-	free(snd->name);
-	free(list_unlink(queue, vsnd));
-	return NULL;
-}
+static void play_enqueued_sound(struct enqueued_sound *snd) {
+	list_unlink((List**)&sound_queue, (List*)snd);
+
+	if(!audio_backend_initialized() || global.frameskip) {
+		return;
+	}
 
-static void* play_enqueued_sound(List **queue, List *vsnd, void *arg) {
-	struct enqueued_sound *snd = (struct enqueued_sound*)vsnd;
-	play_sound_internal(snd->name, false, snd->cooldown, snd->replace, 0);
-	free(snd->name);
-	free(list_unlink(queue, vsnd));
-	return NULL;
+	play_sound_resolved(get_sound_interned(snd->name), false, snd->cooldown, snd->replace);
 }
 
 void play_sound(const char *name) {
@@ -104,8 +104,9 @@ void play_loop(const char *name) {
 
 void reset_sounds(void) {
 	Resource *snd;
-	for(HashtableIterator *i = hashtable_iter(resources.handlers[RES_SFX].mapping);
-			hashtable_iter_next(i, 0, (void**)&snd);) {
+	HashtableIterator i;
+
+	for(hashtable_iter_init(resources.handlers[RES_SFX].mapping, &i); hashtable_iter_next(&i, 0, (void**)&snd);) {
 		snd->sound->lastplayframe = 0;
 		if(snd->sound->islooping) {
 			snd->sound->islooping = false;
@@ -113,14 +114,14 @@ void reset_sounds(void) {
 		}
 	}
 
-	list_foreach((List**)&sound_queue, discard_enqueued_sound, NULL);
+	sound_queue = NULL;
 }
 
 void update_sounds(void) {
 	Resource *snd;
+	HashtableIterator i;
 
-	for(HashtableIterator *i = hashtable_iter(resources.handlers[RES_SFX].mapping);
-			hashtable_iter_next(i, 0, (void**)&snd);) {
+	for(hashtable_iter_init(resources.handlers[RES_SFX].mapping, &i); hashtable_iter_next(&i, 0, (void**)&snd);) {
 		if(snd->sound->islooping && global.frames > snd->sound->lastplayframe + LOOPTIMEOUTFRAMES) {
 			snd->sound->islooping = false;
 			audio_backend_sound_stop_loop(snd->sound->impl);
@@ -131,7 +132,7 @@ void update_sounds(void) {
 		next = (struct enqueued_sound*)s->chain.next;
 
 		if(s->time <= global.frames) {
-			play_enqueued_sound((List**)&sound_queue, (List*)s, NULL);
+			play_enqueued_sound(s);
 		}
 	}
 }
@@ -153,6 +154,11 @@ Sound* get_sound(const char *name) {
 	return res ? res->sound : NULL;
 }
 
+Sound* get_sound_interned(const InternedString *name) {
+	Resource *res = get_resource_interned(RES_SFX, name, RESF_OPTIONAL);
+	return res ? res->sound : NULL;
+}
+
 Music* get_music(const char *name) {
 	Resource *res = get_resource(RES_BGM, name, RESF_OPTIONAL);
 	return res ? res->music : NULL;
@@ -67,11 +67,11 @@ void draw_extraspell_bg(Boss *boss, int time) {
 
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 	glColor4f(0.2,0.1,0,0.7);
-	fill_screen(sin(time) * 0.015, time / 50.0, 1, "stage3/wspellclouds");
+	fill_screen_p(sin(time) * 0.015, time / 50.0, 1, 1, 0, get_tex_interned(INTERN_STATIC("stage3/wspellclouds")));
 	glColor4f(1,1,1,1);
 	glBlendEquation(GL_MIN);
-	fill_screen(cos(time) * 0.015, time / 70.0, 1, "stage4/kurumibg2");
-	fill_screen(sin(time+2.1) * 0.015, time / 30.0, 1, "stage4/kurumibg2");
+	fill_screen_p(cos(time) * 0.015, time / 70.0, 1, 1, 0, get_tex_interned(INTERN_STATIC("stage4/kurumibg2")));
+	fill_screen_p(sin(time+2.1) * 0.015, time / 30.0, 1, 1, 0, get_tex_interned(INTERN_STATIC("stage4/kurumibg2")));
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glBlendEquation(GL_FUNC_ADD);
 }
@@ -158,8 +158,8 @@ static void BossGlow(Projectile *p, int t) {
 
 	float fade = 1 - clr[3];
 	float deform = 5 - 10 * fade * fade;
-	glUniform4fv(uniloc(shader, "color"), 1, clr);
-	glUniform1f(uniloc(shader, "deform"), deform);
+	glUniform4fv(uniloc_interned(shader, INTERN_STATIC("color")), 1, clr);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("deform")), deform);
 
 	aniplayer_play(aplr,0,0);
 
@@ -236,7 +236,7 @@ void draw_boss_background(Boss *boss) {
 	}
 
 	glScalef(f,f,f);
-	draw_texture(0, 0, "boss_circle");
+	draw_texture_p(0, 0, get_tex_interned(INTERN_STATIC("boss_circle")));
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glPopMatrix();
 }
@@ -359,7 +359,7 @@ void draw_boss(Boss *boss) {
 		int x = 0;
 		for(int i = boss->acount-1; i > nextspell; i--)
 			if(boss->attacks[i].type == AT_Spellcard)
-				draw_texture_with_size(x += 22, 40, 20, 20, "star");
+				draw_texture_with_size_p(x += 22, 40, 20, 20, get_tex_interned(INTERN_STATIC("star")));
 
 		glColor3f(1,1,1);
 	}
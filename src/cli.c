@@ -52,6 +52,7 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		{{"vfs-tree", required_argument, 0, 't'}, "Print the virtual filesystem tree starting from %s", "PATH"},
 #endif
 		{{"credits", no_argument, 0, 'c'}, "Show the credits scene and exit"},
+		{{"bench-textures", no_argument, 0, 'b'}, "Measure texture decoding speed over the whole gfx/ tree and exit", 0},
 		{{"help", no_argument, 0, 'h'}, "Display this help"},
 		{{0,0,0,0},0,0}
 	};
@@ -155,6 +156,9 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		case 'c':
 			a->type = CLI_Credits;
 			break;
+		case 'b':
+			a->type = CLI_BenchTextures;
+			break;
 		default:
 			log_fatal("Unknown option (this shouldn’t happen)");
 		}
@@ -18,6 +18,7 @@ typedef enum {
 	CLI_DumpVFSTree,
 	CLI_Quit,
 	CLI_Credits,
+	CLI_BenchTextures,
 } CLIActionType;
 
 typedef struct CLIAction CLIAction;
@@ -195,7 +195,7 @@ void BigFairy(Enemy *e, int t, bool render) {
 	glPushMatrix();
 	glRotatef(global.frames*10,0,0,1);
 	glScalef(s, s, s);
-	draw_texture(0,0,"fairy_circle");
+	draw_texture_p(0,0,get_tex_interned(INTERN_STATIC("fairy_circle")));
 	glPopMatrix();
 
 	if(e->dir) {
@@ -221,7 +221,7 @@ void Fairy(Enemy *e, int t, bool render) {
 	glPushMatrix();
 	glRotatef(global.frames*10,0,0,1);
 	glScalef(s, s, s);
-	draw_texture(0,0,"fairy_circle");
+	draw_texture_p(0,0,get_tex_interned(INTERN_STATIC("fairy_circle")));
 	glPopMatrix();
 
 	glPushMatrix();
@@ -247,7 +247,7 @@ void Swirl(Enemy *e, int t, bool render) {
 	glPushMatrix();
 	glTranslatef(creal(e->pos), cimag(e->pos),0);
 	glRotatef(t*15,0,0,1);
-	draw_texture(0,0, "swirl");
+	draw_texture_p(0,0, get_tex_interned(INTERN_STATIC("swirl")));
 	glPopMatrix();
 }
 
@@ -19,6 +19,7 @@ uint32_t sdl_first_user_event;
 
 static void events_register_default_handlers(void);
 static void events_unregister_default_handlers(void);
+static void handler_sets_free(void);
 
 /*
  *	Public API
@@ -46,6 +47,8 @@ void events_init(void) {
 void events_shutdown(void) {
 	events_unregister_default_handlers();
 
+	handler_sets_free();
+
 #ifdef DEBUG
 	if(global_handlers) {
 		log_warn(
@@ -82,87 +85,169 @@ static EventPriority real_priority(EventPriority prio) {
 	return prio;
 }
 
-static bool events_invoke_handlers(SDL_Event *event, ListContainer *h_list, EventHandler *h_array) {
-	// invoke handlers from two sources (a list and an array) in the correct order according to priority
-	// list items take precedence
-	//
-	// assumptions:
-	// 		h_list is sorted by priority
-	//		h_array is in arbitrary order and terminated with a NULL-proc entry
+/*
+ *	Handler sets
+ *
+ *	Dispatching an event means walking the global handlers and the per-loop handler array together,
+ *	in priority order. Rather than merging the two for every event, the merged result is compiled
+ *	into a flat array and cached, keyed by the version of the global list and the contents of the
+ *	local array. events_poll() looks its set up once, and then every event is just a linear walk.
+ *
+ *	The sets hold copies of the handlers, so they stay usable even if a handler is unregistered in
+ *	the middle of a dispatch. A set is never rebuilt while a dispatch is using it, which matters
+ *	because handlers may run nested loops that poll events with their own arrays.
+ */
 
-	bool result = false;
+#define HANDLER_SET_CACHE_SIZE 8
+
+typedef struct EventHandlerSet {
+	EventHandler *handlers; // sorted by priority, terminated with a NULL-proc entry
+	EventHandler *local;    // the local array this set was built for, as it was at the time
+	unsigned int num_handlers;
+	unsigned int num_local;
+	uint32_t version;
+	uint32_t last_used;
+	int refs;
+	bool temporary;
+} EventHandlerSet;
+
+static EventHandlerSet handler_sets[HANDLER_SET_CACHE_SIZE];
+static uint32_t global_handlers_version = 1;
+static uint32_t handler_sets_clock;
+
+static unsigned int count_handlers(EventHandler *h_array) {
+	unsigned int n = 0;
+
+	if(h_array) {
+		while(h_array[n].proc) {
+			++n;
+		}
+	}
 
-	if(h_list && !h_array) {
-		// case 1 (simplest): we have a list and no custom handlers
+	return n;
+}
 
-		for(ListContainer *c = h_list; c; c = c->next) {
-			if((result = events_invoke_handler(event, (EventHandler*)c->data))) {
-				break;
-			}
+static bool handlers_equal(EventHandler *a, EventHandler *b) {
+	return
+		a->proc == b->proc &&
+		a->arg == b->arg &&
+		a->priority == b->priority &&
+		a->event_type == b->event_type;
+}
+
+static bool handler_set_matches(EventHandlerSet *set, EventHandler *h_array, unsigned int num_local) {
+	if(!set->handlers || set->version != global_handlers_version || set->num_local != num_local) {
+		return false;
+	}
+
+	for(unsigned int i = 0; i < num_local; ++i) {
+		if(!handlers_equal(set->local + i, h_array + i)) {
+			return false;
 		}
+	}
 
-		return result;
+	return true;
+}
+
+static void handler_set_build(EventHandlerSet *set, EventHandler *h_array, unsigned int num_local) {
+	unsigned int num_global = 0;
+
+	for(ListContainer *c = global_handlers; c; c = c->next) {
+		++num_global;
 	}
 
-	if(h_list && h_array) {
-		// case 2 (suboptimal): we have both a list and a disordered array; need to do some actual work
-		// if you want to optimize this be my guest
+	set->num_handlers = num_global + num_local;
+	set->num_local = num_local;
+	set->version = global_handlers_version;
+	set->handlers = realloc(set->handlers, sizeof(EventHandler) * (set->num_handlers + 1));
+	set->local = realloc(set->local, sizeof(EventHandler) * (num_local + 1));
 
-		ListContainer *merged_list = NULL;
-		ListContainer *prevc = NULL;
+	if(num_local) {
+		memcpy(set->local, h_array, sizeof(EventHandler) * num_local);
+	}
 
-		// copy the list
-		for(ListContainer *c = h_list; c; c = c->next) {
-			ListContainer *newc = calloc(1, sizeof(ListContainer));
-			newc->data = c->data;
-			newc->prev = prevc;
+	// the global list is already sorted, and its handlers take precedence over local ones of equal priority
+	unsigned int n = 0;
 
-			if(prevc) {
-				prevc->next = newc;
-			}
+	for(ListContainer *c = global_handlers; c; c = c->next) {
+		set->handlers[n++] = *(EventHandler*)c->data;
+	}
 
-			if(!merged_list) {
-				merged_list = newc;
-			}
+	// insert each local handler after everything with the same or higher priority, keeping the array order among equals
+	for(unsigned int i = 0; i < num_local; ++i) {
+		EventPriority prio = real_priority(h_array[i].priority);
+		unsigned int pos = n;
 
-			prevc = newc;
+		while(pos > 0 && real_priority(set->handlers[pos - 1].priority) > prio) {
+			--pos;
 		}
 
-		// merge the array into the list copy, respecting priority
-		for(EventHandler *h = h_array; h->proc; ++h) {
-			list_insert_at_priority(
-				&merged_list,
-				list_wrap_container(h),
-				real_priority(h->priority),
-				handler_container_prio_func
-			);
+		memmove(set->handlers + pos + 1, set->handlers + pos, sizeof(EventHandler) * (n - pos));
+		set->handlers[pos] = h_array[i];
+		++n;
+	}
+
+	memset(set->handlers + n, 0, sizeof(EventHandler));
+}
+
+static EventHandlerSet* handler_set_acquire(EventHandler *h_array) {
+	unsigned int num_local = count_handlers(h_array);
+	EventHandlerSet *victim = NULL;
+
+	for(EventHandlerSet *set = handler_sets; set < handler_sets + HANDLER_SET_CACHE_SIZE; ++set) {
+		if(handler_set_matches(set, h_array, num_local)) {
+			set->last_used = ++handler_sets_clock;
+			set->refs++;
+			return set;
 		}
 
-		// iterate over the merged list
-		for(ListContainer *c = merged_list; c; c = c->next) {
-			if((result = events_invoke_handler(event, (EventHandler*)c->data))) {
-				break;
-			}
+		if(!set->refs && (!victim || set->last_used < victim->last_used)) {
+			victim = set;
 		}
+	}
 
-		list_free_all((List**)&merged_list);
-		return result;
+	if(!victim) {
+		// nested deeper than the cache is big; very unlikely, but don't evict a set that's in use
+		victim = calloc(1, sizeof(EventHandlerSet));
+		victim->temporary = true;
 	}
 
-	if(!h_list && h_array) {
-		// case 3 (unlikely): we don't have a list for some reason (no global handlers?), but there are custom handlers
+	handler_set_build(victim, h_array, num_local);
+	victim->last_used = ++handler_sets_clock;
+	victim->refs++;
+	return victim;
+}
 
-		for(EventHandler *h = h_array; h->proc; ++h) {
-			if((result = events_invoke_handler(event, h))) {
-				break;
-			}
-		}
+static void handler_set_free(EventHandlerSet *set) {
+	free(set->handlers);
+	free(set->local);
+	memset(set, 0, sizeof(*set));
+}
 
-		return result;
+static void handler_sets_free(void) {
+	for(int i = 0; i < HANDLER_SET_CACHE_SIZE; ++i) {
+		assert(!handler_sets[i].refs);
+		handler_set_free(handler_sets + i);
 	}
+}
 
-	// case 4 (unlikely): huh? okay then
-	return result;
+static void handler_set_release(EventHandlerSet *set) {
+	assert(set->refs > 0);
+
+	if(!--set->refs && set->temporary) {
+		handler_set_free(set);
+		free(set);
+	}
+}
+
+static bool events_invoke_handlers(SDL_Event *event, EventHandler *handlers) {
+	for(EventHandler *h = handlers; h->proc; ++h) {
+		if(events_invoke_handler(event, h)) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
 void events_register_handler(EventHandler *handler) {
@@ -182,6 +267,7 @@ void events_register_handler(EventHandler *handler) {
 		handler_container_prio_func
 	);
 
+	++global_handlers_version;
 	log_debug("Registered handler: %p %u", *(void**)&handler_alloc->proc, handler_alloc->priority);
 }
 
@@ -194,6 +280,7 @@ void events_unregister_handler(EventHandlerProc proc) {
 		if(h->proc == proc) {
 			free(c->data);
 			free(list_unlink(&global_handlers, c));
+			++global_handlers_version;
 			return;
 		}
 	}
@@ -225,8 +312,23 @@ void events_poll(EventHandler *handlers, EventFlags flags) {
 	SDL_Event event;
 	events_apply_flags(flags);
 
+	EventHandlerSet *set = NULL;
+
 	while(SDL_PollEvent(&event)) {
-		events_invoke_handlers(&event, global_handlers, handlers);
+		if(!set || set->version != global_handlers_version) {
+			// first event, or a handler (un)registered something during the last one
+			if(set) {
+				handler_set_release(set);
+			}
+
+			set = handler_set_acquire(handlers);
+		}
+
+		events_invoke_handlers(&event, set->handlers);
+	}
+
+	if(set) {
+		handler_set_release(set);
 	}
 }
 
@@ -415,7 +517,12 @@ static bool events_handler_hotkeys(SDL_Event *event, void *arg) {
 	SDL_Keymod mod = event->key.keysym.mod;
 
 	if(scan == config_get_int(CONFIG_KEY_SCREENSHOT)) {
-		video_take_screenshot();
+		if(mod & KMOD_SHIFT) {
+			video_toggle_continuous_capture();
+		} else {
+			video_take_screenshot();
+		}
+
 		return true;
 	}
 
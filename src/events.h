@@ -11,8 +11,6 @@
 #include "util.h"
 
 typedef enum {
-	TE_RESOURCE_ASYNC_LOADED,
-
 	#define TE_MENU_FIRST TE_MENU_CURSOR_UP
 	TE_MENU_CURSOR_UP,
 	TE_MENU_CURSOR_DOWN,
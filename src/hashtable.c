@@ -7,6 +7,7 @@
  */
 
 #include "hashtable.h"
+#include "intern.h"
 #include "list.h"
 #include "util.h"
 
@@ -15,69 +16,114 @@
 #include <stdio.h>
 #include <SDL_mutex.h>
 
-// #define HT_USE_MUTEX
+/*
+ *  Open addressing with linear probing and Robin Hood insertion: an element that is further away
+ *  from its ideal slot takes the place of one that is closer to its own. This keeps probe sequences
+ *  short and evenly distributed even at high load, and lets a lookup stop as soon as it meets an
+ *  element that is closer to home than the key being searched would be. Removal shifts the following
+ *  elements back by one instead of leaving tombstones.
+ *
+ *  The table size is always a power of two, and it doubles once the load factor exceeds
+ *  HT_MAX_LOAD_NUM / HT_MAX_LOAD_DEN. The slots only hold a cached hash and an index into a dense
+ *  array of entries, allocated in the same block. Probing touches nothing but the compact slots,
+ *  full scans walk the entries without skipping over empty slots, and removal keeps the entries
+ *  dense by moving the last one into the hole. There's no per-element allocation, and resizing
+ *  rebuilds the slots from the entries without calling the hash function.
+ */
+
+/*
+ *  Concurrency: lookups never take a lock. Writers are serialized by a mutex, and bracket every
+ *  in-place modification of the slot array with increments of its sequence counter; a reader that
+ *  observes the counter change (or odd) while probing probes again. If that keeps happening, the
+ *  writer may have been preempted halfway through an update, so rather than spinning until it gets
+ *  scheduled again, the reader waits for it on the mutex and probes under the lock. A resize builds
+ *  the new array on the side and publishes it with a single pointer swap, so readers are never
+ *  blocked by it.
+ *
+ *  Nothing a reader might still be looking at is freed right away: replaced slot arrays and keys of
+ *  removed elements are retired, and reclaimed once every reader that could have seen them is done.
+ *  Readers announce themselves in one of two counters, picked by the parity of the current epoch.
+ *  Writers advance the epoch once the readers of the previous one have drained, and reclaim whatever
+ *  was retired before that.
+ */
+
+#define HT_MAX_LOAD_NUM 3
+#define HT_MAX_LOAD_DEN 4
+
+// lock-free probes a lookup attempts before it falls back to taking the mutex
+#define HT_READ_ATTEMPTS 8
 
 typedef struct HashtableElement {
-    void *next;
-    void *prev;
-    void *data;
-    void *key;
     hash_t hash;
+    uint32_t dist;  // 1 + distance from the ideal slot; 0 means the slot is empty
+    uint32_t index; // into the entries array
 } HashtableElement;
 
+typedef struct HashtableSlots {
+    SDL_atomic_t seq; // odd while a writer is modifying the slots or entries
+    size_t size;
+    HashtableEntry *entries; // size * HT_MAX_LOAD_NUM / HT_MAX_LOAD_DEN of them, right after the slots
+    HashtableElement elems[];
+} HashtableSlots;
+
+typedef struct HashtableRetired {
+    void **ptrs;
+    HTFreeFunc *free_funcs;
+    size_t num;
+    size_t capacity;
+} HashtableRetired;
+
 struct Hashtable {
-    HashtableElement **table;
-    size_t table_size;
+    void *slots; // HashtableSlots*, accessed atomically
     HTCmpFunc cmp_func;
     HTHashFunc hash_func;
     HTCopyFunc copy_func;
     HTFreeFunc free_func;
-#ifdef HT_USE_MUTEX
     SDL_mutex *mutex;
-#else
-    SDL_atomic_t cur_operation;
-    SDL_atomic_t num_operations;
-#endif
+    SDL_atomic_t epoch;
+    SDL_atomic_t readers[2];
+    HashtableRetired retired[2];
     size_t num_elements;
-    bool dynamic_size;
-};
-
-enum {
-    HT_OP_NONE,
-    HT_OP_READ,
-    HT_OP_WRITE,
+    bool interned_keys; // every key is an InternedString's str, so equal keys are equal pointers
 };
 
-typedef struct HashtableIterator {
-    Hashtable *hashtable;
-    size_t bucketnum;
-    HashtableElement *elem;
-} HashtableIterator;
-
 /*
  *  Generic functions
  */
 
 static size_t constraint_size(size_t size) {
-    if(size < HT_MIN_SIZE)
-        return HT_MIN_SIZE;
+    size_t s = HT_MIN_SIZE;
+
+    while(s < size) {
+        s <<= 1;
+    }
+
+    return s;
+}
+
+static inline size_t hashtable_capacity(size_t size) {
+    return size * HT_MAX_LOAD_NUM / HT_MAX_LOAD_DEN;
+}
 
-    if(size > HT_MAX_SIZE)
-        return HT_MAX_SIZE;
+static HashtableSlots* hashtable_alloc_slots(size_t size) {
+    HashtableSlots *slots = calloc(1,
+        sizeof(HashtableSlots) + size * sizeof(HashtableElement) + hashtable_capacity(size) * sizeof(HashtableEntry)
+    );
 
-    return size;
+    slots->size = size;
+    slots->entries = (HashtableEntry*)(slots->elems + size);
+    return slots;
+}
+
+static inline HashtableSlots* hashtable_slots(Hashtable *ht) {
+    return SDL_AtomicGetPtr(&ht->slots);
 }
 
 Hashtable* hashtable_new(size_t size, HTCmpFunc cmp_func, HTHashFunc hash_func, HTCopyFunc copy_func, HTFreeFunc free_func) {
-    Hashtable *ht = malloc(sizeof(Hashtable));
+    Hashtable *ht = calloc(1, sizeof(Hashtable));
 
-    if(size == HT_DYNAMIC_SIZE) {
-        size = constraint_size(0);
-        ht->dynamic_size = true;
-    } else {
-        size = constraint_size(size);
-        ht->dynamic_size = false;
-    }
+    // the size is only a hint now; make room for that many elements without growing
+    size = constraint_size(size * HT_MAX_LOAD_DEN / HT_MAX_LOAD_NUM);
 
     if(!cmp_func) {
         cmp_func = hashtable_cmpfunc_ptr;
@@ -87,93 +133,120 @@ Hashtable* hashtable_new(size_t size, HTCmpFunc cmp_func, HTHashFunc hash_func,
         copy_func = hashtable_copyfunc_ptr;
     }
 
-    ht->table = calloc(size, sizeof(HashtableElement*));
-    ht->table_size = size;
-    ht->num_elements = 0;
+    ht->slots = hashtable_alloc_slots(size);
     ht->cmp_func = cmp_func;
     ht->hash_func = hash_func;
     ht->copy_func = copy_func;
     ht->free_func = free_func;
-
-#ifdef HT_USE_MUTEX
     ht->mutex = SDL_CreateMutex();
-#else
-    SDL_AtomicSet(&ht->cur_operation, HT_OP_NONE);
-    SDL_AtomicSet(&ht->num_operations, 0);
-#endif
 
     assert(ht->hash_func != NULL);
 
     return ht;
 }
 
-#ifdef HT_USE_MUTEX
-static void hashtable_enter_state(Hashtable *ht, int state, bool mutex) {
-    SDL_LockMutex(ht->mutex);
+static void hashtable_read_begin(Hashtable *ht, int *epoch) {
+    for(;;) {
+        int e = SDL_AtomicGet(&ht->epoch);
+        SDL_AtomicIncRef(ht->readers + (e & 1));
+
+        // the epoch may have advanced before we were counted; the writer wouldn't have waited for us then
+        if(SDL_AtomicGet(&ht->epoch) == e) {
+            *epoch = e;
+            return;
+        }
+
+        SDL_AtomicDecRef(ht->readers + (e & 1));
+    }
 }
 
-static void hashtable_idle_state(Hashtable *ht) {
-    SDL_UnlockMutex(ht->mutex);
+static void hashtable_read_end(Hashtable *ht, int epoch) {
+    SDL_AtomicDecRef(ht->readers + (epoch & 1));
 }
-#else
-static bool hashtable_try_enter_state(Hashtable *ht, int state, bool mutex) {
-    SDL_atomic_t *ptr = &ht->cur_operation;
 
-    if(!mutex) {
-        SDL_AtomicCAS(ptr, state, HT_OP_NONE);
+static void hashtable_retire(Hashtable *ht, void *ptr, HTFreeFunc free_func) {
+    HashtableRetired *r = ht->retired + (SDL_AtomicGet(&ht->epoch) & 1);
+
+    if(r->num == r->capacity) {
+        r->capacity = r->capacity ? r->capacity * 2 : 16;
+        r->ptrs = realloc(r->ptrs, r->capacity * sizeof(void*));
+        r->free_funcs = realloc(r->free_funcs, r->capacity * sizeof(HTFreeFunc));
     }
 
-    return SDL_AtomicCAS(ptr, HT_OP_NONE, state);
+    r->ptrs[r->num] = ptr;
+    r->free_funcs[r->num] = free_func;
+    r->num++;
 }
 
-static void hashtable_enter_state(Hashtable *ht, int state, bool mutex) {
-    while(!hashtable_try_enter_state(ht, state, mutex) || (mutex && SDL_AtomicGet(&ht->num_operations)));
-    SDL_AtomicIncRef(&ht->num_operations);
+static void hashtable_reclaim_list(HashtableRetired *r) {
+    for(size_t i = 0; i < r->num; ++i) {
+        r->free_funcs[i](r->ptrs[i]);
+    }
+
+    r->num = 0;
 }
 
+static void hashtable_reclaim(Hashtable *ht) {
+    // must be called by the writer
+    int epoch = SDL_AtomicGet(&ht->epoch);
+    int prev = (epoch + 1) & 1;
 
-static void hashtable_idle_state(Hashtable *ht) {
-    if(SDL_AtomicDecRef(&ht->num_operations)) {
-        SDL_AtomicSet(&ht->cur_operation, HT_OP_NONE);
+    if(SDL_AtomicGet(ht->readers + prev)) {
+        // someone may still be looking at what was retired in the previous epoch
+        return;
+    }
+
+    hashtable_reclaim_list(ht->retired + prev);
+
+    if(ht->retired[epoch & 1].num) {
+        SDL_AtomicSet(&ht->epoch, epoch + 1);
     }
 }
-#endif
+
+static void hashtable_write_begin(HashtableSlots *slots) {
+    SDL_AtomicIncRef(&slots->seq);
+}
+
+static void hashtable_write_end(HashtableSlots *slots) {
+    SDL_AtomicIncRef(&slots->seq);
+}
 
 void hashtable_lock(Hashtable *ht) {
     assert(ht != NULL);
-    hashtable_enter_state(ht, HT_OP_READ, false);
+    SDL_LockMutex(ht->mutex);
 }
 
 void hashtable_unlock(Hashtable *ht) {
     assert(ht != NULL);
-    hashtable_idle_state(ht);
+    SDL_UnlockMutex(ht->mutex);
 }
 
-static void* hashtable_delete_callback(List **vlist, List *velem, void *vht) {
-    Hashtable *ht = vht;
-    HashtableElement *elem = (HashtableElement*)velem;
-
-    if(ht->free_func) {
-        ht->free_func(elem->key);
+static void hashtable_free_keys(Hashtable *ht, HashtableSlots *slots, bool retire) {
+    if(!ht->free_func) {
+        return;
     }
 
-    free(list_unlink(vlist, velem));
-    return NULL;
-}
-
-static void hashtable_unset_all_internal(Hashtable *ht) {
-    for(size_t i = 0; i < ht->table_size; ++i) {
-        list_foreach((List**)(ht->table + i), hashtable_delete_callback, ht);
+    for(size_t i = 0; i < ht->num_elements; ++i) {
+        if(retire) {
+            hashtable_retire(ht, slots->entries[i].key, ht->free_func);
+        } else {
+            ht->free_func(slots->entries[i].key);
+        }
     }
-
-    ht->num_elements = 0;
 }
 
 void hashtable_unset_all(Hashtable *ht) {
     assert(ht != NULL);
-    hashtable_enter_state(ht, HT_OP_WRITE, true);
-    hashtable_unset_all_internal(ht);
-    hashtable_idle_state(ht);
+    SDL_LockMutex(ht->mutex);
+
+    HashtableSlots *slots = hashtable_slots(ht);
+    hashtable_free_keys(ht, slots, true);
+    SDL_AtomicSetPtr(&ht->slots, hashtable_alloc_slots(slots->size));
+    hashtable_retire(ht, slots, free);
+    ht->num_elements = 0;
+    hashtable_reclaim(ht);
+
+    SDL_UnlockMutex(ht->mutex);
 }
 
 void hashtable_free(Hashtable *ht) {
@@ -181,162 +254,193 @@ void hashtable_free(Hashtable *ht) {
         return;
     }
 
-    hashtable_unset_all(ht);
+    // nobody may be reading at this point
+    HashtableSlots *slots = hashtable_slots(ht);
+    hashtable_free_keys(ht, slots, false);
+    free(slots);
 
-#ifdef HT_USE_MUTEX
-    SDL_DestroyMutex(ht->mutex);
-#endif
+    for(int i = 0; i < 2; ++i) {
+        hashtable_reclaim_list(ht->retired + i);
+        free(ht->retired[i].ptrs);
+        free(ht->retired[i].free_funcs);
+    }
 
-    free(ht->table);
+    SDL_DestroyMutex(ht->mutex);
     free(ht);
 }
 
-void* hashtable_get(Hashtable *ht, void *key) {
-    assert(ht != NULL);
+static HashtableElement* hashtable_find(Hashtable *ht, HashtableSlots *slots, hash_t hash, void *key, bool by_pointer) {
+    size_t mask = slots->size - 1;
+    size_t idx = hash & mask;
 
-    hash_t hash = ht->hash_func(key);
-    hashtable_enter_state(ht, HT_OP_READ, false);
-    HashtableElement *elems = ht->table[hash % ht->table_size];
+    for(uint32_t dist = 1;; ++dist, idx = (idx + 1) & mask) {
+        HashtableElement *e = slots->elems + idx;
+        uint32_t edist = e->dist;
 
-    for(HashtableElement *e = elems; e; e = e->next) {
-        if(hash == e->hash && ht->cmp_func(key, e->key)) {
-            hashtable_idle_state(ht);
-            return e->data;
+        if(edist < dist) {
+            // an empty slot, or an element that's closer to home than ours would be; ours can't be further along
+            return NULL;
         }
-    }
 
-    hashtable_idle_state(ht);
-    return NULL;
-}
+        // pairs with the release in hashtable_set: if the slot is occupied, its entry is filled in
+        SDL_MemoryBarrierAcquire();
 
-void* hashtable_get_unsafe(Hashtable *ht, void *key) {
-    hash_t hash = ht->hash_func(key);
-    HashtableElement *elems = ht->table[hash % ht->table_size];
+        if(e->hash == hash) {
+            void *ekey = slots->entries[e->index].key;
 
-    for(HashtableElement *e = elems; e; e = e->next) {
-        if(hash == e->hash && ht->cmp_func(key, e->key)) {
-            return e->data;
+            if(by_pointer ? ekey == key : ht->cmp_func(key, ekey)) {
+                return e;
+            }
         }
     }
-
-    return NULL;
 }
 
-static bool hashtable_set_internal(Hashtable *ht, HashtableElement **table, size_t table_size, hash_t hash, void *key, void *data) {
-    bool collisions_updated = false;
-    size_t idx = hash % table_size;
+static void* hashtable_get_internal(Hashtable *ht, hash_t hash, void *key, bool by_pointer) {
+    HashtableSlots *slots;
+    HashtableElement *e;
+    void *data;
+    int epoch;
 
-    HashtableElement *elems = table[idx], *elem;
+    hashtable_read_begin(ht, &epoch);
 
-    for(HashtableElement *e = elems; e; e = e->next) {
-        if(hash == e->hash && ht->cmp_func(key, e->key)) {
-            if(ht->free_func) {
-                ht->free_func(e->key);
-            }
+    for(int attempt = 0; attempt < HT_READ_ATTEMPTS; ++attempt) {
+        slots = hashtable_slots(ht);
+        int seq = SDL_AtomicGet(&slots->seq);
 
-            free(list_unlink((List**)&elems, (List*)e));
-            ht->num_elements--;
+        if(seq & 1) {
+            // a writer is in the middle of moving elements around
+            continue;
+        }
 
-            if(elems) {
-                // we have just deleted an element from a bucket that had collisions.
-                collisions_updated = true;
-            }
+        e = hashtable_find(ht, slots, hash, key, by_pointer);
+        data = e ? slots->entries[e->index].data : NULL;
 
-            break;
+        SDL_MemoryBarrierAcquire();
+
+        if(SDL_AtomicGet(&slots->seq) == seq) {
+            hashtable_read_end(ht, epoch);
+            return data;
         }
     }
 
-    if(data) {
-        if(elems) {
-            // we are adding an element to a non-empty bucket.
-            // normally this is a new collision, unless we are replacing an existing element.
-            collisions_updated = !collisions_updated;
-        }
+    // the writer is taking its time (it may have been preempted mid-update); wait for it to finish
+    SDL_LockMutex(ht->mutex);
+    slots = hashtable_slots(ht);
+    e = hashtable_find(ht, slots, hash, key, by_pointer);
+    data = e ? slots->entries[e->index].data : NULL;
+    SDL_UnlockMutex(ht->mutex);
 
-        elem = (HashtableElement*)list_push((List**)&elems, malloc(sizeof(HashtableElement)));
-        ht->copy_func(&elem->key, key);
-        elem->hash = ht->hash_func(elem->key);
-        elem->data = data;
+    hashtable_read_end(ht, epoch);
+    return data;
+}
 
-        ht->num_elements++;
-    }
+void* hashtable_get(Hashtable *ht, void *key) {
+    assert(ht != NULL);
+    return hashtable_get_internal(ht, ht->hash_func(key), key, false);
+}
+
+void* hashtable_get_interned(Hashtable *ht, const InternedString *key) {
+    assert(ht != NULL);
+    assert(key != NULL);
 
-    table[idx] = elems;
-    return collisions_updated;
+    hash_t hash = ht->hash_func == hashtable_get_string_hashfunc() ? key->hash : ht->hash_func((void*)key->str);
+    return hashtable_get_internal(ht, hash, (void*)key->str, ht->interned_keys);
 }
 
-static int hashtable_check_collisions_with_new_size(Hashtable *ht, size_t size) {
-    int *ctable = calloc(sizeof(int), size);
-    int cols = 0;
+static void hashtable_insert_internal(HashtableSlots *slots, HashtableElement elem) {
+    size_t mask = slots->size - 1;
+    size_t idx = elem.hash & mask;
 
-    for(size_t i = 0; i < ht->table_size; ++i) {
-        for(HashtableElement *e = ht->table[i]; e; e = e->next) {
-            size_t idx = e->hash % size;
-            ++ctable[idx];
+    for(elem.dist = 1;; ++elem.dist, idx = (idx + 1) & mask) {
+        HashtableElement *e = slots->elems + idx;
 
-            if(ctable[idx] > 1) {
-                ++cols;
-            }
+        if(!e->dist) {
+            uint32_t dist = elem.dist;
+            elem.dist = 0;
+            *e = elem;
+            SDL_MemoryBarrierRelease();
+            e->dist = dist;
+            return;
         }
-    }
 
-    free(ctable);
-    return cols;
+        if(e->dist < elem.dist) {
+            HashtableElement tmp = *e;
+            *e = elem;
+            elem = tmp;
+        }
+    }
 }
 
-static size_t hashtable_find_optimal_size(Hashtable *ht) {
-    size_t best_size = ht->table_size;
-    int col_tolerance = min(HT_COLLISION_TOLERANCE + 1, max(ht->num_elements / 2, 1));
-    int min_cols = 0;
+static HashtableElement* hashtable_find_index(HashtableSlots *slots, hash_t hash, uint32_t index) {
+    size_t mask = slots->size - 1;
 
-    for(size_t s = best_size; s < HT_MAX_SIZE; s += HT_RESIZE_STEP) {
-        int cols = hashtable_check_collisions_with_new_size(ht, s);
+    for(size_t idx = hash & mask;; idx = (idx + 1) & mask) {
+        HashtableElement *e = slots->elems + idx;
+        assert(e->dist != 0);
 
-        if(cols < col_tolerance) {
-            log_debug("Optimal size for %p is %"PRIuMAX" (%i collisions)", (void*)ht, (uintmax_t)s, cols);
-            return s;
+        if(e->index == index) {
+            return e;
         }
+    }
+}
+
+static void hashtable_remove_internal(Hashtable *ht, HashtableSlots *slots, HashtableElement *e) {
+    size_t mask = slots->size - 1;
+    size_t idx = e - slots->elems;
+    uint32_t hole = e->index;
+    uint32_t last = ht->num_elements - 1;
 
-        if(cols < min_cols) {
-            min_cols = cols;
-            best_size = s;
+    if(hole != last) {
+        // keep the entries dense: move the last one into the hole, and repoint its slot
+        HashtableEntry *moved = slots->entries + last;
+        hashtable_find_index(slots, moved->hash, last)->index = hole;
+        slots->entries[hole] = *moved;
+    }
+
+    for(;;) {
+        HashtableElement *next = slots->elems + ((idx + 1) & mask);
+
+        if(next->dist <= 1) {
+            break;
         }
+
+        slots->elems[idx] = *next;
+        --slots->elems[idx].dist;
+        idx = (idx + 1) & mask;
     }
 
-    log_debug("Optimal size for %p is %"PRIuMAX" (%i collisions)", (void*)ht, (uintmax_t)best_size, min_cols);
-    return best_size;
+    // the stale entry past the end stays as it was; a concurrent reader may still compare against it
+    slots->elems[idx].dist = 0;
+    ht->num_elements--;
 }
 
 static void hashtable_resize_internal(Hashtable *ht, size_t new_size) {
+    HashtableSlots *slots = hashtable_slots(ht);
     new_size = constraint_size(new_size);
 
-    if(new_size == ht->table_size) {
+    if(new_size == slots->size || hashtable_capacity(new_size) < ht->num_elements) {
         return;
     }
 
-    HashtableElement **new_table = calloc(new_size, sizeof(HashtableElement*));
+    HashtableSlots *new_slots = hashtable_alloc_slots(new_size);
+    memcpy(new_slots->entries, slots->entries, ht->num_elements * sizeof(HashtableEntry));
 
-    for(size_t i = 0; i < ht->table_size; ++i) {
-        for(HashtableElement *e = ht->table[i]; e; e = e->next) {
-            hashtable_set_internal(ht, new_table, new_size, e->hash, e->key, e->data);
-        }
+    for(uint32_t i = 0; i < ht->num_elements; ++i) {
+        hashtable_insert_internal(new_slots, (HashtableElement) { .hash = new_slots->entries[i].hash, .index = i });
     }
 
-    hashtable_unset_all_internal(ht);
-    free(ht->table);
-
-    ht->table = new_table;
+    SDL_AtomicSetPtr(&ht->slots, new_slots);
+    hashtable_retire(ht, slots, free);
 
     log_debug("Resized hashtable at %p: %"PRIuMAX" -> %"PRIuMAX"",
-        (void*)ht, (uintmax_t)ht->table_size, (uintmax_t)new_size);
-
-    ht->table_size = new_size;
+        (void*)ht, (uintmax_t)slots->size, (uintmax_t)new_size);
 }
 
 void hashtable_resize(Hashtable *ht, size_t new_size) {
-    hashtable_enter_state(ht, HT_OP_WRITE, true);
+    SDL_LockMutex(ht->mutex);
     hashtable_resize_internal(ht, new_size);
-    hashtable_idle_state(ht);
+    hashtable_reclaim(ht);
+    SDL_UnlockMutex(ht->mutex);
 }
 
 void hashtable_set(Hashtable *ht, void *key, void *data) {
@@ -344,14 +448,46 @@ void hashtable_set(Hashtable *ht, void *key, void *data) {
 
     hash_t hash = ht->hash_func(key);
 
-    hashtable_enter_state(ht, HT_OP_WRITE, true);
-    bool update = hashtable_set_internal(ht, ht->table, ht->table_size, hash, key, data);
+    SDL_LockMutex(ht->mutex);
+    HashtableSlots *slots = hashtable_slots(ht);
+    HashtableElement *e = hashtable_find(ht, slots, hash, key, false);
 
-    if(ht->dynamic_size && update) {
-        hashtable_resize_internal(ht, hashtable_find_optimal_size(ht));
+    if(e) {
+        hashtable_write_begin(slots);
+
+        if(data) {
+            slots->entries[e->index].data = data;
+        } else {
+            if(ht->free_func) {
+                hashtable_retire(ht, slots->entries[e->index].key, ht->free_func);
+            }
+
+            hashtable_remove_internal(ht, slots, e);
+        }
+
+        hashtable_write_end(slots);
+    } else if(data) {
+        if(ht->num_elements + 1 > hashtable_capacity(slots->size)) {
+            hashtable_resize_internal(ht, slots->size << 1);
+            slots = hashtable_slots(ht);
+        }
+
+        // no slot refers to this entry yet, so readers can't see it until it's inserted below
+        uint32_t index = ht->num_elements;
+        HashtableEntry *entry = slots->entries + index;
+        ht->copy_func(&entry->key, key);
+        entry->data = data;
+        entry->hash = hash;
+
+        hashtable_write_begin(slots);
+        hashtable_insert_internal(slots, (HashtableElement) { .hash = hash, .index = index });
+        hashtable_write_end(slots);
+
+        ht->num_elements++;
     }
 
-    hashtable_idle_state(ht);
+    hashtable_reclaim(ht);
+    SDL_UnlockMutex(ht->mutex);
 }
 
 void hashtable_unset(Hashtable *ht, void *key) {
@@ -389,60 +525,63 @@ void* hashtable_foreach(Hashtable *ht, HTIterCallback callback, void *arg) {
 
     void *ret = NULL;
 
-    hashtable_enter_state(ht, HT_OP_READ, false);
+    // the writer lock keeps the entries (and keys) from changing under the callback; readers aren't affected
+    SDL_LockMutex(ht->mutex);
+    HashtableSlots *slots = hashtable_slots(ht);
 
-    for(size_t i = 0; i < ht->table_size; ++i) {
-        for(HashtableElement *e = ht->table[i]; e; e = e->next) {
-            ret = callback(e->key, e->data, arg);
-            if(ret) {
-                return ret;
-            }
-        }
+    for(size_t i = 0; i < ht->num_elements && !ret; ++i) {
+        ret = callback(slots->entries[i].key, slots->entries[i].data, arg);
     }
 
-    hashtable_idle_state(ht);
+    SDL_UnlockMutex(ht->mutex);
 
     return ret;
 }
 
-HashtableIterator* hashtable_iter(Hashtable *ht) {
+void hashtable_iter_init(Hashtable *ht, HashtableIterator *iter) {
     assert(ht != NULL);
-    HashtableIterator *iter = malloc(sizeof(HashtableIterator));
     iter->hashtable = ht;
-    iter->bucketnum = (size_t)-1;
+    iter->index = 0;
+    iter->heap_allocated = false;
+}
+
+HashtableIterator* hashtable_iter(Hashtable *ht) {
+    HashtableIterator *iter = malloc(sizeof(HashtableIterator));
+    hashtable_iter_init(ht, iter);
+    iter->heap_allocated = true;
     return iter;
 }
 
 bool hashtable_iter_next(HashtableIterator *iter, void **out_key, void **out_data) {
     Hashtable *ht = iter->hashtable;
 
-    if(iter->bucketnum == (size_t)-1) {
-        iter->bucketnum = 0;
-        iter->elem = ht->table[iter->bucketnum];
-    } else {
-        iter->elem = iter->elem->next;
-    }
-
-    while(!iter->elem) {
-        if(++iter->bucketnum == ht->table_size) {
+    if(iter->index >= ht->num_elements) {
+        if(iter->heap_allocated) {
             free(iter);
-            return false;
         }
 
-        iter->elem = ht->table[iter->bucketnum];
+        return false;
     }
 
+    HashtableEntry *e = hashtable_slots(ht)->entries + iter->index++;
+
     if(out_key) {
-        *out_key = iter->elem->key;
+        *out_key = e->key;
     }
 
     if(out_data) {
-        *out_data = iter->elem->data;
+        *out_data = e->data;
     }
 
     return true;
 }
 
+HashtableEntry* hashtable_entries(Hashtable *ht, size_t *num_entries) {
+    assert(ht != NULL);
+    *num_entries = ht->num_elements;
+    return hashtable_slots(ht)->entries;
+}
+
 /*
  *  Convenience functions for hashtables with string keys
  */
@@ -466,15 +605,42 @@ void hashtable_copyfunc_string(void **dst, void *src) {
 
 // #define hashtable_freefunc_string free
 
+void hashtable_copyfunc_interned(void **dst, void *src) {
+    *dst = (void*)intern_string(src)->str;
+}
+
+HTHashFunc hashtable_get_string_hashfunc(void) {
+    static HTHashFunc func;
+
+    if(!func) {
+        func = SDL_HasSSE42() ? hashtable_hashfunc_string_sse42 : hashtable_hashfunc_string;
+    }
+
+    return func;
+}
+
 Hashtable* hashtable_new_stringkeys(size_t size) {
     return hashtable_new(size,
         hashtable_cmpfunc_string,
-        SDL_HasSSE42() ? hashtable_hashfunc_string_sse42 : hashtable_hashfunc_string,
+        hashtable_get_string_hashfunc(),
         hashtable_copyfunc_string,
         hashtable_freefunc_string
     );
 }
 
+Hashtable* hashtable_new_internedkeys(size_t size) {
+    // keys are interned on insertion, and live as long as the intern table does
+    Hashtable *ht = hashtable_new(size,
+        hashtable_cmpfunc_string,
+        hashtable_get_string_hashfunc(),
+        hashtable_copyfunc_interned,
+        NULL
+    );
+
+    ht->interned_keys = true;
+    return ht;
+}
+
 void* hashtable_get_string(Hashtable *ht, const char *key) {
     return hashtable_get(ht, (void*)key);
 }
@@ -513,52 +679,50 @@ void hashtable_get_stats(Hashtable *ht, HashtableStats *stats) {
     assert(stats != NULL);
 
     memset(stats, 0, sizeof(HashtableStats));
+    HashtableSlots *slots = hashtable_slots(ht);
 
-    for(size_t i = 0; i < ht->table_size; ++i) {
-        int elems = 0;
+    for(size_t i = 0; i < slots->size; ++i) {
+        HashtableElement *e = slots->elems + i;
 
-        for(HashtableElement *e = ht->table[i]; e; e = e->next) {
-            ++elems;
-            ++stats->num_elements;
+        if(!e->dist) {
+            ++stats->free_buckets;
+            continue;
         }
 
-        if(elems > 1) {
-            stats->collisions += elems - 1;
+        ++stats->num_elements;
+
+        if(e->dist > 1) {
+            ++stats->collisions;
         }
 
-        if(!elems) {
-            ++stats->free_buckets;
-        } else if(elems > stats->max_per_bucket) {
-            stats->max_per_bucket = elems;
+        if(e->dist > stats->max_probe_length) {
+            stats->max_probe_length = e->dist;
         }
     }
 }
 
 size_t hashtable_get_approx_overhead(Hashtable *ht) {
-    size_t o = sizeof(Hashtable) + sizeof(HashtableElement*) * ht->table_size;
-
-    for(HashtableIterator *i = hashtable_iter(ht); hashtable_iter_next(i, NULL, NULL);) {
-        o += sizeof(HashtableElement);
-    }
-
-    return o;
+    size_t size = hashtable_slots(ht)->size;
+    return sizeof(Hashtable) + sizeof(HashtableSlots) + sizeof(HashtableElement) * size + sizeof(HashtableEntry) * hashtable_capacity(size);
 }
 
 void hashtable_print_stringkeys(Hashtable *ht) {
     HashtableStats stats;
     hashtable_get_stats(ht, &stats);
+    HashtableSlots *slots = hashtable_slots(ht);
 
     log_debug("------ %p:", (void*)ht);
-    for(size_t i = 0; i < ht->table_size; ++i) {
-        log_debug("[bucket %"PRIuMAX"] %p", (uintmax_t)i, (void*)ht->table[i]);
+    for(size_t i = 0; i < slots->size; ++i) {
+        HashtableElement *e = slots->elems + i;
 
-        for(HashtableElement *e = ht->table[i]; e; e = e->next) {
-            log_debug(" -- %s (%"PRIuMAX"): %p", (char*)e->key, (uintmax_t)e->hash, e->data);
+        if(e->dist) {
+            HashtableEntry *entry = slots->entries + e->index;
+            log_debug("[slot %"PRIuMAX"] %s (%"PRIuMAX", probe length %u): %p", (uintmax_t)i, (char*)entry->key, (uintmax_t)e->hash, e->dist, entry->data);
         }
     }
 
-    log_debug("%i total elements, %i unused buckets, %i collisions, max %i elems per bucket, %lu approx overhead",
-            stats.num_elements, stats.free_buckets, stats.collisions, stats.max_per_bucket,
+    log_debug("%i total elements, %i unused slots, %i displaced elements, max probe length %i, %lu approx overhead",
+            stats.num_elements, stats.free_buckets, stats.collisions, stats.max_probe_length,
             (unsigned long int)hashtable_get_approx_overhead(ht));
 }
 
@@ -573,11 +737,241 @@ void hashtable_print_stringkeys(Hashtable *ht) {
 #include <stdio.h>
 
 static void hashtable_printstrings(Hashtable *ht) {
-    for(size_t i = 0; i < ht->table_size; ++i) {
-        for(HashtableElement *e = ht->table[i]; e; e = e->next) {
-            log_info("[HT %"PRIuMAX"] %s (%"PRIuMAX"): %s\n", (uintmax_t)i, (char*)e->key, (uintmax_t)e->hash, (char*)e->data);
+    size_t num;
+    HashtableEntry *entries = hashtable_entries(ht, &num);
+
+    for(size_t i = 0; i < num; ++i) {
+        log_info("[HT %"PRIuMAX"] %s (%"PRIuMAX"): %s\n", (uintmax_t)i, (char*)entries[i].key, (uintmax_t)entries[i].hash, (char*)entries[i].data);
+    }
+}
+
+static uint32_t hashtable_test_rand(uint32_t *state) {
+    // xorshift32; deterministic, and independent of the game's RNG state
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static hash_t hashtable_test_clustering_hash(void *key) {
+    // only 8 distinct hashes, all of which map to the very end of the table: long probe
+    // sequences that wrap around, and plenty of displacement for Robin Hood to sort out
+    return (hash_t)-1 - (crc32str(0, key) & 7);
+}
+
+static void* hashtable_test_value(int i) {
+    return (void*)(intptr_t)(i + 1);
+}
+
+static void hashtable_test_check(Hashtable *ht) {
+    HashtableSlots *slots = hashtable_slots(ht);
+    size_t mask = slots->size - 1;
+    size_t occupied = 0;
+    bool *referenced = calloc(hashtable_capacity(slots->size) + 1, sizeof(bool));
+
+    assert((slots->size & mask) == 0);
+    assert(ht->num_elements <= hashtable_capacity(slots->size));
+
+    for(size_t i = 0; i < slots->size; ++i) {
+        HashtableElement *e = slots->elems + i;
+        HashtableElement *next = slots->elems + ((i + 1) & mask);
+
+        // Robin Hood: the next element is never more than one step further from home than this one,
+        // which is also what lets removal stop shifting at the first element that's at home
+        assert(next->dist <= e->dist + 1);
+
+        if(!e->dist) {
+            continue;
         }
+
+        ++occupied;
+        assert(e->dist - 1 == ((i - (e->hash & mask)) & mask));
+        assert(e->index < ht->num_elements);
+        assert(!referenced[e->index]);
+        referenced[e->index] = true;
+        assert(slots->entries[e->index].hash == e->hash);
+        assert(ht->hash_func(slots->entries[e->index].key) == e->hash);
+    }
+
+    assert(occupied == ht->num_elements);
+    free(referenced);
+
+    for(size_t i = 0; i < ht->num_elements; ++i) {
+        assert(hashtable_get(ht, slots->entries[i].key) == slots->entries[i].data);
+    }
+}
+
+static void hashtable_test_model(HTHashFunc hash_func, int num_keys) {
+    // random inserts, updates and removals against a plain array, checking the invariants as we go
+    const int num_ops = 30000;
+
+    Hashtable *ht = hashtable_new(HT_DYNAMIC_SIZE, hashtable_cmpfunc_string, hash_func, hashtable_copyfunc_string, free);
+    size_t initial_size = hashtable_slots(ht)->size;
+    void **model = calloc(num_keys, sizeof(void*));
+    uint32_t rng = 0x5eed;
+    char key[32];
+
+    for(int op = 0; op < num_ops; ++op) {
+        int i = hashtable_test_rand(&rng) % num_keys;
+        snprintf(key, sizeof(key), "key%i", i);
+
+        if(hashtable_test_rand(&rng) % 3) {
+            model[i] = (void*)(intptr_t)(op + 1);
+            hashtable_set(ht, key, model[i]);
+        } else {
+            model[i] = NULL;
+            hashtable_unset(ht, key);
+        }
+
+        if(op % 97 == 0) {
+            hashtable_test_check(ht);
+        }
+
+        if(op % 5000 == 0) {
+            // shrink as far as it goes, then grow; the rebuilt slots must be just as valid
+            hashtable_resize(ht, hashtable_slots(ht)->size / 2);
+            hashtable_test_check(ht);
+            hashtable_resize(ht, ht->num_elements * HT_MAX_LOAD_DEN / HT_MAX_LOAD_NUM + 1);
+            hashtable_test_check(ht);
+            hashtable_resize(ht, ht->num_elements * 8);
+            hashtable_test_check(ht);
+        }
+    }
+
+    hashtable_test_check(ht);
+    assert(hashtable_slots(ht)->size > initial_size);
+
+    for(int i = 0; i < num_keys; ++i) {
+        snprintf(key, sizeof(key), "key%i", i);
+        assert(hashtable_get(ht, key) == model[i]);
+    }
+
+    free(model);
+    hashtable_free(ht);
+}
+
+static void hashtable_test_dense_removal(void) {
+    // removing anything but the last entry moves the last one into the hole
+    Hashtable *ht = hashtable_new_stringkeys(HT_DYNAMIC_SIZE);
+    size_t num;
+
+    hashtable_set_string(ht, "a", hashtable_test_value(0));
+    hashtable_set_string(ht, "b", hashtable_test_value(1));
+    hashtable_set_string(ht, "c", hashtable_test_value(2));
+    hashtable_set_string(ht, "d", hashtable_test_value(3));
+
+    hashtable_unset_string(ht, "b");
+    HashtableEntry *entries = hashtable_entries(ht, &num);
+    assert(num == 3);
+    assert(!strcmp(entries[0].key, "a"));
+    assert(!strcmp(entries[1].key, "d"));
+    assert(!strcmp(entries[2].key, "c"));
+    hashtable_test_check(ht);
+
+    hashtable_unset_string(ht, "c");
+    entries = hashtable_entries(ht, &num);
+    assert(num == 2);
+    assert(!strcmp(entries[0].key, "a"));
+    assert(!strcmp(entries[1].key, "d"));
+    assert(hashtable_get_string(ht, "d") == hashtable_test_value(3));
+    assert(hashtable_get_string(ht, "b") == NULL);
+    hashtable_test_check(ht);
+
+    hashtable_free(ht);
+}
+
+enum {
+    HT_TEST_STABLE_KEYS = 256,
+    HT_TEST_VOLATILE_KEYS = 2048,
+    HT_TEST_WRITER_ROUNDS = 64,
+    HT_TEST_READERS = 4,
+};
+
+typedef struct HashtableTestShared {
+    Hashtable *ht;
+    SDL_atomic_t done;
+    SDL_atomic_t errors;
+    SDL_atomic_t lookups;
+    SDL_atomic_t seed;
+} HashtableTestShared;
+
+static int hashtable_test_reader(void *arg) {
+    HashtableTestShared *shared = arg;
+    uint32_t rng = 0xacce55 + SDL_AtomicIncRef(&shared->seed);
+    char key[32];
+
+    while(!SDL_AtomicGet(&shared->done)) {
+        int i = hashtable_test_rand(&rng) % HT_TEST_STABLE_KEYS;
+        snprintf(key, sizeof(key), "stable%i", i);
+
+        if(hashtable_get(shared->ht, key) != hashtable_test_value(i)) {
+            SDL_AtomicIncRef(&shared->errors);
+        }
+
+        // these come and go, but must never resolve to anything but their own value
+        i = hashtable_test_rand(&rng) % HT_TEST_VOLATILE_KEYS;
+        snprintf(key, sizeof(key), "volatile%i", i);
+        void *data = hashtable_get(shared->ht, key);
+
+        if(data && data != hashtable_test_value(i)) {
+            SDL_AtomicIncRef(&shared->errors);
+        }
+
+        SDL_AtomicIncRef(&shared->lookups);
     }
+
+    return 0;
+}
+
+static void hashtable_test_concurrent(void) {
+    HashtableTestShared shared = { .ht = hashtable_new_stringkeys(HT_DYNAMIC_SIZE) };
+    SDL_Thread *readers[HT_TEST_READERS];
+    uint32_t rng = 0x3117e5;
+    char key[32];
+
+    for(int i = 0; i < HT_TEST_STABLE_KEYS; ++i) {
+        snprintf(key, sizeof(key), "stable%i", i);
+        hashtable_set_string(shared.ht, key, hashtable_test_value(i));
+    }
+
+    for(int i = 0; i < HT_TEST_READERS; ++i) {
+        readers[i] = SDL_CreateThread(hashtable_test_reader, "hashtable test", &shared);
+        assert(readers[i] != NULL);
+    }
+
+    // every round grows the table well past its size, then empties and shrinks it again,
+    // so the readers see in-place shifts, entry moves and slot array swaps alike
+    for(int round = 0; round < HT_TEST_WRITER_ROUNDS; ++round) {
+        for(int i = 0; i < HT_TEST_VOLATILE_KEYS; ++i) {
+            snprintf(key, sizeof(key), "volatile%i", i);
+            hashtable_set_string(shared.ht, key, hashtable_test_value(i));
+        }
+
+        for(int i = 0; i < HT_TEST_VOLATILE_KEYS; ++i) {
+            snprintf(key, sizeof(key), "volatile%i", hashtable_test_rand(&rng) % HT_TEST_VOLATILE_KEYS);
+            hashtable_unset_string(shared.ht, key);
+        }
+
+        for(int i = 0; i < HT_TEST_VOLATILE_KEYS; ++i) {
+            snprintf(key, sizeof(key), "volatile%i", i);
+            hashtable_unset_string(shared.ht, key);
+        }
+
+        hashtable_resize(shared.ht, HT_MIN_SIZE);
+    }
+
+    SDL_AtomicSet(&shared.done, 1);
+
+    for(int i = 0; i < HT_TEST_READERS; ++i) {
+        SDL_WaitThread(readers[i], NULL);
+    }
+
+    log_info("%i concurrent lookups, %i errors", SDL_AtomicGet(&shared.lookups), SDL_AtomicGet(&shared.errors));
+    assert(SDL_AtomicGet(&shared.errors) == 0);
+
+    hashtable_test_check(shared.ht);
+    assert(shared.ht->num_elements == HT_TEST_STABLE_KEYS);
+    hashtable_free(shared.ht);
 }
 
 #endif
@@ -606,6 +1000,13 @@ int hashtable_test(void) {
     hashtable_printstrings(ht);
 
     hashtable_free(ht);
+
+    hashtable_test_model(hashtable_hashfunc_string, 1500);
+    hashtable_test_model(hashtable_test_clustering_hash, 200);
+    hashtable_test_dense_removal();
+    hashtable_test_concurrent();
+
+    log_info("Hashtable tests passed");
     return 1;
 #else
     return 0;
@@ -14,21 +14,19 @@
 
 #include "list.h"
 
-#define HT_MIN_SIZE 15
-#define HT_MAX_SIZE 4095
-#define HT_COLLISION_TOLERANCE 5
+// Tables grow as needed; the size passed to hashtable_new() is just the expected number of elements
+#define HT_MIN_SIZE 16
 #define HT_DYNAMIC_SIZE 0
-#define HT_RESIZE_STEP 1
 
 typedef struct Hashtable Hashtable;
-typedef struct HashtableIterator HashtableIterator;
 typedef struct HashtableStats HashtableStats;
 typedef uint32_t hash_t;
+typedef struct InternedString InternedString;
 
 struct HashtableStats {
     unsigned int free_buckets;
-    unsigned int collisions;
-    unsigned int max_per_bucket;
+    unsigned int collisions;        // elements not in their ideal slot
+    unsigned int max_probe_length;
     unsigned int num_elements;
 };
 
@@ -38,10 +36,23 @@ typedef void (*HTCopyFunc)(void **dstkey, void *srckey);
 typedef void (*HTFreeFunc)(void *key);
 typedef void* (*HTIterCallback)(void *key, void *data, void *arg);
 
+typedef struct HashtableEntry {
+    void *key;
+    void *data;
+    hash_t hash;
+} HashtableEntry;
+
+typedef struct HashtableIterator {
+    Hashtable *hashtable;
+    size_t index;
+    bool heap_allocated;
+} HashtableIterator;
+
 Hashtable* hashtable_new(size_t size, HTCmpFunc cmp_func, HTHashFunc hash_func, HTCopyFunc copy_func, HTFreeFunc free_func);
 void hashtable_free(Hashtable *ht);
 void* hashtable_get(Hashtable *ht, void *key) __attribute__((hot));
-void* hashtable_get_unsafe(Hashtable *ht, void *key) __attribute__((hot));
+// Works on any string-keyed table; on tables from hashtable_new_internedkeys() this is just a pointer comparison
+void* hashtable_get_interned(Hashtable *ht, const InternedString *key) __attribute__((hot));
 void hashtable_set(Hashtable *ht, void *key, void *data);
 void hashtable_unset(Hashtable *ht, void *key);
 void hashtable_unset_deferred(Hashtable *ht, void *key, ListContainer **list);
@@ -50,16 +61,27 @@ void hashtable_unset_all(Hashtable *ht);
 
 void* hashtable_foreach(Hashtable *ht, HTIterCallback callback, void *arg);
 
-// THIS IS NOT THREAD-SAFE. You have to use hashtable_lock/unlock to make it so.
+// Lookups are safe to do concurrently with writes. They take no lock, unless they keep running into
+// a write in progress; then they wait for the writer instead of spinning.
+// Iteration is NOT; hold hashtable_lock/unlock around it if the table may be modified meanwhile.
+// hashtable_iter_init() sets up a caller-owned iterator and allocates nothing; hashtable_iter() returns
+// one on the heap, which hashtable_iter_next() frees once it's exhausted.
+void hashtable_iter_init(Hashtable *ht, HashtableIterator *iter);
 HashtableIterator* hashtable_iter(Hashtable *ht);
 bool hashtable_iter_next(HashtableIterator *iter, void **out_key, void **out_data);
 
+// All entries, packed in an array; valid until the next modification of the table
+HashtableEntry* hashtable_entries(Hashtable *ht, size_t *num_entries);
+
 bool hashtable_cmpfunc_string(void *str1, void *str2) __attribute__((hot));
 hash_t hashtable_hashfunc_string(void *vstr) __attribute__((hot));
 hash_t hashtable_hashfunc_string_sse42(void *vstr) __attribute__((hot));
 void hashtable_copyfunc_string(void **dst, void *src);
+void hashtable_copyfunc_interned(void **dst, void *src);
 #define hashtable_freefunc_string free
+HTHashFunc hashtable_get_string_hashfunc(void);
 Hashtable* hashtable_new_stringkeys(size_t size);
+Hashtable* hashtable_new_internedkeys(size_t size);
 
 void* hashtable_get_string(Hashtable *ht, const char *key);
 void hashtable_set_string(Hashtable *ht, const char *key, void *data);
@@ -0,0 +1,78 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "intern.h"
+#include "util.h"
+
+static void *intern_table; // Hashtable*, created on first use
+
+static Hashtable* intern_get_table(void) {
+    Hashtable *ht = SDL_AtomicGetPtr(&intern_table);
+
+    if(ht) {
+        return ht;
+    }
+
+    // the key is the str member of the value itself, so the table doesn't need to own a copy
+    ht = hashtable_new(HT_DYNAMIC_SIZE, hashtable_cmpfunc_string, hashtable_get_string_hashfunc(), NULL, NULL);
+
+    if(!SDL_AtomicCASPtr(&intern_table, NULL, ht)) {
+        // someone beat us to it
+        hashtable_free(ht);
+        ht = SDL_AtomicGetPtr(&intern_table);
+    }
+
+    return ht;
+}
+
+const InternedString* intern_string(const char *str) {
+    assert(str != NULL);
+
+    Hashtable *ht = intern_get_table();
+    InternedString *is = hashtable_get(ht, (void*)str);
+
+    if(is) {
+        return is;
+    }
+
+    hashtable_lock(ht);
+
+    // check again, another thread may have interned it while we were waiting for the lock
+    if(!(is = hashtable_get(ht, (void*)str))) {
+        size_t len = strlen(str);
+        is = malloc(sizeof(InternedString) + len + 1);
+        memcpy(is->str, str, len + 1);
+        is->length = len;
+        is->hash = hashtable_get_string_hashfunc()(is->str);
+        hashtable_set(ht, is->str, is);
+    }
+
+    hashtable_unlock(ht);
+    return is;
+}
+
+const InternedString* intern_string_cached(void **cache, const char *str) {
+    const InternedString *is = SDL_AtomicGetPtr(cache);
+
+    if(!is) {
+        // threads racing here all get the same handle, so it doesn't matter whose store wins
+        is = intern_string(str);
+        SDL_AtomicSetPtr(cache, (void*)is);
+    }
+
+    return is;
+}
+
+void intern_shutdown(void) {
+    Hashtable *ht = SDL_AtomicSetPtr(&intern_table, NULL);
+
+    if(ht) {
+        hashtable_foreach(ht, hashtable_iter_free_data, NULL);
+        hashtable_free(ht);
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "hashtable.h"
+
+/*
+ *  Process-wide string interning.
+ *
+ *  Interning a string returns a handle that is unique to its contents and stays valid until
+ *  intern_shutdown(): two handles are equal if and only if the strings are. The hash is computed
+ *  once, with the same function string-keyed hashtables use, so looking a handle up in such a table
+ *  never has to rehash it, and tables created with hashtable_new_internedkeys() compare keys by
+ *  pointer alone.
+ *
+ *  Interned strings are never freed, so only intern things from a bounded set: resource names,
+ *  uniform names, config keys, and the like. Never arbitrary user-visible text.
+ */
+
+struct InternedString {
+    hash_t hash;
+    uint32_t length;
+    char str[];
+};
+
+/*
+ *  Interns a string literal the first time the expression is evaluated and keeps the handle in a
+ *  static local, so lookups by a constant name on hot paths (uniforms, textures, sounds) compare
+ *  pointers instead of hashing and strcmp'ing the name every time.
+ */
+#define INTERN_STATIC(literal) (__extension__ ({ \
+    static void *_intern_cache; \
+    intern_string_cached(&_intern_cache, "" literal); \
+}))
+
+const InternedString* intern_string(const char *str);
+const InternedString* intern_string_cached(void **cache, const char *str);
+void intern_shutdown(void);
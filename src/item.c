@@ -23,9 +23,11 @@ static Texture* item_tex(ItemType type) {
 		[BPoint]	= "items/bullet_point",
 	};
 
+	static void *interned[sizeof(map)/sizeof(char*)];
+
 	// int cast to silence a WTF warning
 	assert((int)type < sizeof(map)/sizeof(char*));
-	return get_tex(map[type]);
+	return get_tex_interned(intern_string_cached(&interned[type], map[type]));
 }
 
 static int item_prio(List *litem) {
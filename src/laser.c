@@ -61,7 +61,7 @@ void draw_laser_curve_instanced(Laser *l) {
 	float t;
 	int c;
 
-	Texture *tex = get_tex("part/lasercurve");
+	Texture *tex = get_tex_interned(INTERN_STATIC("part/lasercurve"));
 
 	float wq = ((float)tex->w)/tex->truew;
 	float hq = ((float)tex->h)/tex->trueh;
@@ -88,20 +88,20 @@ void draw_laser_curve_instanced(Laser *l) {
 
 	glUseProgram(l->shader->prog);
 	parse_color_array(l->color, clr);
-	glUniform4fv(uniloc(l->shader, "clr"), 1, clr);
+	glUniform4fv(uniloc_interned(l->shader, INTERN_STATIC("clr")), 1, clr);
 
-	glUniform2f(uniloc(l->shader, "pos"), creal(l->pos), cimag(l->pos));
-	glUniform2f(uniloc(l->shader, "a0"), creal(l->args[0]), cimag(l->args[0]));
-	glUniform2f(uniloc(l->shader, "a1"), creal(l->args[1]), cimag(l->args[1]));
-	glUniform2f(uniloc(l->shader, "a2"), creal(l->args[2]), cimag(l->args[2]));
-	glUniform2f(uniloc(l->shader, "a3"), creal(l->args[3]), cimag(l->args[3]));
+	glUniform2f(uniloc_interned(l->shader, INTERN_STATIC("pos")), creal(l->pos), cimag(l->pos));
+	glUniform2f(uniloc_interned(l->shader, INTERN_STATIC("a0")), creal(l->args[0]), cimag(l->args[0]));
+	glUniform2f(uniloc_interned(l->shader, INTERN_STATIC("a1")), creal(l->args[1]), cimag(l->args[1]));
+	glUniform2f(uniloc_interned(l->shader, INTERN_STATIC("a2")), creal(l->args[2]), cimag(l->args[2]));
+	glUniform2f(uniloc_interned(l->shader, INTERN_STATIC("a3")), creal(l->args[3]), cimag(l->args[3]));
 
-	glUniform1f(uniloc(l->shader, "timeshift"), t);
-	glUniform1f(uniloc(l->shader, "wq"), wq*l->width);
-	glUniform1f(uniloc(l->shader, "hq"), hq*l->width);
-	glUniform1f(uniloc(l->shader, "width_exponent"), l->width_exponent);
+	glUniform1f(uniloc_interned(l->shader, INTERN_STATIC("timeshift")), t);
+	glUniform1f(uniloc_interned(l->shader, INTERN_STATIC("wq")), wq*l->width);
+	glUniform1f(uniloc_interned(l->shader, INTERN_STATIC("hq")), hq*l->width);
+	glUniform1f(uniloc_interned(l->shader, INTERN_STATIC("width_exponent")), l->width_exponent);
 
-	glUniform1i(uniloc(l->shader, "span"), c*2);
+	glUniform1i(uniloc_interned(l->shader, INTERN_STATIC("span")), c*2);
 
 	glDrawArraysInstanced(GL_QUADS, 0, 4, c*2);
 
@@ -110,7 +110,7 @@ void draw_laser_curve_instanced(Laser *l) {
 }
 
 void draw_laser_curve(Laser *laser) {
-	Texture *tex = get_tex("part/lasercurve");
+	Texture *tex = get_tex_interned(INTERN_STATIC("part/lasercurve"));
 	complex last;
 
 	glBindTexture(GL_TEXTURE_2D, tex->gltex);
@@ -23,6 +23,21 @@
     #define LOG_EOL "\n"
 #endif
 
+/*
+ *  Messages are formatted on the calling thread and queued in a ring buffer, which a background
+ *  thread periodically writes out to the loggers. Queueing a message is lock-free: a producer
+ *  reserves space by bumping the head with a CAS, copies its message in, and then publishes it by
+ *  setting the record's size. The log thread consumes complete records in order from the tail,
+ *  zeroing them behind itself so that a reserved but unpublished record always reads as size 0.
+ *
+ *  A record never wraps around the end of the buffer; if it doesn't fit, the producer reserves the
+ *  remainder as well and marks it as padding.
+ */
+
+#define LOG_STACK_BUFFER_SIZE 1024
+#define LOG_RECORD_ALIGN 8
+#define LOG_RECORD_ALIGN_UP(x) (((x) + LOG_RECORD_ALIGN - 1) & ~(uint32_t)(LOG_RECORD_ALIGN - 1))
+
 typedef struct Logger {
     struct Logger *next;
     struct Logger *prev;
@@ -30,10 +45,29 @@ typedef struct Logger {
     unsigned int levels;
 } Logger;
 
+typedef struct LogRecord {
+    SDL_atomic_t size; // 0 until published; includes the header and alignment padding
+    LogLevel levels;   // LOG_NONE for padding at the end of the buffer
+    char text[];       // NUL-terminated
+} LogRecord;
+
+static_assert(sizeof(LogRecord) == LOG_RECORD_ALIGN, "LogRecord header must be exactly LOG_RECORD_ALIGN bytes");
+static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0, "LOG_BUFFER_SIZE must be a power of two");
+
+static struct {
+    char *data;
+    SDL_atomic_t head; // next byte to reserve; both counters wrap around at 2^32
+    SDL_atomic_t tail; // next byte to write out
+    SDL_mutex *flush_mutex; // serializes consumers, guards the logger list
+    SDL_sem *wakeup;
+    SDL_Thread *thread;
+    SDL_atomic_t quit;
+} log_ring;
+
 static Logger *loggers = NULL;
 static unsigned int enabled_log_levels;
+static unsigned int output_log_levels;
 static unsigned int backtrace_log_levels;
-static SDL_mutex *log_mutex;
 
 // order must much the LogLevel enum after LOG_NONE
 static const char *level_prefix_map[] = { "D", "I", "W", "E" };
@@ -44,11 +78,38 @@ static const char* level_prefix(LogLevel lvl) {
     return level_prefix_map[idx];
 }
 
-static char* format_log_string(LogLevel lvl, const char *funcname, const char *fmt, va_list args, bool is_backtrace) {
+static size_t format_log_string(char **buf, size_t bufsize, LogLevel lvl, const char *funcname, const char *fmt, va_list args, bool is_backtrace) {
+    // formats into *buf if it fits, otherwise into a new heap buffer returned through it
     const char *pref = level_prefix(lvl);
-    char *msg = vstrfmt(fmt, args);
-    char *final = strfmt("%-9d %s: %s(): %s%s", SDL_GetTicks(), pref, funcname, msg, LOG_EOL);
-    free(msg);
+    char *stackbuf = *buf;
+    char *str = stackbuf;
+    int plen = snprintf(str, bufsize, "%-9d %s: %s(): ", SDL_GetTicks(), pref, funcname);
+
+    if(plen < 0 || plen >= bufsize - sizeof(LOG_EOL)) {
+        plen = bufsize - sizeof(LOG_EOL);
+    }
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    int mlen = vsnprintf(str + plen, bufsize - plen, fmt, args_copy);
+    va_end(args_copy);
+
+    if(mlen < 0) {
+        mlen = 0;
+        str[plen] = 0;
+    }
+
+    size_t len = plen + mlen;
+
+    if(len + sizeof(LOG_EOL) > bufsize) {
+        str = malloc(len + sizeof(LOG_EOL));
+        memcpy(str, stackbuf, plen);
+        vsnprintf(str + plen, mlen + 1, fmt, args);
+        *buf = str;
+    }
+
+    memcpy(str + len, LOG_EOL, sizeof(LOG_EOL));
+    len += sizeof(LOG_EOL) - 1;
 
     // TODO: maybe convert all \n in the message to LOG_EOL
 
@@ -57,23 +118,160 @@ static char* format_log_string(LogLevel lvl, const char *funcname, const char *f
         DebugInfo *debug_info = get_debug_info();
         DebugInfo *debug_meta = get_debug_meta();
 
-        msg = final;
-        final = strfmt(
+        char *final = strfmt(
             "%s%s%s"
             "Debug info: %s:%i:%s%s"
             "Debug info set at: %s:%i:%s%s"
             "Note: debug info may not be relevant to this issue%s",
-            msg, LOG_EOL, LOG_EOL,
+            str, LOG_EOL, LOG_EOL,
             debug_info->file, debug_info->line, debug_info->func, LOG_EOL,
             debug_meta->file, debug_meta->line, debug_meta->func, LOG_EOL,
             LOG_EOL
         );
 
-        free(msg);
+        if(str != stackbuf) {
+            free(str);
+        }
+
+        *buf = final;
+        len = strlen(final);
+    }
+#endif
+
+    return len;
+}
+
+static bool log_flush_internal(void) {
+    bool progress = false;
+    uint32_t mask = LOG_BUFFER_SIZE - 1;
+
+    SDL_LockMutex(log_ring.flush_mutex);
+
+    uint32_t tail = SDL_AtomicGet(&log_ring.tail);
+
+    while(tail != (uint32_t)SDL_AtomicGet(&log_ring.head)) {
+        LogRecord *rec = (LogRecord*)(log_ring.data + (tail & mask));
+        uint32_t size = SDL_AtomicGet(&rec->size);
+
+        if(!size) {
+            // reserved, but still being written
+            break;
+        }
+
+        SDL_MemoryBarrierAcquire();
+
+        if(rec->levels) {
+            size_t len = strlen(rec->text);
+
+            for(Logger *l = loggers; l; l = l->next) {
+                if(l->levels & rec->levels) {
+                    SDL_RWwrite(l->out, rec->text, 1, len);
+                }
+            }
+        }
+
+        memset(rec, 0, size);
+        tail += size;
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&log_ring.tail, tail);
+        progress = true;
+    }
+
+    SDL_UnlockMutex(log_ring.flush_mutex);
+    return progress;
+}
+
+void log_flush(void) {
+    if(log_ring.data) {
+        log_flush_internal();
+    }
+}
+
+static void log_submit(LogLevel lvl, const char *str, size_t len) {
+    uint32_t mask = LOG_BUFFER_SIZE - 1;
+    bool truncated = false;
+
+    if(len > LOG_BUFFER_SIZE / 4) {
+        // don't let a single huge message clog the whole buffer
+        len = LOG_BUFFER_SIZE / 4;
+        truncated = true;
+    }
+
+    uint32_t size = LOG_RECORD_ALIGN_UP(sizeof(LogRecord) + len + 1);
+    uint32_t head, pad;
+
+    while(true) {
+        head = SDL_AtomicGet(&log_ring.head);
+        uint32_t tail = SDL_AtomicGet(&log_ring.tail);
+        uint32_t offset = head & mask;
+        pad = (offset + size > LOG_BUFFER_SIZE) ? LOG_BUFFER_SIZE - offset : 0;
+
+        if(head + pad + size - tail > LOG_BUFFER_SIZE) {
+            // full; write some of it out ourselves rather than wait for the log thread
+            if(!log_flush_internal()) {
+                SDL_Delay(1);
+            }
+
+            continue;
+        }
+
+        if(SDL_AtomicCAS(&log_ring.head, head, head + pad + size)) {
+            break;
+        }
+    }
+
+    if(pad) {
+        LogRecord *prec = (LogRecord*)(log_ring.data + (head & mask));
+        prec->levels = LOG_NONE;
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&prec->size, pad);
+    }
+
+    LogRecord *rec = (LogRecord*)(log_ring.data + ((head + pad) & mask));
+    rec->levels = lvl;
+
+    if(truncated) {
+        // the cut removed the line terminator; put it back, or the next message would run onto this line
+        size_t eol_len = sizeof(LOG_EOL) - 1;
+        memcpy(rec->text, str, len - eol_len);
+        memcpy(rec->text + len - eol_len, LOG_EOL, eol_len);
+    } else {
+        memcpy(rec->text, str, len);
+    }
+
+    rec->text[len] = 0;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&rec->size, size);
+
+    if(!log_ring.thread) {
+        log_flush_internal();
+    } else if(lvl & LOG_ALERT) {
+        SDL_SemPost(log_ring.wakeup);
+    }
+}
+
+static int log_thread(void *arg) {
+    while(!SDL_AtomicGet(&log_ring.quit)) {
+        SDL_SemWaitTimeout(log_ring.wakeup, LOG_FLUSH_INTERVAL);
+        log_flush_internal();
+    }
+
+    return 0;
+}
+
+static void* delete_logger(List **loggers, List *logger, void *arg) {
+    Logger *l = (Logger*)logger;
+
+#if HAVE_STDIO_H
+    if(l->out->type == SDL_RWOPS_STDFILE) {
+        fflush(l->out->hidden.stdio.fp);
     }
 #endif
 
-    return final;
+    SDL_RWclose(l->out);
+    free(list_unlink(loggers, logger));
+
+    return NULL;
 }
 
 noreturn static void log_abort(const char *msg) {
@@ -83,54 +281,50 @@ noreturn static void log_abort(const char *msg) {
     }
 #endif
 
+    // write out everything queued so far, including the fatal message itself, and close the outputs.
+    // the log thread and other producers may still be running, so don't tear down the buffer.
+    if(log_ring.data) {
+        SDL_LockMutex(log_ring.flush_mutex);
+        log_flush_internal();
+        list_foreach((List**)&loggers, delete_logger, NULL);
+        output_log_levels = 0;
+    }
+
     // abort() doesn't clean up, but it lets us get a backtrace, which is more useful
-    log_shutdown();
     abort();
 }
 
 static void log_internal(LogLevel lvl, bool is_backtrace, const char *funcname, const char *fmt, va_list args) {
     assert(fmt[strlen(fmt)-1] != '\n');
 
-    char *str = NULL;
-    size_t slen = 0;
     lvl &= enabled_log_levels;
 
     if(lvl == LOG_NONE) {
         return;
     }
 
-    for(Logger *l = loggers; l; l = l->next) {
-        if(l->levels & lvl) {
-            if(!str) {
-                str = format_log_string(lvl, funcname, fmt, args, is_backtrace);
-                slen = strlen(str);
-            }
+    char buf[LOG_STACK_BUFFER_SIZE];
+    char *str = NULL;
 
-            // log_backtrace locks the mutex by itself, then recursively calls log_internal
-            if(is_backtrace) {
-                SDL_RWwrite(l->out, str, 1, slen);
-            } else {
-                SDL_LockMutex(log_mutex);
-                SDL_RWwrite(l->out, str, 1, slen);
-                SDL_UnlockMutex(log_mutex);
-            }
-        }
+    if(log_ring.data && (lvl & output_log_levels)) {
+        str = buf;
+        size_t slen = format_log_string(&str, sizeof(buf), lvl, funcname, fmt, args, is_backtrace);
+        log_submit(lvl, str, slen);
     }
 
-    if(is_backtrace) {
-        free(str);
-        return;
-    }
+    if(!is_backtrace) {
+        if(lvl & backtrace_log_levels) {
+            log_backtrace(lvl);
+        }
 
-    if(lvl & backtrace_log_levels) {
-        log_backtrace(lvl);
+        if(lvl & LOG_FATAL) {
+            log_abort(str);
+        }
     }
 
-    if(lvl & LOG_FATAL) {
-        log_abort(str);
+    if(str != buf) {
+        free(str);
     }
-
-    free(str);
 }
 
 static char** get_backtrace(int *num) {
@@ -146,20 +340,44 @@ static char** get_backtrace(int *num) {
 #endif
 }
 
+static void log_backtrace_line(LogLevel lvl, char **bt, const char *fmt, ...) {
+    char buf[LOG_STACK_BUFFER_SIZE];
+    char *str = buf;
+
+    va_list args;
+    va_start(args, fmt);
+    format_log_string(&str, sizeof(buf), lvl, "log_backtrace", fmt, args, true);
+    va_end(args);
+
+    strappend(bt, str);
+
+    if(str != buf) {
+        free(str);
+    }
+}
+
 void log_backtrace(LogLevel lvl) {
+    lvl &= enabled_log_levels;
+
+    if(!log_ring.data || !(lvl & output_log_levels)) {
+        return;
+    }
+
     int num = LOG_BACKTRACE_SIZE;
     char **symbols = get_backtrace(&num);
+    char *bt = NULL;
 
-    SDL_LockMutex(log_mutex);
-    _taisei_log(lvl, true, __func__, "*** BACKTRACE ***");
+    // queue it as a single message, so that it doesn't get interleaved with other threads' output
+    log_backtrace_line(lvl, &bt, "*** BACKTRACE ***");
 
     for(int i = 0; i < num; ++i) {
-        _taisei_log(lvl, true, __func__, "> %s", symbols[i]);
+        log_backtrace_line(lvl, &bt, "> %s", symbols[i]);
     }
 
-    _taisei_log(lvl, true, __func__, "*** END OF BACKTRACE ***");
-    SDL_UnlockMutex(log_mutex);
+    log_backtrace_line(lvl, &bt, "*** END OF BACKTRACE ***");
+    log_submit(lvl, bt, strlen(bt));
 
+    free(bt);
     free(symbols);
 }
 
@@ -181,35 +399,43 @@ noreturn void _taisei_log_fatal(LogLevel lvl, const char *funcname, const char *
     log_abort(NULL);
 }
 
-static void* delete_logger(List **loggers, List *logger, void *arg) {
-    Logger *l = (Logger*)logger;
-
-#if HAVE_STDIO_H
-    if(l->out->type == SDL_RWOPS_STDFILE) {
-        fflush(l->out->hidden.stdio.fp);
-    }
-#endif
-
-    SDL_RWclose(l->out);
-    free(list_unlink(loggers, logger));
-
-    return NULL;
-}
-
 void log_init(LogLevel lvls, LogLevel backtrace_lvls) {
     enabled_log_levels = lvls;
     backtrace_log_levels = lvls & backtrace_lvls;
-    log_mutex = SDL_CreateMutex();
+
+    log_ring.data = calloc(1, LOG_BUFFER_SIZE);
+    SDL_AtomicSet(&log_ring.head, 0);
+    SDL_AtomicSet(&log_ring.tail, 0);
+    SDL_AtomicSet(&log_ring.quit, 0);
+    log_ring.flush_mutex = SDL_CreateMutex();
+    log_ring.wakeup = SDL_CreateSemaphore(0);
+    log_ring.thread = SDL_CreateThread(log_thread, "log", NULL);
+    // if this failed, log_submit() just writes everything out immediately
 }
 
 void log_shutdown(void) {
+    if(!log_ring.data) {
+        return;
+    }
+
+    if(log_ring.thread) {
+        SDL_AtomicSet(&log_ring.quit, 1);
+        SDL_SemPost(log_ring.wakeup);
+        SDL_WaitThread(log_ring.thread, NULL);
+    }
+
+    log_flush_internal();
     list_foreach((List**)&loggers, delete_logger, NULL);
-    SDL_DestroyMutex(log_mutex);
-    log_mutex = NULL;
+    output_log_levels = 0;
+
+    SDL_DestroySemaphore(log_ring.wakeup);
+    SDL_DestroyMutex(log_ring.flush_mutex);
+    free(log_ring.data);
+    memset(&log_ring, 0, sizeof(log_ring));
 }
 
 bool log_initialized(void) {
-    return log_mutex;
+    return log_ring.data;
 }
 
 void log_add_output(LogLevel levels, SDL_RWops *output) {
@@ -217,14 +443,17 @@ void log_add_output(LogLevel levels, SDL_RWops *output) {
         return;
     }
 
-    if(!(levels & enabled_log_levels)) {
+    if(!(levels & enabled_log_levels) || !log_ring.data) {
         SDL_RWclose(output);
         return;
     }
 
+    SDL_LockMutex(log_ring.flush_mutex);
     Logger *l = (Logger*)list_append((List**)&loggers, malloc(sizeof(Logger)));
     l->levels = levels;
     l->out = output;
+    output_log_levels |= levels;
+    SDL_UnlockMutex(log_ring.flush_mutex);
 }
 
 static LogLevel chr2lvl(char c) {
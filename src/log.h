@@ -62,8 +62,25 @@ typedef enum LogLevel {
     #define LOG_BACKTRACE_SIZE 32
 #endif
 
+// Levels not in this mask are compiled out, arguments and all. log_fatal is never compiled out.
+#ifndef LOG_COMPILED_LEVELS
+    #define LOG_COMPILED_LEVELS LOG_ALL
+#endif
+
+// Size of the ring buffer messages are queued in until the log thread writes them out. Must be a power of two.
+#ifndef LOG_BUFFER_SIZE
+    #define LOG_BUFFER_SIZE (1 << 18)
+#endif
+
+// How often the log thread wakes up to write out queued messages, in milliseconds.
+// Warnings and errors wake it up immediately.
+#ifndef LOG_FLUSH_INTERVAL
+    #define LOG_FLUSH_INTERVAL 50
+#endif
+
 void log_init(LogLevel lvls, LogLevel backtrace_lvls);
 void log_shutdown(void);
+void log_flush(void);
 void log_add_output(LogLevel levels, SDL_RWops *output);
 void log_backtrace(LogLevel lvl);
 LogLevel log_parse_levels(LogLevel lvls, const char *lvlmod);
@@ -77,16 +94,19 @@ bool log_initialized(void);
     #define LOG_PREFIX
 #endif
 
+#define LOG_IF_COMPILED(lvl, ...) \
+    ((LOG_COMPILED_LEVELS & (lvl)) ? _taisei_log((lvl), false, __func__, __VA_ARGS__) : (void)0)
+
 #ifdef DEBUG
-    #define log_debug(...) LOG_PREFIX _taisei_log(LOG_DEBUG, false, __func__, __VA_ARGS__)
+    #define log_debug(...) LOG_PREFIX LOG_IF_COMPILED(LOG_DEBUG, __VA_ARGS__)
 #else
     #define log_debug(...)
 #endif
 
-#define log_info(...) LOG_PREFIX _taisei_log(LOG_INFO, false, __func__, __VA_ARGS__)
-#define log_warn(...) LOG_PREFIX _taisei_log(LOG_WARN, false, __func__, __VA_ARGS__)
+#define log_info(...) LOG_PREFIX LOG_IF_COMPILED(LOG_INFO, __VA_ARGS__)
+#define log_warn(...) LOG_PREFIX LOG_IF_COMPILED(LOG_WARN, __VA_ARGS__)
 #define log_fatal(...) LOG_PREFIX _taisei_log_fatal(LOG_FATAL, __func__, __VA_ARGS__)
-#define log_custom(lvl, ...) LOG_PREFIX _taisei_log(lvl, false, __func__, __VA_ARGS__)
+#define log_custom(lvl, ...) LOG_PREFIX LOG_IF_COMPILED(lvl, __VA_ARGS__)
 
 //
 // don't call these directly, use the macros
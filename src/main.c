@@ -37,10 +37,13 @@ static void taisei_shutdown(void) {
 	video_shutdown();
 	gamepad_shutdown();
 	stage_free_array();
+	stage_objpools_free();
 	config_shutdown();
 	vfs_shutdown();
 	events_shutdown();
 	time_shutdown();
+	intern_shutdown();
+	memarena_global_shutdown();
 
 	log_info("Good bye");
 	SDL_Quit();
@@ -228,6 +231,14 @@ int main(int argc, char **argv) {
 		vfs_shutdown();
 		free_cli_action(&a);
 		return 0;
+	} else if(a.type == CLI_BenchTextures) {
+		vfs_setup(true);
+		time_init();
+		texture_benchmark();
+		time_shutdown();
+		vfs_shutdown();
+		free_cli_action(&a);
+		return 0;
 	}
 
 	free_cli_action(&a);
@@ -0,0 +1,159 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include <stdarg.h>
+#include <stdalign.h>
+
+#include "memarena.h"
+#include "util.h"
+
+#define ARENA_ALIGN alignof(max_align_t)
+#define ALIGN_UP(x) (((x) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+struct MemArenaPage {
+    MemArenaPage *next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) char data[];
+};
+
+MemArena frame_arena = MEMARENA_INITIALIZER(64 * 1024, "frame");
+MemArena stage_arena = MEMARENA_INITIALIZER(16 * 1024, "stage");
+
+void marena_init(MemArena *arena, size_t page_size, const char *tag) {
+    *arena = (MemArena)MEMARENA_INITIALIZER(page_size, tag);
+}
+
+void marena_deinit(MemArena *arena) {
+    for(MemArenaPage *p = arena->first, *next; p; p = next) {
+        next = p->next;
+        free(p);
+    }
+
+    marena_init(arena, arena->page_size, arena->tag);
+}
+
+static MemArenaPage* marena_new_page(MemArena *arena, size_t min_size) {
+    size_t size = arena->page_size > min_size ? arena->page_size : min_size;
+    MemArenaPage *page = malloc(sizeof(MemArenaPage) + size);
+    page->next = NULL;
+    page->size = size;
+    page->used = 0;
+
+    arena->num_pages++;
+    arena->total_size += size;
+
+    log_debug("[%s] Added a %zu bytes page (%zu bytes total)", arena->tag, size, arena->total_size);
+    return page;
+}
+
+void* marena_alloc(MemArena *arena, size_t size) {
+    size = ALIGN_UP(size ? size : 1);
+
+    MemArenaPage *page = arena->current;
+
+    if(!page) {
+        // first allocation ever, or after marena_deinit()
+        page = arena->first = arena->current = marena_new_page(arena, size);
+    }
+
+    while(page->used + size > page->size) {
+        // move on to the next page, which has been rewound past if it exists at all
+        if(!page->next) {
+            page->next = marena_new_page(arena, size);
+        }
+
+        page = arena->current = page->next;
+        page->used = 0;
+    }
+
+    void *ptr = page->data + page->used;
+    page->used += size;
+    return ptr;
+}
+
+void* marena_alloc_array(MemArena *arena, size_t num, size_t size) {
+    if(size && num > SIZE_MAX / size) {
+        log_fatal("[%s] Allocation of %zu elements of %zu bytes overflows", arena->tag, num, size);
+    }
+
+    return marena_alloc(arena, num * size);
+}
+
+char* marena_strdup(MemArena *arena, const char *str) {
+    size_t size = strlen(str) + 1;
+    return memcpy(marena_alloc(arena, size), str, size);
+}
+
+char* marena_strjoin(MemArena *arena, const char *first, ...) {
+    va_list args;
+    size_t size = strlen(first) + 1;
+
+    va_start(args, first);
+    for(const char *s; (s = va_arg(args, const char*));) {
+        size += strlen(s);
+    }
+    va_end(args);
+
+    char *str = marena_alloc(arena, size);
+    char *p = str;
+    size_t len = strlen(first);
+
+    memcpy(p, first, len);
+    p += len;
+
+    va_start(args, first);
+    for(const char *s; (s = va_arg(args, const char*));) {
+        len = strlen(s);
+        memcpy(p, s, len);
+        p += len;
+    }
+    va_end(args);
+
+    *p = 0;
+    return str;
+}
+
+MemArenaMark marena_mark(MemArena *arena) {
+    return (MemArenaMark) {
+        .page = arena->current,
+        .used = arena->current ? arena->current->used : 0,
+    };
+}
+
+void marena_rewind(MemArena *arena, MemArenaMark mark) {
+    MemArenaPage *page = mark.page ? mark.page : arena->first;
+
+    if(!page) {
+        return;
+    }
+
+#ifdef DEBUG
+    // make stale pointers into the rewound range fail loudly
+    for(MemArenaPage *p = page; p; p = p->next) {
+        size_t start = (p == page) ? mark.used : 0;
+        memset(p->data + start, 0xCD, p->used - start);
+
+        if(p == arena->current) {
+            break;
+        }
+    }
+#endif
+
+    page->used = mark.used;
+    arena->current = page;
+}
+
+void marena_reset(MemArena *arena) {
+    marena_rewind(arena, (MemArenaMark) { 0 });
+}
+
+void memarena_global_shutdown(void) {
+    marena_deinit(&frame_arena);
+    marena_deinit(&stage_arena);
+}
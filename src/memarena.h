@@ -0,0 +1,62 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+ *  Bump allocators for short-lived memory.
+ *
+ *  Allocating from an arena is a pointer increment; nothing is ever freed individually. Instead,
+ *  the arena is rewound to an earlier mark (or reset entirely), which releases everything allocated
+ *  since in one go. The pages backing an arena are kept around for reuse, so once an arena has grown
+ *  to its working size it stops touching the system allocator altogether.
+ *
+ *  Arenas are not thread-safe. The two global ones must only be used from the main thread.
+ */
+
+typedef struct MemArenaPage MemArenaPage;
+
+typedef struct MemArena {
+    MemArenaPage *first;
+    MemArenaPage *current;
+    size_t page_size;
+    size_t num_pages;
+    size_t total_size;
+    const char *tag;
+} MemArena;
+
+typedef struct MemArenaMark {
+    MemArenaPage *page;
+    size_t used;
+} MemArenaMark;
+
+#define MEMARENA_INITIALIZER(_page_size, _tag) { .page_size = (_page_size), .tag = (_tag) }
+
+void marena_init(MemArena *arena, size_t page_size, const char *tag);
+void marena_deinit(MemArena *arena);
+
+void* marena_alloc(MemArena *arena, size_t size) __attribute__((malloc, alloc_size(2)));
+void* marena_alloc_array(MemArena *arena, size_t num, size_t size) __attribute__((malloc, alloc_size(2, 3)));
+char* marena_strdup(MemArena *arena, const char *str) __attribute__((malloc));
+char* marena_strjoin(MemArena *arena, const char *first, ...) __attribute__((malloc, sentinel));
+
+MemArenaMark marena_mark(MemArena *arena);
+void marena_rewind(MemArena *arena, MemArenaMark mark);
+void marena_reset(MemArena *arena);
+
+// Scratch memory for the current frame. loop_at_fps() rewinds it before every frame; hot paths
+// should also rewind it themselves once they're done, so it never grows past a single call's needs.
+extern MemArena frame_arena;
+
+// Memory that lives until the current stage ends. Reset by stage_free().
+extern MemArena stage_arena;
+
+void memarena_global_shutdown(void);
@@ -71,6 +71,7 @@ static void start_game_internal(MenuData *menu, StageInfo *info, bool difficulty
         } else {
             global.is_practice_mode = false;
             for(StageInfo *s = stages; s->type == STAGE_STORY; ++s) {
+                stage_set_next(s[1].type == STAGE_STORY ? s + 1 : NULL);
                 stage_loop(s);
             }
         }
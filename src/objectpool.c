@@ -1,76 +1,192 @@
 
 #include "objectpool.h"
 #include "util.h"
-#include "list.h"
 
-#ifdef OBJPOOL_DEBUG
-    #define OBJ_USED(pool,obj) ((pool)->usemap[((uintptr_t)(obj) - (uintptr_t)(pool)->objects) / (pool)->size_of_object])
-#endif
+/*
+ *  Objects are carved out of chunks of chunk_size objects each. A pool starts out with no chunks
+ *  and grows one chunk at a time as needed; chunks never move, so pointers to live objects stay
+ *  valid for as long as the objects do. objpool_shrink() hands chunks that have no live objects
+ *  left back to the system.
+ *
+ *  Every chunk tracks its free slots in a bitmap, and objpool_acquire() always hands out the lowest
+ *  free slot of the oldest chunk that has one. Live objects thus stay packed at the front of the
+ *  pool even after heavy churn, instead of scattering all over it like they would with a LIFO free
+ *  list. Every object is preceded by a small header that locates it in its chunk, so releasing
+ *  an object is just a bit flip.
+ */
+
+#define OBJPOOL_ALIGN 16
+#define ALIGN_UP(x) (((x) + OBJPOOL_ALIGN - 1) & ~(size_t)(OBJPOOL_ALIGN - 1))
+#define BITS_PER_WORD 64
+
+typedef struct ObjectPoolChunk ObjectPoolChunk;
+
+typedef struct ObjectHeader {
+    ObjectPoolChunk *chunk;
+    size_t slot;
+} ObjectHeader;
+
+struct ObjectPoolChunk {
+    ObjectPool *pool;
+    char *slots;
+    size_t index;           // position in the pool's chunk array
+    size_t num_objects;
+    size_t usage;
+    size_t first_free_word; // no free slots before this word of the bitmap
+    uint64_t free_bits[];   // set bits are free slots
+};
 
 struct ObjectPool {
     char *tag;
     size_t size_of_object;
+    size_t size_of_slot;
+    size_t chunk_size;
     size_t max_objects;
+    size_t capacity;
     size_t usage;
     size_t peak_usage;
-    ObjectInterface *free_objects;
+    size_t peak_capacity;
+    size_t num_chunks;
+    size_t first_free_chunk; // all chunks before this one are full
+    ObjectPoolChunk **chunks; // oldest first
+    ObjectInitFunc init_func;
+};
 
-    IF_OBJPOOL_DEBUG(
-        bool *usemap;
-    )
+static inline size_t bitmap_words(size_t num_objects) {
+    return (num_objects + BITS_PER_WORD - 1) / BITS_PER_WORD;
+}
 
-    char objects[];
-};
+static inline ObjectHeader* obj_header(ObjectInterface *obj) {
+    return (ObjectHeader*)((char*)obj - ALIGN_UP(sizeof(ObjectHeader)));
+}
 
-static inline ObjectInterface* obj_ptr(ObjectPool *pool, size_t idx) {
-    return (ObjectInterface*)(pool->objects + idx * pool->size_of_object);
+static inline ObjectInterface* obj_ptr(ObjectPool *pool, ObjectPoolChunk *chunk, size_t idx) {
+    return (ObjectInterface*)(chunk->slots + idx * pool->size_of_slot + ALIGN_UP(sizeof(ObjectHeader)));
 }
 
-ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag) {
-    // TODO: overflow handling
+ObjectPool *objpool_alloc(size_t obj_size, size_t chunk_size, size_t max_objects, const char *tag) {
+    assert(chunk_size > 0);
 
-    ObjectPool *pool = malloc(sizeof(ObjectPool) + (obj_size * max_objects));
+    ObjectPool *pool = calloc(1, sizeof(ObjectPool));
     pool->size_of_object = obj_size;
+    pool->size_of_slot = ALIGN_UP(sizeof(ObjectHeader)) + ALIGN_UP(obj_size);
+    pool->chunk_size = chunk_size;
     pool->max_objects = max_objects;
-    pool->free_objects = NULL;
-    pool->usage = 0;
-    pool->peak_usage = 0;
     pool->tag = strdup(tag);
 
-    IF_OBJPOOL_DEBUG({
-        pool->usemap = calloc(max_objects, sizeof(bool));
-    })
+    log_debug("[%s] Allocated pool for %zu bytes objects, %zu per chunk, %zu max",
+        pool->tag,
+        pool->size_of_object,
+        pool->chunk_size,
+        pool->max_objects
+    );
+
+    return pool;
+}
+
+void objpool_set_init_func(ObjectPool *pool, ObjectInitFunc init_func) {
+    pool->init_func = init_func;
+}
+
+static ObjectPoolChunk* objpool_add_chunk(ObjectPool *pool) {
+    size_t num_objects = pool->chunk_size;
+
+    if(pool->max_objects) {
+        if(pool->capacity >= pool->max_objects) {
+            return NULL;
+        }
+
+        if(pool->capacity + num_objects > pool->max_objects) {
+            num_objects = pool->max_objects - pool->capacity;
+        }
+    }
+
+    size_t words = bitmap_words(num_objects);
+    size_t header_size = ALIGN_UP(sizeof(ObjectPoolChunk) + words * sizeof(uint64_t));
+    ObjectPoolChunk *chunk = malloc(header_size + num_objects * pool->size_of_slot);
+
+    chunk->pool = pool;
+    chunk->slots = (char*)chunk + header_size;
+    chunk->index = pool->num_chunks;
+    chunk->num_objects = num_objects;
+    chunk->usage = 0;
+    chunk->first_free_word = 0;
 
-    memset(pool->objects, 0, obj_size * max_objects);
+    memset(chunk->free_bits, 0xff, words * sizeof(uint64_t));
 
-    for(size_t i = 0; i < max_objects; ++i) {
-        list_push((List**)&pool->free_objects, (List*)obj_ptr(pool, i));
+    if(num_objects % BITS_PER_WORD) {
+        // don't hand out the slots past the end
+        chunk->free_bits[words - 1] = (UINT64_C(1) << (num_objects % BITS_PER_WORD)) - 1;
     }
 
-    log_debug("[%s] Allocated pool for %zu objects, %zu bytes each",
-        pool->tag,
-        pool->max_objects,
-        pool->size_of_object
-    );
+    for(size_t i = 0; i < num_objects; ++i) {
+        ObjectHeader *hdr = obj_header(obj_ptr(pool, chunk, i));
+        hdr->chunk = chunk;
+        hdr->slot = i;
+    }
 
-    return pool;
+    pool->chunks = realloc(pool->chunks, sizeof(ObjectPoolChunk*) * (pool->num_chunks + 1));
+    pool->chunks[pool->num_chunks++] = chunk;
+    pool->capacity += num_objects;
+
+    if(pool->capacity > pool->peak_capacity) {
+        pool->peak_capacity = pool->capacity;
+    }
+
+    log_debug("[%s] Added a chunk of %zu objects (%zu total)", pool->tag, num_objects, pool->capacity);
+    return chunk;
 }
 
-ObjectInterface *objpool_acquire(ObjectPool *pool) {
-    ObjectInterface *obj = (ObjectInterface*)list_pop((List**)&pool->free_objects);
+static ObjectPoolChunk* objpool_find_free_chunk(ObjectPool *pool) {
+    for(size_t i = pool->first_free_chunk; i < pool->num_chunks; ++i) {
+        if(pool->chunks[i]->usage < pool->chunks[i]->num_objects) {
+            pool->first_free_chunk = i;
+            return pool->chunks[i];
+        }
+    }
 
-    if(obj) {
+    pool->first_free_chunk = pool->num_chunks;
+    return objpool_add_chunk(pool);
+}
+
+ObjectInterface *objpool_try_acquire(ObjectPool *pool) {
+    ObjectPoolChunk *chunk = objpool_find_free_chunk(pool);
+
+    if(!chunk) {
+        return NULL;
+    }
+
+    size_t w = chunk->first_free_word;
+
+    while(!chunk->free_bits[w]) {
+        ++w;
+    }
+
+    size_t bit = __builtin_ctzll(chunk->free_bits[w]);
+    chunk->free_bits[w] &= ~(UINT64_C(1) << bit);
+    chunk->first_free_word = w;
+    chunk->usage++;
+
+    ObjectInterface *obj = obj_ptr(pool, chunk, w * BITS_PER_WORD + bit);
+
+    if(pool->init_func) {
+        pool->init_func(obj);
+    } else {
         memset(obj, 0, pool->size_of_object);
+    }
 
-        IF_OBJPOOL_DEBUG({
-            OBJ_USED(pool, obj) = true;
-        })
+    if(++pool->usage > pool->peak_usage) {
+        pool->peak_usage = pool->usage;
+    }
 
-        if(++pool->usage > pool->peak_usage) {
-            pool->peak_usage = pool->usage;
-        }
+    // log_debug("[%s] Usage: %zu", pool->tag, pool->usage);
+    return obj;
+}
 
-        // log_debug("[%s] Usage: %zu", pool->tag, pool->usage);
+ObjectInterface *objpool_acquire(ObjectPool *pool) {
+    ObjectInterface *obj = objpool_try_acquire(pool);
+
+    if(obj) {
         return obj;
     }
 
@@ -82,45 +198,69 @@ ObjectInterface *objpool_acquire(ObjectPool *pool) {
 }
 
 void objpool_release(ObjectPool *pool, ObjectInterface *object) {
-    IF_OBJPOOL_DEBUG({
-        char *objofs = (char*)object;
-        char *minofs = pool->objects;
-        char *maxofs = pool->objects + (pool->max_objects - 1) * pool->size_of_object;
-
-        if(objofs < minofs || objofs > maxofs) {
-            log_fatal("[%s] Object pointer %p is not within range %p - %p",
-                pool->tag,
-                (void*)objofs,
-                (void*)minofs,
-                (void*)maxofs
-            );
-        }
+    ObjectHeader *hdr = obj_header(object);
+    ObjectPoolChunk *chunk = hdr->chunk;
+    size_t w = hdr->slot / BITS_PER_WORD;
+    uint64_t mask = UINT64_C(1) << (hdr->slot % BITS_PER_WORD);
 
-        ptrdiff_t misalign = (ptrdiff_t)(objofs - pool->objects) % pool->size_of_object;
-
-        if(misalign) {
-            log_fatal("[%s] Object pointer %p is misaligned by %zi",
+    IF_OBJPOOL_DEBUG({
+        if(chunk->pool != pool) {
+            log_fatal("[%s] Object %p does not belong to this pool",
                 pool->tag,
-                (void*)objofs,
-                (ssize_t)misalign
+                (void*)object
             );
         }
 
-        if(!OBJ_USED(pool, object)) {
+        if(chunk->free_bits[w] & mask) {
             log_fatal("[%s] Attempted to release an unused object %p",
                 pool->tag,
-                (void*)objofs
+                (void*)object
             );
         }
-
-        OBJ_USED(pool, object) = false;
     })
 
-    list_push((List**)&pool->free_objects, (List*)object);
+    chunk->free_bits[w] |= mask;
+    chunk->usage--;
+
+    if(w < chunk->first_free_word) {
+        chunk->first_free_word = w;
+    }
+
+    if(chunk->index < pool->first_free_chunk) {
+        pool->first_free_chunk = chunk->index;
+    }
+
     pool->usage--;
     // log_debug("[%s] Usage: %zu", pool->tag, pool->usage);
 }
 
+void objpool_shrink(ObjectPool *pool, size_t keep_chunks) {
+    size_t freed = 0;
+    size_t j = 0;
+
+    // the oldest chunks are at the front; keep those
+    for(size_t i = 0; i < pool->num_chunks; ++i) {
+        ObjectPoolChunk *chunk = pool->chunks[i];
+
+        if(i >= keep_chunks && !chunk->usage) {
+            pool->capacity -= chunk->num_objects;
+            freed++;
+            free(chunk);
+            continue;
+        }
+
+        chunk->index = j;
+        pool->chunks[j++] = chunk;
+    }
+
+    pool->num_chunks = j;
+    pool->first_free_chunk = 0;
+
+    if(freed) {
+        log_debug("[%s] Released %zu empty chunks (%zu objects left)", pool->tag, freed, pool->capacity);
+    }
+}
+
 void objpool_free(ObjectPool *pool) {
     if(!pool) {
         return;
@@ -130,17 +270,21 @@ void objpool_free(ObjectPool *pool) {
         log_warn("[%s] %zu objects still in use", pool->tag, pool->usage);
     }
 
-    IF_OBJPOOL_DEBUG({
-        free(pool->usemap);
-    })
+    for(size_t i = 0; i < pool->num_chunks; ++i) {
+        free(pool->chunks[i]);
+    }
 
+    free(pool->chunks);
     free(pool->tag);
     free(pool);
 }
 
 void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats) {
     stats->tag = pool->tag;
-    stats->capacity = pool->max_objects;
+    stats->capacity = pool->capacity;
+    stats->max_objects = pool->max_objects;
     stats->usage = pool->usage;
     stats->peak_usage = pool->peak_usage;
+    stats->peak_capacity = pool->peak_capacity;
+    stats->num_chunks = pool->num_chunks;
 }
@@ -19,12 +19,16 @@
 typedef struct ObjectPool ObjectPool;
 typedef struct ObjectInterface ObjectInterface;
 typedef struct ObjectPoolStats ObjectPoolStats;
+typedef void (*ObjectInitFunc)(ObjectInterface *obj);
 
 struct ObjectPoolStats {
     const char *tag;
-    size_t capacity;
+    size_t capacity;        // objects currently allocated
+    size_t max_objects;     // 0 if unlimited
     size_t usage;
     size_t peak_usage;
+    size_t peak_capacity;
+    size_t num_chunks;
 };
 
 struct ObjectInterface {
@@ -37,8 +41,17 @@ struct ObjectInterface {
     };
 };
 
-ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag);
+// Pools grow by chunk_size objects at a time, up to max_objects (0 means no limit).
+ObjectPool *objpool_alloc(size_t obj_size, size_t chunk_size, size_t max_objects, const char *tag);
 void objpool_free(ObjectPool *pool);
+// Called on every object handed out by objpool_acquire(), instead of zeroing the whole thing.
+// Use this for types whose constructor initializes nearly every field anyway.
+void objpool_set_init_func(ObjectPool *pool, ObjectInitFunc init_func);
+// Aborts if the pool has reached its limit
 ObjectInterface *objpool_acquire(ObjectPool *pool);
+// Returns NULL if the pool has reached its limit
+ObjectInterface *objpool_try_acquire(ObjectPool *pool);
 void objpool_release(ObjectPool *pool, ObjectInterface *object);
+// Gives chunks with no live objects back to the system, except for the keep_chunks oldest ones
+void objpool_shrink(ObjectPool *pool, size_t keep_chunks);
 void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats);
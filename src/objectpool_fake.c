@@ -6,7 +6,7 @@ struct ObjectPool {
     size_t size_of_object;
 };
 
-ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag) {
+ObjectPool *objpool_alloc(size_t obj_size, size_t chunk_size, size_t max_objects, const char *tag) {
     ObjectPool *pool = malloc(sizeof(ObjectPool));
     pool->size_of_object = obj_size;
     return pool;
@@ -16,15 +16,25 @@ ObjectInterface *objpool_acquire(ObjectPool *pool) {
     return calloc(1, pool->size_of_object);
 }
 
+ObjectInterface *objpool_try_acquire(ObjectPool *pool) {
+    return objpool_acquire(pool);
+}
+
 void objpool_release(ObjectPool *pool, ObjectInterface *object) {
     free(object);
 }
 
+void objpool_shrink(ObjectPool *pool, size_t keep_chunks) {
+}
+
+void objpool_set_init_func(ObjectPool *pool, ObjectInitFunc init_func) {
+}
+
 void objpool_free(ObjectPool *pool) {
     free(pool);
 }
 
 void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats) {
-    memset(&stats, 0, sizeof(ObjectPoolStats));
+    memset(stats, 0, sizeof(ObjectPoolStats));
     stats->tag = "<N/A>";
 }
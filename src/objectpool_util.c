@@ -14,5 +14,5 @@ void objpool_release_list(ObjectPool *pool, List **dest) {
 bool objpool_is_full(ObjectPool *pool) {
     ObjectPoolStats stats;
     objpool_get_stats(pool, &stats);
-    return stats.capacity == stats.usage;
+    return stats.max_objects && stats.usage >= stats.max_objects;
 }
@@ -117,7 +117,7 @@ void player_draw(Player* plr) {
 				glRotatef(global.frames*10, 0, 0, 1);
 				glScalef(1, 1, 1);
 				glColor4f(1, 1, 1, 0.2 * (clamp(plr->focus, 0, 15) / 15.0));
-				draw_texture(0, 0, "fairy_circle");
+				draw_texture_p(0, 0, get_tex_interned(INTERN_STATIC("fairy_circle")));
 				glColor4f(1,1,1,1);
 			glPopMatrix();
 		}
@@ -139,7 +139,7 @@ void player_draw(Player* plr) {
 			glPushMatrix();
 				glColor4f(1, 1, 1, plr->focus / 30.0);
 				glRotatef(global.frames, 0, 0, -1);
-				draw_texture(0, 0, "focus");
+				draw_texture_p(0, 0, get_tex_interned(INTERN_STATIC("focus")));
 				glColor4f(1, 1, 1, 1);
 			glPopMatrix();
 		}
@@ -748,7 +748,14 @@ void replay_play(Replay *rpy, int firstidx) {
 			continue;
 		}
 
+		StageInfo *next = NULL;
+
+		for(int j = i + 1; j < global.replay.numstages && !next; ++j) {
+			next = stage_get(global.replay.stages[j].stage);
+		}
+
 		global.plr.mode = plrmode_find(rstg->plr_char, rstg->plr_shot);
+		stage_set_next(next);
 		stage_loop(gstg);
 
 		if(global.game_over == GAMEOVER_ABORT) {
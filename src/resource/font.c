@@ -58,7 +58,7 @@ struct Fonts _fonts;
 static TTF_Font* load_ttf(char *vfspath, int size) {
 	char *syspath = vfs_repr(vfspath, true);
 
-	SDL_RWops *rwops = vfs_open(vfspath, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+	SDL_RWops *rwops = vfs_open(vfspath, VFS_MODE_READ | VFS_MODE_SEEKABLE | VFS_MODE_MAP);
 
 	if(!rwops) {
 		log_fatal("VFS error: %s", vfs_get_error());
@@ -106,10 +106,11 @@ static void free_cache_entry(CacheEntry *e) {
 }
 
 static CacheEntry* get_cache_entry(Font *font, const char *text) {
-	CacheEntry *e = hashtable_get_unsafe(font->cache, (void*)text);
+	CacheEntry *e = hashtable_get_string(font->cache, text);
 
 	if(!e) {
-		if(objpool_is_full(cache_pool)) {
+		if(!(e = (CacheEntry*)objpool_try_acquire(cache_pool))) {
+			// the cache is full, make room by dropping the least recently used entry
 			CacheEntry *oldest = cache_entries;
 
 			for(CacheEntry *e = cache_entries->next; e; e = e->next) {
@@ -120,9 +121,9 @@ static CacheEntry* get_cache_entry(Font *font, const char *text) {
 
 			hashtable_unset_string(oldest->owner.ht, oldest->owner.ht_key);
 			free_cache_entry(oldest);
+			e = (CacheEntry*)objpool_acquire(cache_pool);
 		}
 
-		e = (CacheEntry*)objpool_acquire(cache_pool);
 		list_push((List**)&cache_entries, (List*)e);
 		hashtable_set_string(font->cache, text, e);
 		e->owner.ht = font->cache;
@@ -239,7 +240,7 @@ void fontrenderer_draw(FontRenderer *f, const char *text, Font *font) {
 void init_fonts(void) {
 	TTF_Init();
 	memset(&resources.fontren, 0, sizeof(resources.fontren));
-	cache_pool = objpool_alloc(sizeof(CacheEntry), 512, "fontcache");
+	cache_pool = objpool_alloc(sizeof(CacheEntry), 64, 512, "fontcache");
 }
 
 void uninit_fonts(void) {
@@ -273,9 +274,10 @@ void reload_fonts(float quality) {
 
 static void free_font(Font *font) {
 	CacheEntry *e;
+	HashtableIterator i;
 	TTF_CloseFont(font->ttf);
 
-	for(HashtableIterator *i = hashtable_iter(font->cache); hashtable_iter_next(i, 0, (void**)&e);) {
+	for(hashtable_iter_init(font->cache, &i); hashtable_iter_next(&i, 0, (void**)&e);) {
 		free_cache_entry(e);
 	}
 
@@ -9,13 +9,29 @@
 #include "model.h"
 #include "list.h"
 #include "resource.h"
+#include "rescache.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
-static void parse_obj(const char *filename, ObjFileData *data);
+static bool parse_obj(const char *filename, ObjFileData *data);
 static void free_obj(ObjFileData *data);
 
+static const ResCacheType modelcache_type = {
+	.dir = "storage/modelcache",
+	.extension = ".mdl",
+	.envvar = "TAISEI_MODEL_CACHE",
+	.magic = 0x3143444d, // "MDC1"
+	.version = 1,
+};
+
+typedef struct ModelCachePayload {
+	uint32_t fverts;
+	uint32_t vcount;
+	uint32_t icount;
+	// followed by Vertex[vcount], then uint32_t[icount]
+} ModelCachePayload;
+
 char* model_path(const char *name) {
 	return strjoin(MDL_PATH_PREFIX, name, MDL_EXTENSION, NULL);
 }
@@ -25,17 +41,92 @@ bool check_model_path(const char *path) {
 }
 
 typedef struct ModelLoadData {
-	ObjFileData *obj;
 	Vertex *verts;
+	int vcount;
 	Model *model;
+	ResCacheBuffer *cache; // if set, verts point into it
 } ModelLoadData;
 
-void* load_model_begin(const char *path, unsigned int flags) {
+static ModelLoadData* load_model_cached(const char *path) {
+	ModelCachePayload *p;
+	size_t size;
+	ResCacheBuffer *buf = rescache_load(&modelcache_type, path, (void**)&p, &size);
+
+	if(!buf) {
+		return NULL;
+	}
+
+	if(
+		size < sizeof(ModelCachePayload) ||
+		(p->fverts != 3 && p->fverts != 4) ||
+		size < sizeof(ModelCachePayload) + p->vcount * sizeof(Vertex) + p->icount * sizeof(uint32_t)
+	) {
+		log_warn("Model cache entry for %s is corrupt", path);
+		rescache_release(buf);
+		return NULL;
+	}
+
+	Vertex *verts = (Vertex*)(p + 1);
+	uint32_t *indices = (uint32_t*)(verts + p->vcount);
+
+	for(uint32_t i = 0; i < p->icount; ++i) {
+		if(indices[i] >= p->vcount) {
+			log_warn("Model cache entry for %s is corrupt", path);
+			rescache_release(buf);
+			return NULL;
+		}
+	}
+
 	Model *m = malloc(sizeof(Model));
+	m->fverts = p->fverts;
+	m->icount = p->icount;
+	m->indices = calloc(p->icount, sizeof(unsigned int));
+	memcpy(m->indices, indices, p->icount * sizeof(uint32_t));
+
+	ModelLoadData *ldata = malloc(sizeof(ModelLoadData));
+	ldata->verts = verts;
+	ldata->vcount = p->vcount;
+	ldata->model = m;
+	ldata->cache = buf;
+
+	return ldata;
+}
+
+static void store_model_cache(const char *path, ModelLoadData *ldata) {
+	SDL_RWops *rw = rescache_store(&modelcache_type, path);
+
+	if(!rw) {
+		return;
+	}
+
+	ModelCachePayload p = {
+		.fverts = ldata->model->fverts,
+		.vcount = ldata->vcount,
+		.icount = ldata->model->icount,
+	};
+
+	if(
+		SDL_RWwrite(rw, &p, sizeof(p), 1) != 1 ||
+		SDL_RWwrite(rw, ldata->verts, sizeof(Vertex), p.vcount) != p.vcount ||
+		SDL_RWwrite(rw, ldata->model->indices, sizeof(uint32_t), p.icount) != p.icount
+	) {
+		// a truncated entry will fail validation on the next load
+		log_warn("Couldn't write model cache entry for %s: %s", path, SDL_GetError());
+	}
+
+	SDL_RWclose(rw);
+}
+
+static ModelLoadData* load_model_obj(const char *path) {
 	ObjFileData *data = malloc(sizeof(ObjFileData));
 	Vertex *verts;
 
-	parse_obj(path, data);
+	if(!parse_obj(path, data)) {
+		free(data);
+		return NULL;
+	}
+
+	Model *m = malloc(sizeof(Model));
 
 	m->fverts = data->fverts;
 	m->indices = calloc(data->icount, sizeof(unsigned int));
@@ -81,9 +172,13 @@ void* load_model_begin(const char *path, unsigned int flags) {
 #undef BADREF
 
 	ModelLoadData *ldata = malloc(sizeof(ModelLoadData));
-	ldata->obj = data;
 	ldata->verts = verts;
+	ldata->vcount = data->icount;
 	ldata->model = m;
+	ldata->cache = NULL;
+
+	free_obj(data);
+	free(data);
 
 	return ldata;
 
@@ -96,32 +191,52 @@ fail:
 	return NULL;
 }
 
+void* load_model_begin(const char *path, unsigned int flags) {
+	ModelLoadData *ldata = load_model_cached(path);
+
+	if(!ldata && (ldata = load_model_obj(path))) {
+		store_model_cache(path, ldata);
+	}
+
+	return ldata;
+}
+
 void* load_model_end(void *opaque, const char *path, unsigned int flags) {
 	ModelLoadData *ldata = opaque;
-	unsigned int ioffset = _vbo.offset;
 
 	if(!ldata) {
 		return NULL;
 	}
 
-	for(int i = 0; i < ldata->obj->icount; ++i) {
-		ldata->model->indices[i] += ioffset;
+	Model *m = ldata->model;
+	m->vbo_block = vbo_alloc_verts(&_vbo, ldata->verts, ldata->vcount);
+	m->ioffset = m->vbo_block->offset;
+
+	for(int i = 0; i < m->icount; ++i) {
+		m->indices[i] += m->ioffset;
 	}
 
-	vbo_add_verts(&_vbo, ldata->verts, ldata->obj->icount);
+	if(ldata->cache) {
+		rescache_release(ldata->cache);
+	} else {
+		free(ldata->verts);
+	}
 
-	free(ldata->verts);
-	free_obj(ldata->obj);
-	free(ldata->obj);
-	Model *m = ldata->model;
 	free(ldata);
 
 	return m;
 }
 
-void unload_model(void *model) { // Does not delete elements from the VBO, so doing this at runtime is leaking VBO space
-	free(((Model*)model)->indices);
-	free(model);
+void unload_model(void *model) {
+	Model *m = model;
+	vbo_free_verts(&_vbo, m->vbo_block);
+	free(m->indices);
+	free(m);
+}
+
+size_t model_size(void *model) {
+	Model *m = model;
+	return sizeof(Model) + m->icount * sizeof(*m->indices) + m->vbo_block->count * sizeof(Vertex);
 }
 
 static void free_obj(ObjFileData *data) {
@@ -131,12 +246,12 @@ static void free_obj(ObjFileData *data) {
 	free(data->indices);
 }
 
-static void parse_obj(const char *filename, ObjFileData *data) {
-	SDL_RWops *rw = vfs_open(filename, VFS_MODE_READ);
+static bool parse_obj(const char *filename, ObjFileData *data) {
+	SDL_RWops *rw = vfs_open(filename, VFS_MODE_READ | VFS_MODE_MAP);
 
 	if(!rw) {
 		log_warn("VFS error: %s", vfs_get_error());
-		return;
+		return false;
 	}
 
 	char line[256], *save;
@@ -231,6 +346,7 @@ static void parse_obj(const char *filename, ObjFileData *data) {
 	}
 
 	SDL_RWclose(rw);
+	return true;
 }
 
 Model* get_model(const char *name) {
@@ -240,6 +356,17 @@ Model* get_model(const char *name) {
 void draw_model_p(Model *model) {
 	GLenum flag = model->fverts == 3 ? GL_TRIANGLES : GL_QUADS;
 
+	if(model->ioffset != model->vbo_block->offset) {
+		// the VBO has been compacted since we last drew this
+		unsigned int delta = model->vbo_block->offset - model->ioffset;
+
+		for(int i = 0; i < model->icount; ++i) {
+			model->indices[i] += delta;
+		}
+
+		model->ioffset = model->vbo_block->offset;
+	}
+
 	glMatrixMode(GL_TEXTURE);
 	glScalef(1,-1,1); // every texture in taisei is actually read vertically mirrored. and I noticed that just now.
 
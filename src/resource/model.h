@@ -10,6 +10,7 @@
 
 #include <stdbool.h>
 #include "matrix.h"
+#include "vbo.h"
 
 typedef int IVector[3];
 
@@ -33,13 +34,16 @@ typedef struct Model {
 	unsigned int *indices;
 	int icount;
 	int fverts;
+	VBOBlock *vbo_block;
+	unsigned int ioffset; // VBO offset the indices are currently based on
 } Model;
 
 char* model_path(const char *name);
 bool check_model_path(const char *path);
 void* load_model_begin(const char *path, unsigned int flags);
 void* load_model_end(void *opaque, const char *path, unsigned int flags);
-void unload_model(void*); // Does not delete elements from the VBO, so doing this at runtime is leaking VBO space
+void unload_model(void*);
+size_t model_size(void *model);
 
 Model* get_model(const char *name);
 
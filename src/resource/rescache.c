@@ -0,0 +1,215 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "rescache.h"
+#include "global.h"
+
+#define RESCACHE_DATA_ALIGN 64
+
+typedef struct ResCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t src_size;
+	int64_t src_mtime;
+	uint32_t pathlen;
+	uint32_t data_offset;
+} ResCacheHeader;
+
+struct ResCacheBuffer {
+	const void *data;
+	size_t size;
+
+	// if set, data points into this mapping; otherwise it's malloc'd
+	VFSMapping *mapping;
+};
+
+static bool rescache_enabled(const ResCacheType *type) {
+	return getenvint(type->envvar, true);
+}
+
+static bool rescache_srcinfo(const char *srcpath, VFSInfo *info) {
+	*info = vfs_query(srcpath);
+
+	if(info->error || !info->exists || info->is_dir) {
+		return false;
+	}
+
+	// without these, we have no way to tell when the entry goes stale
+	return info->size || info->mtime;
+}
+
+static char* rescache_path(const ResCacheType *type, const char *srcpath) {
+	// Flatten the source path into a single file name. '_' is the escape character, so that
+	// different sources never map to the same file: '/' becomes "_-", and '_' itself becomes "__".
+	size_t len = 0;
+
+	for(const char *c = srcpath; *c; ++c) {
+		len += (*c == '/' || *c == '_') ? 2 : 1;
+	}
+
+	char name[len + 1], *n = name;
+
+	for(const char *c = srcpath; *c; ++c) {
+		if(*c == '/') {
+			*n++ = '_';
+			*n++ = '-';
+		} else if(*c == '_') {
+			*n++ = '_';
+			*n++ = '_';
+		} else {
+			*n++ = *c;
+		}
+	}
+
+	*n = 0;
+	return strjoin(type->dir, "/", name, type->extension, NULL);
+}
+
+static ResCacheBuffer* rescache_buffer_load(const char *path) {
+	ResCacheBuffer *buf = calloc(1, sizeof(ResCacheBuffer));
+
+	if((buf->mapping = vfs_map(path, &buf->data, &buf->size))) {
+		return buf;
+	}
+
+	SDL_RWops *rw = vfs_open(path, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+
+	if(!rw) {
+		free(buf);
+		return NULL;
+	}
+
+	Sint64 size = SDL_RWsize(rw);
+	void *data = size > 0 ? malloc(size) : NULL;
+
+	if(!data || SDL_RWread(rw, data, size, 1) != 1) {
+		free(data);
+		free(buf);
+		buf = NULL;
+	} else {
+		buf->data = data;
+		buf->size = size;
+	}
+
+	SDL_RWclose(rw);
+	return buf;
+}
+
+void rescache_release(ResCacheBuffer *buf) {
+	if(!buf) {
+		return;
+	}
+
+	if(buf->mapping) {
+		vfs_unmap(buf->mapping);
+	} else {
+		free((void*)buf->data);
+	}
+
+	free(buf);
+}
+
+ResCacheBuffer* rescache_load(const ResCacheType *type, const char *srcpath, void **payload, size_t *payload_size) {
+	VFSInfo srcinfo;
+
+	if(!rescache_enabled(type) || !rescache_srcinfo(srcpath, &srcinfo)) {
+		return NULL;
+	}
+
+	char *path = rescache_path(type, srcpath);
+	ResCacheBuffer *buf = rescache_buffer_load(path);
+
+	if(!buf) {
+		free(path);
+		return NULL;
+	}
+
+	ResCacheHeader hdr;
+	size_t srcpathlen = strlen(srcpath);
+
+	if(buf->size < sizeof(hdr)) {
+		goto stale;
+	}
+
+	memcpy(&hdr, buf->data, sizeof(hdr));
+
+	uint32_t data_offset = SDL_SwapLE32(hdr.data_offset);
+
+	if(
+		SDL_SwapLE32(hdr.magic) != type->magic ||
+		SDL_SwapLE32(hdr.version) != type->version ||
+		SDL_SwapLE64(hdr.src_size) != srcinfo.size ||
+		(int64_t)SDL_SwapLE64(hdr.src_mtime) != srcinfo.mtime ||
+		SDL_SwapLE32(hdr.pathlen) != srcpathlen ||
+		data_offset % RESCACHE_DATA_ALIGN ||
+		data_offset < sizeof(hdr) + srcpathlen ||
+		data_offset > buf->size ||
+		memcmp((char*)buf->data + sizeof(hdr), srcpath, srcpathlen)
+	) {
+		goto stale;
+	}
+
+	*payload = (char*)buf->data + data_offset;
+	*payload_size = buf->size - data_offset;
+
+	free(path);
+	return buf;
+
+stale:
+	log_debug("Stale cache entry %s", path);
+	rescache_release(buf);
+	free(path);
+	return NULL;
+}
+
+SDL_RWops* rescache_store(const ResCacheType *type, const char *srcpath) {
+	VFSInfo srcinfo;
+
+	if(!rescache_enabled(type) || !rescache_srcinfo(srcpath, &srcinfo)) {
+		return NULL;
+	}
+
+	if(!vfs_mkdir(type->dir)) {
+		log_warn("VFS error: %s", vfs_get_error());
+		return NULL;
+	}
+
+	char *path = rescache_path(type, srcpath);
+	SDL_RWops *rw = vfs_open(path, VFS_MODE_WRITE);
+
+	if(!rw) {
+		log_warn("VFS error: %s", vfs_get_error());
+		free(path);
+		return NULL;
+	}
+
+	size_t srcpathlen = strlen(srcpath);
+	uint32_t data_offset = sizeof(ResCacheHeader) + srcpathlen;
+	size_t padding = (RESCACHE_DATA_ALIGN - data_offset % RESCACHE_DATA_ALIGN) % RESCACHE_DATA_ALIGN;
+	char zeros[RESCACHE_DATA_ALIGN] = { 0 };
+	data_offset += padding;
+
+	bool ok =
+		SDL_WriteLE32(rw, type->magic) &&
+		SDL_WriteLE32(rw, type->version) &&
+		SDL_WriteLE64(rw, srcinfo.size) &&
+		SDL_WriteLE64(rw, srcinfo.mtime) &&
+		SDL_WriteLE32(rw, srcpathlen) &&
+		SDL_WriteLE32(rw, data_offset) &&
+		SDL_RWwrite(rw, srcpath, srcpathlen, 1) == 1 &&
+		(!padding || SDL_RWwrite(rw, zeros, padding, 1) == 1);
+
+	if(!ok) {
+		log_warn("Couldn't write cache entry %s: %s", path, SDL_GetError());
+		SDL_RWclose(rw);
+		rw = NULL;
+	}
+
+	free(path);
+	return rw;
+}
@@ -0,0 +1,40 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#pragma once
+
+#include <SDL.h>
+#include <stdbool.h>
+
+/*
+ *  Generic on-disk cache for preprocessed resource data, kept in storage/.
+ *
+ *  Every entry starts with a common header that records the path, size and modification time
+ *  of the source file it was produced from. If those no longer match what the VFS reports
+ *  (e.g. the file or the package containing it has been updated), the entry is ignored and
+ *  gets rebuilt. The payload is stored in a format private to each resource type, and is
+ *  memory-mapped when possible.
+ *
+ *  Entries are not portable across machines of different endianness.
+ */
+
+typedef struct ResCacheType {
+	const char *dir;        // VFS path of the cache directory
+	const char *extension;
+	const char *envvar;     // set to 0 to disable the cache
+	uint32_t magic;
+	uint32_t version;
+} ResCacheType;
+
+typedef struct ResCacheBuffer ResCacheBuffer;
+
+ResCacheBuffer* rescache_load(const ResCacheType *type, const char *srcpath, void **payload, size_t *payload_size);
+void rescache_release(ResCacheBuffer *buf);
+
+// Returns a stream positioned at the start of the payload, or NULL. Close it when done writing.
+SDL_RWops* rescache_store(const ResCacheType *type, const char *srcpath);
@@ -10,12 +10,19 @@
 #include "config.h"
 #include "video.h"
 #include "menu/mainmenu.h"
-#include "events.h"
 #include "recolor.h"
+#include "threadpool.h"
+#include "audio.h"
 
 Resources resources;
 static SDL_threadID main_thread_id;
 
+// advanced once per frame, used to find the least recently used resources
+static uint32_t resource_clock;
+
+// in bytes, 0 means unlimited
+static size_t resource_budget;
+
 static const char *resource_type_names[] = {
 	"texture",
 	"animation",
@@ -39,6 +46,7 @@ static void register_handler(
 	ResourceNameFunc name,
 	ResourceFindFunc find,
 	ResourceCheckFunc check,
+	ResourceSizeFunc size,
 	size_t tablesize)
 {
 	assert(type >= 0 && type < RES_NUMTYPES);
@@ -51,17 +59,21 @@ static void register_handler(
 	h->name = name;
 	h->find = find;
 	h->check = check;
-	h->mapping = hashtable_new_stringkeys(tablesize);
-	h->async_load_data = hashtable_new_stringkeys(tablesize);
+	h->size = size;
+	h->mapping = hashtable_new_internedkeys(tablesize);
+	h->async_load_data = hashtable_new_internedkeys(tablesize);
 	strcpy(h->subdir, subdir);
 }
 
 static void unload_resource(Resource *res) {
-	get_handler(res->type)->unload(res->data);
+	ResourceHandler *handler = get_handler(res->type);
+	handler->resident_bytes -= res->size;
+	--handler->num_resident;
+	handler->unload(res->data);
 	free(res);
 }
 
-Resource* insert_resource(ResourceType type, const char *name, void *data, ResourceFlags flags, const char *source) {
+static Resource* insert_resource_internal(ResourceType type, const char *name, void *data, ResourceFlags flags, const char *source, size_t size) {
 	assert(name != NULL);
 	assert(source != NULL);
 
@@ -81,14 +93,15 @@ Resource* insert_resource(ResourceType type, const char *name, void *data, Resou
 	Resource *oldres = hashtable_get_string(handler->mapping, name);
 	Resource *res = malloc(sizeof(Resource));
 
-	if(type == RES_MODEL || getenvint("TAISEI_NOUNLOAD", false)) {
-		// FIXME: models can't be safely unloaded at runtime
+	if(getenvint("TAISEI_NOUNLOAD", false)) {
 		flags |= RESF_PERMANENT;
 	}
 
 	res->type = handler->type;
 	res->flags = flags;
 	res->data = data;
+	res->size = size;
+	res->last_used = resource_clock;
 
 	if(oldres) {
 		log_warn("Replacing a previously loaded %s '%s'", resource_type_names[type], name);
@@ -96,6 +109,8 @@ Resource* insert_resource(ResourceType type, const char *name, void *data, Resou
 	}
 
 	hashtable_set_string(handler->mapping, name, res);
+	handler->resident_bytes += size;
+	++handler->num_resident;
 
 	log_info("Loaded %s '%s' from '%s' (%s)", resource_type_names[handler->type], name, source,
 		(flags & RESF_PERMANENT) ? "permanent" : "transient");
@@ -103,6 +118,12 @@ Resource* insert_resource(ResourceType type, const char *name, void *data, Resou
 	return res;
 }
 
+Resource* insert_resource(ResourceType type, const char *name, void *data, ResourceFlags flags, const char *source) {
+	ResourceHandler *handler = get_handler(type);
+	size_t size = (data && handler->size) ? handler->size(data) : 0;
+	return insert_resource_internal(type, name, data, flags, source, size);
+}
+
 static char* get_name(ResourceHandler *handler, const char *path) {
 	if(handler->name) {
 		return handler->name(path);
@@ -111,45 +132,72 @@ static char* get_name(ResourceHandler *handler, const char *path) {
 	return resource_util_basename(handler->subdir, path);
 }
 
-typedef struct ResourceAsyncLoadData {
+typedef struct ResourceAsyncLoadData ResourceAsyncLoadData;
+
+struct ResourceAsyncLoadData {
 	ResourceHandler *handler;
 	char *path;
 	char *name;
 	ResourceFlags flags;
 	void *opaque;
-} ResourceAsyncLoadData;
+	bool batched;
+	ResourceAsyncLoadData *next_completed;
+};
+
+static struct {
+	ThreadPool *pool;
+
+	// protects the completion queue below; signaled whenever something is added to it,
+	// and whenever the main thread finishes a load
+	SDL_mutex *mutex;
+	SDL_cond *cond;
+	ResourceAsyncLoadData *completed;
+
+	// completions taken off the queue, but not finished yet; main thread only
+	ResourceAsyncLoadData *ready;
+
+	// number of loads submitted, but not yet finished on the main thread
+	int num_pending;
+} async_loader;
+
+// progress of the manifest loads currently in flight; reset once they're all done
+static struct {
+	int total;
+	int done;
+	bool submitting;
+	bool background;
+} preload_batch;
+
+static ResourceManifest *recording_manifest;
+
+// Higher values are loaded first
+static const int resource_load_priorities[RES_NUMTYPES] = {
+	[RES_TEXTURE]     = 3,
+	[RES_ANIM]        = 3,
+	[RES_SHADER]      = 3,
+	[RES_MODEL]       = 3,
+	[RES_POSTPROCESS] = 3,
+	[RES_SFX]         = 2,
+	[RES_BGM]         = 1,
+};
+
+// Subtracted from the above for prefetches, so they never get in the way of anything needed right now
+#define RESOURCE_PREFETCH_PRIORITY_OFFSET 3
 
-static int load_resource_async_thread(void *vdata) {
+static void load_resource_async_task(void *vdata) {
 	ResourceAsyncLoadData *data = vdata;
 
-	SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
 	data->opaque = data->handler->begin_load(data->path, data->flags);
-	events_emit(TE_RESOURCE_ASYNC_LOADED, 0, data, NULL);
 
-	return 0;
+	SDL_LockMutex(async_loader.mutex);
+	data->next_completed = async_loader.completed;
+	async_loader.completed = data;
+	SDL_CondBroadcast(async_loader.cond);
+	SDL_UnlockMutex(async_loader.mutex);
 }
 
 static Resource* load_resource_finish(void *opaque, ResourceHandler *handler, const char *path, const char *name, char *allocated_path, char *allocated_name, ResourceFlags flags);
 
-static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
-	assert(SDL_ThreadID() == main_thread_id);
-
-	ResourceAsyncLoadData *data = evt->user.data1;
-
-	if(!data) {
-		return true;
-	}
-
-	char name[strlen(data->name) + 1];
-	strcpy(name, data->name);
-
-	load_resource_finish(data->opaque, data->handler, data->path, data->name, data->path, data->name, data->flags);
-	hashtable_unset(data->handler->async_load_data, name);
-	free(data);
-
-	return true;
-}
-
 static void load_resource_async(ResourceHandler *handler, char *path, char *name, ResourceFlags flags) {
 	log_debug("Loading %s '%s' asynchronously", resource_type_names[handler->type], name);
 
@@ -160,30 +208,106 @@ static void load_resource_async(ResourceHandler *handler, char *path, char *name
 	data->path = path;
 	data->name = name;
 	data->flags = flags;
+	data->batched = preload_batch.submitting && !preload_batch.background;
+
+	if(data->batched) {
+		++preload_batch.total;
+	}
 
-	SDL_Thread *thread = SDL_CreateThread(load_resource_async_thread, __func__, data);
+	int priority = resource_load_priorities[handler->type];
 
-	if(thread) {
-		SDL_DetachThread(thread);
-	} else {
-		log_warn("SDL_CreateThread() failed: %s", SDL_GetError());
-		log_warn("Falling back to synchronous loading. Use TAISEI_NOASYNC=1 to suppress this warning.");
-		load_resource_async_thread(data);
+	if(preload_batch.background) {
+		priority -= RESOURCE_PREFETCH_PRIORITY_OFFSET;
 	}
+
+	++async_loader.num_pending;
+	threadpool_submit(async_loader.pool, load_resource_async_task, data, priority);
 }
 
-static void update_async_load_state(void) {
-	SDL_Event evt;
-	uint32_t etype = MAKE_TAISEI_EVENT(TE_RESOURCE_ASYNC_LOADED);
+static void resource_finish_async_loads(void) {
+	if(!async_loader.pool) {
+		return;
+	}
+
+	assert(SDL_ThreadID() == main_thread_id);
 
-	while(SDL_PeepEvents(&evt, 1, SDL_GETEVENT, etype, etype)) {
-		resource_asyncload_handler(&evt, NULL);
+	SDL_LockMutex(async_loader.mutex);
+	ResourceAsyncLoadData *batch = async_loader.completed;
+	async_loader.completed = NULL;
+	SDL_UnlockMutex(async_loader.mutex);
+
+	// the queue is LIFO, restore the completion order
+	ResourceAsyncLoadData *ordered = NULL;
+
+	while(batch) {
+		ResourceAsyncLoadData *next = batch->next_completed;
+		batch->next_completed = ordered;
+		ordered = batch;
+		batch = next;
+	}
+
+	ResourceAsyncLoadData **tail = &async_loader.ready;
+
+	while(*tail) {
+		tail = &(*tail)->next_completed;
+	}
+
+	*tail = ordered;
+
+	// Items are taken off the ready list one at a time, since finishing one may request another
+	// resource (e.g. an animation needs its texture), which re-enters here. The nested call then
+	// finishes the rest of the list, instead of waiting for a completion that was already consumed.
+	while(async_loader.ready) {
+		ResourceAsyncLoadData *data = async_loader.ready;
+		async_loader.ready = data->next_completed;
+
+		char name[strlen(data->name) + 1];
+		strcpy(name, data->name);
+
+		load_resource_finish(data->opaque, data->handler, data->path, data->name, data->path, data->name, data->flags);
+		hashtable_unset(data->handler->async_load_data, name);
+		--async_loader.num_pending;
+
+		// wake up any other threads waiting for this resource
+		SDL_LockMutex(async_loader.mutex);
+		SDL_CondBroadcast(async_loader.cond);
+		SDL_UnlockMutex(async_loader.mutex);
+
+		if(data->batched && ++preload_batch.done == preload_batch.total) {
+			preload_batch.done = preload_batch.total = 0;
+		}
+
+		free(data);
 	}
 }
 
+void resource_update_async_loads(void) {
+	// this is called once per frame, and drives the eviction clock
+	++resource_clock;
+	resource_finish_async_loads();
+}
+
+double resource_preload_progress(void) {
+	if(!preload_batch.total) {
+		return 1;
+	}
+
+	return preload_batch.done / (double)preload_batch.total;
+}
+
+static void resource_wait_for_completion(void) {
+	SDL_LockMutex(async_loader.mutex);
+
+	while(!async_loader.completed) {
+		SDL_CondWait(async_loader.cond, async_loader.mutex);
+	}
+
+	SDL_UnlockMutex(async_loader.mutex);
+}
+
 static bool resource_check_async_load(ResourceHandler *handler, const char *name) {
 	if(SDL_ThreadID() == main_thread_id) {
-		update_async_load_state();
+		resource_finish_async_loads();
 	}
 
 	ResourceAsyncLoadData *data = hashtable_get_string(handler->async_load_data, name);
@@ -191,18 +315,36 @@ static bool resource_check_async_load(ResourceHandler *handler, const char *name
 }
 
 static void resource_wait_for_async_load(ResourceHandler *handler, const char *name) {
-	while(resource_check_async_load(handler, name));
+	if(SDL_ThreadID() == main_thread_id) {
+		while(resource_check_async_load(handler, name)) {
+			resource_wait_for_completion();
+		}
+
+		return;
+	}
+
+	if(!async_loader.pool) {
+		return;
+	}
+
+	// Only the main thread can finish the load; completions of other loads are no use to us.
+	// Checked under the mutex, so the broadcast that follows the hashtable_unset can't be missed.
+	SDL_LockMutex(async_loader.mutex);
+
+	while(hashtable_get_string(handler->async_load_data, name)) {
+		SDL_CondWait(async_loader.cond, async_loader.mutex);
+	}
+
+	SDL_UnlockMutex(async_loader.mutex);
 }
 
-static void resource_wait_for_all_async_loads(ResourceHandler *handler) {
-	char *key;
+static void resource_wait_for_all_async_loads(void) {
+	resource_finish_async_loads();
 
-	hashtable_lock(handler->async_load_data);
-	HashtableIterator *i = hashtable_iter(handler->async_load_data);
-	while(hashtable_iter_next(i, (void**)&key, NULL)) {
-		resource_check_async_load(handler, key);
+	while(async_loader.num_pending) {
+		resource_wait_for_completion();
+		resource_finish_async_loads();
 	}
-	hashtable_unlock(handler->async_load_data);
 }
 
 static Resource* load_resource(ResourceHandler *handler, const char *path, const char *name, ResourceFlags flags, bool async) {
@@ -239,6 +381,10 @@ static Resource* load_resource(ResourceHandler *handler, const char *path, const
 
 	assert(handler->check(path));
 
+	if(!async_loader.pool) {
+		async = false;
+	}
+
 	if(async) {
 		if(resource_check_async_load(handler, name)) {
 			return NULL;
@@ -286,8 +432,16 @@ static Resource* load_resource_finish(void *opaque, ResourceHandler *handler, co
 		return NULL;
 	}
 
+	size_t size;
+
+	if(handler->size) {
+		size = handler->size(raw);
+	} else {
+		size = vfs_query(path).size;
+	}
+
 	char *sp = vfs_repr(path, true);
-	Resource *res = insert_resource(handler->type, name, raw, flags, sp);
+	Resource *res = insert_resource_internal(handler->type, name, raw, flags, sp, size);
 	free(sp);
 
 	free(allocated_path);
@@ -298,16 +452,10 @@ static Resource* load_resource_finish(void *opaque, ResourceHandler *handler, co
 
 Resource* get_resource(ResourceType type, const char *name, ResourceFlags flags) {
 	ResourceHandler *handler = get_handler(type);
-	Resource *res;
-
-	if(flags & RESF_UNSAFE) {
-		res = hashtable_get_unsafe(handler->mapping, (void*)name);
-		flags &= ~RESF_UNSAFE;
-	} else {
-		res = hashtable_get(handler->mapping, (void*)name);
-	}
+	Resource *res = hashtable_get(handler->mapping, (void*)name);
 
 	if(res) {
+		res->last_used = resource_clock;
 		return res;
 	}
 
@@ -334,10 +482,26 @@ Resource* get_resource(ResourceType type, const char *name, ResourceFlags flags)
 	return res;
 }
 
+Resource* get_resource_interned(ResourceType type, const InternedString *name, ResourceFlags flags) {
+	Resource *res = hashtable_get_interned(get_handler(type)->mapping, name);
+
+	if(res && !(flags & RESF_PERMANENT)) {
+		res->last_used = resource_clock;
+		return res;
+	}
+
+	return get_resource(type, name->str, flags);
+}
+
 void preload_resource(ResourceType type, const char *name, ResourceFlags flags) {
 	if(getenvint("TAISEI_NOPRELOAD", false))
 		return;
 
+	if(recording_manifest) {
+		resource_manifest_add(recording_manifest, type, name, flags);
+		return;
+	}
+
 	ResourceHandler *handler = get_handler(type);
 
 	if(hashtable_get_string(handler->mapping, name) ||
@@ -359,45 +523,354 @@ void preload_resources(ResourceType type, ResourceFlags flags, const char *first
 	va_end(args);
 }
 
+static ResourceFlags merge_manifest_flags(ResourceFlags a, ResourceFlags b) {
+	// permanent if anyone wants it to be, optional only if nobody requires it
+	return ((a | b) & ~RESF_OPTIONAL) | (a & b & RESF_OPTIONAL);
+}
+
+static ResourceManifestEntry* resource_manifest_find(ResourceManifest *manifest, ResourceType type, const char *name) {
+	for(int i = 0; i < manifest->num_entries; ++i) {
+		ResourceManifestEntry *e = manifest->entries + i;
+
+		if(e->type == type && !strcmp(e->name, name)) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+static void resource_manifest_add_entry(ResourceManifest *manifest, ResourceType type, const char *name, ResourceFlags flags) {
+	ResourceManifestEntry *e = resource_manifest_find(manifest, type, name);
+
+	if(e) {
+		e->flags = merge_manifest_flags(e->flags, flags);
+		return;
+	}
+
+	if(manifest->num_entries == manifest->capacity) {
+		manifest->capacity = manifest->capacity ? manifest->capacity * 2 : 64;
+		manifest->entries = realloc(manifest->entries, manifest->capacity * sizeof(ResourceManifestEntry));
+	}
+
+	e = manifest->entries + manifest->num_entries++;
+	e->type = type;
+	e->flags = flags;
+	e->name = strdup(name);
+}
+
+void resource_manifest_add(ResourceManifest *manifest, ResourceType type, const char *name, ResourceFlags flags) {
+	if(type == RES_ANIM) {
+		// animations grab their texture in end_load, which would block if it's not there yet
+		resource_manifest_add_entry(manifest, RES_TEXTURE, name, flags);
+	}
+
+	resource_manifest_add_entry(manifest, type, name, flags);
+}
+
+void resource_manifest_free(ResourceManifest *manifest) {
+	for(int i = 0; i < manifest->num_entries; ++i) {
+		free(manifest->entries[i].name);
+	}
+
+	free(manifest->entries);
+	memset(manifest, 0, sizeof(ResourceManifest));
+}
+
+void resource_manifest_begin(ResourceManifest *manifest) {
+	assert(recording_manifest == NULL);
+	recording_manifest = manifest;
+}
+
+void resource_manifest_end(void) {
+	assert(recording_manifest != NULL);
+	recording_manifest = NULL;
+}
+
+typedef struct ManifestLoad {
+	ResourceManifestEntry *entry;
+	char *path;
+	uint64_t cost;
+} ManifestLoad;
+
+static int manifest_load_compare(const void *a, const void *b) {
+	const ManifestLoad *l1 = a;
+	const ManifestLoad *l2 = b;
+
+	int p1 = resource_load_priorities[l1->entry->type];
+	int p2 = resource_load_priorities[l2->entry->type];
+
+	if(p1 != p2) {
+		return p2 - p1;
+	}
+
+	// Within the same priority, start the most expensive loads first. Otherwise one big background that happens
+	// to be declared last ends up decoding alone on a single worker, while the rest of the pool sits idle.
+	// The order doesn't matter for dependencies (e.g. an animation's texture): those are resolved on the main
+	// thread when the dependent load is finished, and by then everything in the manifest has been submitted.
+	if(l1->cost != l2->cost) {
+		return (l1->cost < l2->cost) - (l1->cost > l2->cost);
+	}
+
+	// keep the declaration order otherwise
+	return (l1->entry > l2->entry) - (l1->entry < l2->entry);
+}
+
+static void resource_manifest_submit_internal(ResourceManifest *manifest, bool background) {
+	assert(recording_manifest != manifest);
+
+	if(!manifest->num_entries || getenvint("TAISEI_NOPRELOAD", false)) {
+		return;
+	}
+
+	ManifestLoad loads[manifest->num_entries];
+	int num_loads = 0;
+
+	for(int i = 0; i < manifest->num_entries; ++i) {
+		ResourceManifestEntry *e = manifest->entries + i;
+		ResourceHandler *handler = get_handler(e->type);
+		Resource *res = hashtable_get_string(handler->mapping, e->name);
+
+		if(res) {
+			if(e->flags & RESF_PERMANENT && !(res->flags & RESF_PERMANENT)) {
+				log_debug("Promoted %s '%s' to permanent", resource_type_names[e->type], e->name);
+				res->flags |= RESF_PERMANENT;
+			}
+
+			continue;
+		}
+
+		if(hashtable_get_string(handler->async_load_data, e->name)) {
+			continue;
+		}
+
+		// the size of the source file is a good enough estimate of how long the load is going to take.
+		// if the resource can't be located, load_resource() will report it.
+		ManifestLoad *l = loads + num_loads++;
+		l->entry = e;
+		l->path = handler->find(e->name);
+		l->cost = l->path ? vfs_query(l->path).size : 0;
+	}
+
+	log_debug("%i of %i resources in the manifest need loading", num_loads, manifest->num_entries);
+
+	if(!num_loads) {
+		return;
+	}
+
+	qsort(loads, num_loads, sizeof(*loads), manifest_load_compare);
+	preload_batch.submitting = true;
+	preload_batch.background = background;
+
+	for(int i = 0; i < num_loads; ++i) {
+		ResourceManifestEntry *e = loads[i].entry;
+		load_resource(get_handler(e->type), loads[i].path, e->name, e->flags | RESF_PRELOAD, !getenvint("TAISEI_NOASYNC", false));
+		free(loads[i].path);
+	}
+
+	preload_batch.submitting = false;
+	preload_batch.background = false;
+}
+
+void resource_manifest_submit(ResourceManifest *manifest) {
+	resource_manifest_submit_internal(manifest, false);
+}
+
+void resource_manifest_prefetch(ResourceManifest *manifest) {
+	if(!async_loader.pool) {
+		// a synchronous prefetch is just a stall at a random point
+		return;
+	}
+
+	log_debug("Prefetching %i resources", manifest->num_entries);
+	resource_manifest_submit_internal(manifest, true);
+}
+
+void resource_manifest_evict(ResourceManifest *evict, ResourceManifest *keep) {
+	bool models_unloaded = false;
+	int num_unloaded = 0;
+
+	for(int i = 0; i < evict->num_entries; ++i) {
+		ResourceManifestEntry *e = evict->entries + i;
+		ResourceHandler *handler = get_handler(e->type);
+
+		if(resource_manifest_find(keep, e->type, e->name)) {
+			continue;
+		}
+
+		if(e->type == RES_BGM && current_bgm.name && !strcmp(current_bgm.name, e->name)) {
+			// still referenced by the audio code
+			continue;
+		}
+
+		resource_wait_for_async_load(handler, e->name);
+		Resource *res = hashtable_get_string(handler->mapping, e->name);
+
+		if(!res || res->flags & RESF_PERMANENT) {
+			continue;
+		}
+
+		unload_resource(res);
+		hashtable_unset_string(handler->mapping, e->name);
+		log_debug("Evicted %s '%s'", resource_type_names[e->type], e->name);
+
+		models_unloaded |= (e->type == RES_MODEL);
+		++num_unloaded;
+	}
+
+	if(models_unloaded) {
+		vbo_compact(&_vbo);
+	}
+
+	log_debug("Evicted %i resources", num_unloaded);
+}
+
+typedef struct ResourceEvictionCandidate {
+	Resource *res;
+	char *name;
+} ResourceEvictionCandidate;
+
+static int resource_lru_compare(const void *a, const void *b) {
+	const Resource *r1 = ((const ResourceEvictionCandidate*)a)->res;
+	const Resource *r2 = ((const ResourceEvictionCandidate*)b)->res;
+
+	// the clock may wrap around; what matters is the distance from now
+	uint32_t age1 = resource_clock - r1->last_used;
+	uint32_t age2 = resource_clock - r2->last_used;
+
+	return (age1 < age2) - (age1 > age2);
+}
+
+static bool resource_is_evictable(ResourceHandler *handler, const char *name, Resource *res) {
+	if(res->flags & RESF_PERMANENT) {
+		return false;
+	}
+
+	switch(handler->type) {
+		case RES_SHADER:
+		case RES_POSTPROCESS:
+			// these are cheap, and pointers to them are stashed all over the place
+			return false;
+
+		case RES_TEXTURE:
+			// referenced by the animation of the same name
+			return !hashtable_get_string(get_handler(RES_ANIM)->mapping, name);
+
+		case RES_BGM:
+			return !current_bgm.name || strcmp(current_bgm.name, name);
+
+		default:
+			return true;
+	}
+}
+
+void resource_evict_to_budget(void) {
+	if(!resource_budget) {
+		return;
+	}
+
+	resource_wait_for_all_async_loads();
+
+	size_t total = 0;
+	int num_candidates = 0;
+
+	for(ResourceType type = 0; type < RES_NUMTYPES; ++type) {
+		total += get_handler(type)->resident_bytes;
+		num_candidates += get_handler(type)->num_resident;
+	}
+
+	if(total <= resource_budget) {
+		return;
+	}
+
+	ResourceEvictionCandidate *candidates = malloc(sizeof(ResourceEvictionCandidate) * num_candidates);
+	num_candidates = 0;
+
+	for(ResourceType type = 0; type < RES_NUMTYPES; ++type) {
+		ResourceHandler *handler = get_handler(type);
+		char *name;
+		Resource *res;
+		HashtableIterator i;
+
+		for(hashtable_iter_init(handler->mapping, &i); hashtable_iter_next(&i, (void**)&name, (void**)&res);) {
+			if(resource_is_evictable(handler, name, res)) {
+				candidates[num_candidates++] = (ResourceEvictionCandidate) { res, name };
+			}
+		}
+	}
+
+	qsort(candidates, num_candidates, sizeof(ResourceEvictionCandidate), resource_lru_compare);
+
+	int num_evicted = 0;
+	bool models_unloaded = false;
+
+	for(; num_evicted < num_candidates && total > resource_budget; ++num_evicted) {
+		Resource *res = candidates[num_evicted].res;
+		ResourceHandler *handler = get_handler(res->type);
+
+		// keys are interned, so the name outlives the table entry
+		const char *name = candidates[num_evicted].name;
+
+		log_debug("Evicted %s '%s' (%zu bytes, unused for %u frames)", resource_type_names[res->type], name, res->size, resource_clock - res->last_used);
+		models_unloaded |= (res->type == RES_MODEL);
+		total -= res->size;
+
+		hashtable_unset_string(handler->mapping, name);
+		unload_resource(res);
+	}
+
+	free(candidates);
+
+	if(models_unloaded) {
+		vbo_compact(&_vbo);
+	}
+
+	log_debug("Evicted %i resources, %zu bytes resident, budget is %zu", num_evicted, total, resource_budget);
+}
+
+void resource_get_stats(ResourceType type, ResourceStats *stats) {
+	ResourceHandler *handler = get_handler(type);
+	stats->tag = resource_type_names[type];
+	stats->resident_bytes = handler->resident_bytes;
+	stats->num_resident = handler->num_resident;
+}
+
 void init_resources(void) {
 	register_handler(
-		RES_TEXTURE, TEX_PATH_PREFIX, load_texture_begin, load_texture_end, (ResourceUnloadFunc)free_texture, NULL, texture_path, check_texture_path, HT_DYNAMIC_SIZE
+		RES_TEXTURE, TEX_PATH_PREFIX, load_texture_begin, load_texture_end, (ResourceUnloadFunc)free_texture, NULL, texture_path, check_texture_path, texture_size, HT_DYNAMIC_SIZE
 	);
 
 	register_handler(
-		RES_ANIM, ANI_PATH_PREFIX, load_animation_begin, load_animation_end, free, NULL, animation_path, check_animation_path, HT_DYNAMIC_SIZE
+		RES_ANIM, ANI_PATH_PREFIX, load_animation_begin, load_animation_end, free, NULL, animation_path, check_animation_path, NULL, HT_DYNAMIC_SIZE
 	);
 
 	register_handler(
-		RES_SHADER, SHA_PATH_PREFIX, load_shader_begin, load_shader_end, unload_shader, NULL, shader_path, check_shader_path, HT_DYNAMIC_SIZE
+		RES_SHADER, SHA_PATH_PREFIX, load_shader_begin, load_shader_end, unload_shader, NULL, shader_path, check_shader_path, NULL, HT_DYNAMIC_SIZE
 	);
 
 	register_handler(
-		RES_MODEL, MDL_PATH_PREFIX, load_model_begin, load_model_end, unload_model, NULL, model_path, check_model_path, HT_DYNAMIC_SIZE
+		RES_MODEL, MDL_PATH_PREFIX, load_model_begin, load_model_end, unload_model, NULL, model_path, check_model_path, model_size, HT_DYNAMIC_SIZE
 	);
 
 	register_handler(
-		RES_SFX, SFX_PATH_PREFIX, load_sound_begin, load_sound_end, unload_sound, NULL, sound_path, check_sound_path, HT_DYNAMIC_SIZE
+		RES_SFX, SFX_PATH_PREFIX, load_sound_begin, load_sound_end, unload_sound, NULL, sound_path, check_sound_path, sound_size, HT_DYNAMIC_SIZE
 	);
 
 	register_handler(
-		RES_BGM, BGM_PATH_PREFIX, load_bgm_begin, load_bgm_end, unload_bgm, NULL, bgm_path, check_bgm_path, HT_DYNAMIC_SIZE
+		RES_BGM, BGM_PATH_PREFIX, load_bgm_begin, load_bgm_end, unload_bgm, NULL, bgm_path, check_bgm_path, NULL, HT_DYNAMIC_SIZE
 	);
 
 	register_handler(
-		RES_POSTPROCESS, SHA_PATH_PREFIX, load_postprocess_begin, load_postprocess_end, unload_postprocess, NULL, postprocess_path, check_postprocess_path, HT_DYNAMIC_SIZE
+		RES_POSTPROCESS, SHA_PATH_PREFIX, load_postprocess_begin, load_postprocess_end, unload_postprocess, NULL, postprocess_path, check_postprocess_path, NULL, HT_DYNAMIC_SIZE
 	);
 
 	main_thread_id = SDL_ThreadID();
+	resource_budget = (size_t)getenvint("TAISEI_RESOURCE_BUDGET", 0) << 20;
 
 	if(!getenvint("TAISEI_NOASYNC", 0)) {
-		EventHandler h = {
-			.proc = resource_asyncload_handler,
-			.priority = EPRIO_SYSTEM,
-			.event_type = MAKE_TAISEI_EVENT(TE_RESOURCE_ASYNC_LOADED),
-		};
-
-		events_register_handler(&h);
+		async_loader.mutex = SDL_CreateMutex();
+		async_loader.cond = SDL_CreateCond();
+		async_loader.pool = threadpool_new("resource loader", getenvint("TAISEI_LOADER_THREADS", 0));
 	}
 
 	recolor_init();
@@ -433,21 +906,34 @@ void load_resources(void) {
 		load_shader_snippets(SHA_PATH_PREFIX "laser_snippets", "laser_", RESF_PERMANENT);
 	}
 
+	ResourceManifest manifest = { 0 };
+	resource_manifest_begin(&manifest);
 	menu_preload();
+	resource_manifest_end();
+	resource_manifest_submit(&manifest);
+	resource_manifest_free(&manifest);
+
 	resources.stage_postprocess = postprocess_load(SHA_PATH_PREFIX "postprocess.conf", RESF_PERMANENT | RESF_PRELOAD);
 }
 
 void free_resources(bool all) {
+	resource_wait_for_all_async_loads();
+
+	if(!all && resource_budget) {
+		// keep the cache warm, as long as it fits
+		resource_evict_to_budget();
+		return;
+	}
+
 	for(ResourceType type = 0; type < RES_NUMTYPES; ++type) {
 		ResourceHandler *handler = get_handler(type);
 
-		resource_wait_for_all_async_loads(handler);
-
 		char *name;
 		Resource *res;
 		ListContainer *unset_list = NULL;
+		HashtableIterator i;
 
-		for(HashtableIterator *i = hashtable_iter(handler->mapping); hashtable_iter_next(i, (void**)&name, (void**)&res);) {
+		for(hashtable_iter_init(handler->mapping, &i); hashtable_iter_next(&i, (void**)&name, (void**)&res);) {
 			if(!all && res->flags & RESF_PERMANENT)
 				continue;
 
@@ -470,10 +956,13 @@ void free_resources(bool all) {
 	}
 
 	if(!all) {
+		// reclaim the space of unloaded models
+		vbo_compact(&_vbo);
 		return;
 	}
 
 	delete_vbo(&_vbo);
+	texture_upload_shutdown();
 	postprocess_unload(&resources.stage_postprocess);
 	delete_fbo(&resources.fbo.bg[0]);
 	delete_fbo(&resources.fbo.bg[1]);
@@ -482,7 +971,10 @@ void free_resources(bool all) {
 	delete_fbo(&resources.fbo.rgba[0]);
 	delete_fbo(&resources.fbo.rgba[1]);
 
-	if(!getenvint("TAISEI_NOASYNC", 0)) {
-		events_unregister_handler(resource_asyncload_handler);
+	if(async_loader.pool) {
+		threadpool_free(async_loader.pool);
+		SDL_DestroyCond(async_loader.cond);
+		SDL_DestroyMutex(async_loader.mutex);
+		memset(&async_loader, 0, sizeof(async_loader));
 	}
 }
@@ -19,6 +19,7 @@
 #include "model.h"
 #include "postprocess.h"
 #include "hashtable.h"
+#include "intern.h"
 
 typedef enum ResourceType {
 	RES_TEXTURE,
@@ -35,7 +36,6 @@ typedef enum ResourceFlags {
 	RESF_OPTIONAL = 1,
 	RESF_PERMANENT = 2,
 	RESF_PRELOAD = 4,
-	RESF_UNSAFE = 8,
 } ResourceFlags;
 
 #define RESF_DEFAULT 0
@@ -67,6 +67,10 @@ typedef void* (*ResourceEndLoadFunc)(void *opaque, const char *path, unsigned in
 // Unloads a resource, freeing all allocated to it memory.
 typedef void (*ResourceUnloadFunc)(void *res);
 
+// Estimates how much memory a loaded resource occupies, in bytes.
+// This method is optional, the default is the size of the file it was loaded from.
+typedef size_t (*ResourceSizeFunc)(void *res);
+
 typedef struct ResourceHandler {
 	ResourceType type;
 	ResourceNameFunc name;
@@ -75,14 +79,20 @@ typedef struct ResourceHandler {
 	ResourceBeginLoadFunc begin_load;
 	ResourceEndLoadFunc end_load;
 	ResourceUnloadFunc unload;
+	ResourceSizeFunc size;
 	Hashtable *mapping;
 	Hashtable *async_load_data;
 	char subdir[32];
+
+	size_t resident_bytes;
+	int num_resident;
 } ResourceHandler;
 
 typedef struct Resource {
 	ResourceType type;
 	ResourceFlags flags;
+	size_t size;
+	uint32_t last_used;
 
 	union {
 		void *data;
@@ -110,15 +120,65 @@ typedef struct Resources {
 
 extern Resources resources;
 
+typedef struct ResourceStats {
+	const char *tag;
+	size_t resident_bytes;
+	int num_resident;
+} ResourceStats;
+
+typedef struct ResourceManifestEntry {
+	ResourceType type;
+	ResourceFlags flags;
+	char *name;
+} ResourceManifestEntry;
+
+// A list of resources to be preloaded together as a single batch.
+// Zero-initialize before use.
+typedef struct ResourceManifest {
+	ResourceManifestEntry *entries;
+	int num_entries;
+	int capacity;
+} ResourceManifest;
+
 void init_resources(void);
 void load_resources(void);
 void free_resources(bool all);
 
 Resource* get_resource(ResourceType type, const char *name, ResourceFlags flags);
+Resource* get_resource_interned(ResourceType type, const InternedString *name, ResourceFlags flags);
 Resource* insert_resource(ResourceType type, const char *name, void *data, ResourceFlags flags, const char *source);
 void preload_resource(ResourceType type, const char *name, ResourceFlags flags);
 void preload_resources(ResourceType type, ResourceFlags flags, const char *firstname, ...) __attribute__((sentinel));
 
+void resource_manifest_add(ResourceManifest *manifest, ResourceType type, const char *name, ResourceFlags flags);
+void resource_manifest_free(ResourceManifest *manifest);
+
+// While recording, preload_resource() and preload_resources() add to the manifest instead of loading anything.
+void resource_manifest_begin(ResourceManifest *manifest);
+void resource_manifest_end(void);
+
+// Submits everything in the manifest that isn't loaded yet, in priority order.
+void resource_manifest_submit(ResourceManifest *manifest);
+
+// Like resource_manifest_submit(), but below the priority of any regular load, and not counted in the progress.
+void resource_manifest_prefetch(ResourceManifest *manifest);
+
+// Unloads the transient resources listed in evict that aren't also listed in keep.
+void resource_manifest_evict(ResourceManifest *evict, ResourceManifest *keep);
+
+// Fraction of the submitted manifest loads that have finished, in the [0, 1] range. 1 if nothing is pending.
+double resource_preload_progress(void);
+
+// Unloads the least recently used transient resources until the total size fits into the budget (TAISEI_RESOURCE_BUDGET, in MiB).
+// Only call this when nothing holds on to resource pointers across frames, e.g. between stages.
+void resource_evict_to_budget(void);
+
+void resource_get_stats(ResourceType type, ResourceStats *stats);
+
+// Finishes the asynchronous loads that completed since the last call and advances the clock used
+// for eviction. Call this once per frame, from the main thread.
+void resource_update_async_loads(void);
+
 void resource_util_strip_ext(char *path);
 char* resource_util_basename(const char *prefix, const char *path);
 const char* resource_util_filename(const char *path);
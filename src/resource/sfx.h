@@ -9,6 +9,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct Sound {
 	int lastplayframe;
@@ -21,5 +22,6 @@ bool check_sound_path(const char *path);
 void* load_sound_begin(const char *path, unsigned int flags);
 void* load_sound_end(void *opaque, const char *path, unsigned int flags);
 void unload_sound(void *snd);
+size_t sound_size(void *snd);
 
 #define SFX_PATH_PREFIX "res/sfx/"
@@ -22,7 +22,7 @@ bool check_sound_path(const char *path) {
 }
 
 void* load_sound_begin(const char *path, unsigned int flags) {
-	SDL_RWops *rwops = vfs_open(path, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+	SDL_RWops *rwops = vfs_open(path, VFS_MODE_READ | VFS_MODE_SEEKABLE | VFS_MODE_MAP);
 
 	if(!rwops) {
 		log_warn("VFS error: %s", vfs_get_error());
@@ -67,3 +67,8 @@ void unload_sound(void *vsnd) {
 	free(snd->impl);
 	free(snd);
 }
+
+size_t sound_size(void *vsnd) {
+	Sound *snd = vsnd;
+	return sizeof(Sound) + sizeof(MixerInternalSound) + ((MixerInternalSound *)snd->impl)->ch->alen;
+}
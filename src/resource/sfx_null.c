@@ -14,3 +14,4 @@ bool check_sound_path(const char *path) { return NULL; }
 void* load_sound_begin(const char *path, unsigned int flags) { return NULL; }
 void* load_sound_end(void *opaque, const char *path, unsigned int flags) { return NULL; }
 void unload_sound(void *vmus) { }
+size_t sound_size(void *vsnd) { return 0; }
@@ -224,7 +224,7 @@ static void cache_uniforms(Shader *sha) {
 	GLenum tmpt;
 	GLint unicount;
 
-	sha->uniforms = hashtable_new_stringkeys(13);
+	sha->uniforms = hashtable_new_internedkeys(13);
 
 	glGetProgramiv(sha->prog, GL_ACTIVE_UNIFORMS, &unicount);
 	glGetProgramiv(sha->prog, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxlen);
@@ -249,14 +249,145 @@ static void cache_uniforms(Shader *sha) {
 #endif
 }
 
+/*
+ *  Program binary cache
+ *
+ *  Linked programs are stored in storage/shadercache, keyed by a hash of their sources and the
+ *  GL vendor, renderer and version strings, so that a driver update invalidates them. If the
+ *  driver rejects a cached binary anyway, we just recompile from source and replace it.
+ */
+
+#define SHADER_CACHE_DIR "storage/shadercache"
+#define SHADER_CACHE_MAGIC 0x31434853 // "SHC1"
+#define SHADER_CACHE_VERSION 1
+
+static bool shader_cache_enabled(void) {
+	return glext.get_program_binary && getenvint("TAISEI_SHADER_CACHE", true);
+}
+
+static uint64_t shader_cache_hash(uint64_t hash, const char *str) {
+	// FNV-1a
+	if(str) {
+		for(const uint8_t *c = (const uint8_t*)str; *c; ++c) {
+			hash = (hash ^ *c) * 0x100000001b3ULL;
+		}
+	}
+
+	// terminator, so that ("ab", "c") and ("a", "bc") hash differently
+	return hash * 0x100000001b3ULL;
+}
+
+static uint64_t shader_cache_key(const char *vheader, const char *fheader, const char *vtext, const char *ftext) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	hash = shader_cache_hash(hash, (const char*)glGetString(GL_VENDOR));
+	hash = shader_cache_hash(hash, (const char*)glGetString(GL_RENDERER));
+	hash = shader_cache_hash(hash, (const char*)glGetString(GL_VERSION));
+	hash = shader_cache_hash(hash, vheader);
+	hash = shader_cache_hash(hash, vtext);
+	hash = shader_cache_hash(hash, fheader);
+	hash = shader_cache_hash(hash, ftext);
+
+	return hash;
+}
+
+static char* shader_cache_path(uint64_t key) {
+	return strfmt(SHADER_CACHE_DIR "/%016"PRIx64".bin", key);
+}
+
+static bool shader_cache_load(Shader *sha, uint64_t key) {
+	char *path = shader_cache_path(key);
+	SDL_RWops *rw = vfs_open(path, VFS_MODE_READ | VFS_MODE_MAP);
+	bool ok = false;
+
+	if(!rw) {
+		free(path);
+		return false;
+	}
+
+	if(
+		SDL_ReadLE32(rw) == SHADER_CACHE_MAGIC &&
+		SDL_ReadLE32(rw) == SHADER_CACHE_VERSION &&
+		SDL_ReadLE64(rw) == key
+	) {
+		GLenum format = SDL_ReadLE32(rw);
+		uint32_t length = SDL_ReadLE32(rw);
+		int64_t remaining = SDL_RWsize(rw) - SDL_RWtell(rw);
+		void *binary = NULL;
+
+		// don't trust the header with the allocation size; the file may be truncated or corrupt
+		if(length && SDL_RWsize(rw) >= 0 && length <= remaining) {
+			binary = malloc(length);
+		} else {
+			log_warn("Cached program binary %s is corrupt, recompiling", path);
+		}
+
+		if(binary && SDL_RWread(rw, binary, length, 1) == 1) {
+			GLint status = 0;
+			glProgramBinary(sha->prog, format, binary, length);
+			glGetProgramiv(sha->prog, GL_LINK_STATUS, &status);
+
+			if(!(ok = status)) {
+				log_info("Cached program binary %s was rejected by the driver, recompiling", path);
+			}
+		}
+
+		free(binary);
+	}
+
+	SDL_RWclose(rw);
+	free(path);
+	return ok;
+}
+
+static void shader_cache_store(Shader *sha, uint64_t key) {
+	GLint length = 0;
+	glGetProgramiv(sha->prog, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if(length <= 0) {
+		return;
+	}
+
+	void *binary = malloc(length);
+	GLenum format;
+	glGetProgramBinary(sha->prog, length, &length, &format, binary);
+
+	if(!vfs_mkdir(SHADER_CACHE_DIR)) {
+		log_warn("VFS error: %s", vfs_get_error());
+		free(binary);
+		return;
+	}
+
+	char *path = shader_cache_path(key);
+	SDL_RWops *rw = vfs_open(path, VFS_MODE_WRITE);
+
+	if(!rw) {
+		log_warn("VFS error: %s", vfs_get_error());
+	} else {
+		if(!(
+			SDL_WriteLE32(rw, SHADER_CACHE_MAGIC) &&
+			SDL_WriteLE32(rw, SHADER_CACHE_VERSION) &&
+			SDL_WriteLE64(rw, key) &&
+			SDL_WriteLE32(rw, format) &&
+			SDL_WriteLE32(rw, length) &&
+			SDL_RWwrite(rw, binary, length, 1) == 1
+		)) {
+			log_warn("Couldn't write program binary %s: %s", path, SDL_GetError());
+		}
+
+		SDL_RWclose(rw);
+	}
+
+	free(path);
+	free(binary);
+}
+
 static Shader* load_shader(const char *vheader, const char *fheader, const char *vtext, const char *ftext) {
 	Shader *sha = calloc(1, sizeof(Shader));
 	GLuint vshaderobj;
 	GLuint fshaderobj;
-
-	sha->prog = glCreateProgram();
-	vshaderobj = glCreateShader(GL_VERTEX_SHADER);
-	fshaderobj = glCreateShader(GL_FRAGMENT_SHADER);
+	uint64_t cache_key = 0;
+	bool use_cache = shader_cache_enabled();
 
 	if(!vheader) {
 		vheader = "";
@@ -266,6 +397,25 @@ static Shader* load_shader(const char *vheader, const char *fheader, const char
 		fheader = "";
 	}
 
+	sha->prog = glCreateProgram();
+
+	if(use_cache) {
+		cache_key = shader_cache_key(vheader, fheader, vtext, ftext);
+
+		if(shader_cache_load(sha, cache_key)) {
+			cache_uniforms(sha);
+			return sha;
+		}
+
+		// the failed glProgramBinary left this program in an unusable state
+		glDeleteProgram(sha->prog);
+		sha->prog = glCreateProgram();
+		glProgramParameteri(sha->prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	vshaderobj = glCreateShader(GL_VERTEX_SHADER);
+	fshaderobj = glCreateShader(GL_FRAGMENT_SHADER);
+
 	const GLchar *v_sources[] = { vheader, vtext };
 	const GLchar *f_sources[] = { fheader, ftext };
 	GLint lengths[] = { -1, -1 };
@@ -305,6 +455,10 @@ static Shader* load_shader(const char *vheader, const char *fheader, const char
 		return NULL;
 	}
 
+	if(use_cache) {
+		shader_cache_store(sha, cache_key);
+	}
+
 	cache_uniforms(sha);
 
 	return sha;
@@ -314,8 +468,12 @@ int uniloc(Shader *sha, const char *name) {
 	return (intptr_t)hashtable_get_string(sha->uniforms, name) - 1;
 }
 
+int uniloc_interned(Shader *sha, const InternedString *name) {
+	return (intptr_t)hashtable_get_interned(sha->uniforms, name) - 1;
+}
+
 Shader* get_shader(const char *name) {
-	return get_resource(RES_SHADER, name, RESF_DEFAULT | RESF_UNSAFE)->shader;
+	return get_resource(RES_SHADER, name, RESF_DEFAULT)->shader;
 }
 
 Shader* get_shader_optional(const char *name) {
@@ -11,6 +11,7 @@
 #include <stdbool.h>
 #include "taiseigl.h"
 #include "hashtable.h"
+#include "intern.h"
 
 typedef struct Shader {
 	GLuint prog;
@@ -29,6 +30,7 @@ Shader* get_shader(const char *name);
 Shader* get_shader_optional(const char *name);
 
 int uniloc(Shader *sha, const char *name);
+int uniloc_interned(Shader *sha, const InternedString *name);
 
 #define SHA_PATH_PREFIX "res/shader/"
 #define SHA_EXTENSION ".sha"
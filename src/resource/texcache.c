@@ -0,0 +1,87 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "texcache.h"
+#include "rescache.h"
+#include "global.h"
+
+static const ResCacheType texcache_type = {
+	.dir = "storage/texcache",
+	.extension = ".tex",
+	.envvar = "TAISEI_TEXTURE_CACHE",
+	.magic = 0x31435854, // "TXC1"
+	.version = 2,
+};
+
+typedef struct TexCachePayload {
+	uint32_t w, h;
+	uint32_t truew, trueh;
+	uint32_t pixels[];
+} TexCachePayload;
+
+bool texcache_load(const char *srcpath, TextureData *tdata) {
+	TexCachePayload *p;
+	size_t size;
+	ResCacheBuffer *buf = rescache_load(&texcache_type, srcpath, (void**)&p, &size);
+
+	if(!buf) {
+		return false;
+	}
+
+	if(
+		size < sizeof(TexCachePayload) ||
+		p->w > p->truew || p->h > p->trueh ||
+		size < sizeof(TexCachePayload) + (size_t)p->truew * p->trueh * sizeof(uint32_t)
+	) {
+		log_warn("Texture cache entry for %s is corrupt", srcpath);
+		rescache_release(buf);
+		return false;
+	}
+
+	tdata->w = p->w;
+	tdata->h = p->h;
+	tdata->truew = p->truew;
+	tdata->trueh = p->trueh;
+	tdata->pixels = p->pixels;
+	tdata->cache_buffer = buf;
+
+	return true;
+}
+
+void texcache_store(const char *srcpath, TextureData *tdata) {
+	SDL_RWops *rw = rescache_store(&texcache_type, srcpath);
+
+	if(!rw) {
+		return;
+	}
+
+	TexCachePayload p = {
+		.w = tdata->w,
+		.h = tdata->h,
+		.truew = tdata->truew,
+		.trueh = tdata->trueh,
+	};
+
+	size_t datasize = (size_t)tdata->truew * tdata->trueh * sizeof(uint32_t);
+
+	if(
+		SDL_RWwrite(rw, &p, sizeof(p), 1) != 1 ||
+		SDL_RWwrite(rw, tdata->pixels, datasize, 1) != 1
+	) {
+		// a truncated entry will fail validation on the next load
+		log_warn("Couldn't write texture cache entry for %s: %s", srcpath, SDL_GetError());
+	}
+
+	SDL_RWclose(rw);
+}
+
+void texcache_release(TextureData *tdata) {
+	rescache_release(tdata->cache_buffer);
+	tdata->cache_buffer = NULL;
+	tdata->pixels = NULL;
+}
@@ -0,0 +1,21 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "texture.h"
+
+/*
+ *  On-disk cache of upload-ready texture data, kept in storage/texcache (see rescache.h).
+ *  Set TAISEI_TEXTURE_CACHE=0 to disable.
+ */
+
+bool texcache_load(const char *srcpath, TextureData *tdata);
+void texcache_store(const char *srcpath, TextureData *tdata);
+void texcache_release(TextureData *tdata);
@@ -9,9 +9,12 @@
 #include <png.h>
 
 #include "texture.h"
+#include "texcache.h"
 #include "resource.h"
 #include "global.h"
 #include "vbo.h"
+#include "threadpool.h"
+#include "hirestime.h"
 
 char* texture_path(const char *name) {
 	return strjoin(TEX_PATH_PREFIX, name, TEX_EXTENSION, NULL);
@@ -29,9 +32,34 @@ typedef struct ImageData {
 } ImageData;
 
 static ImageData* load_png(const char *filename);
+static uint32_t* texture_prepare_pixels(uint32_t *pixels, int w, int h, int *nw, int *nh);
+static void texture_upload(Texture *texture, TextureData *tdata);
 
 void* load_texture_begin(const char *path, unsigned int flags) {
-	return load_png(path);
+	// everything that doesn't need the GL context happens here, on the loader thread
+	TextureData *tdata = malloc(sizeof(TextureData));
+
+	if(texcache_load(path, tdata)) {
+		return tdata;
+	}
+
+	ImageData *img = load_png(path);
+
+	if(!img) {
+		free(tdata);
+		return NULL;
+	}
+
+	tdata->w = img->width;
+	tdata->h = img->height;
+	tdata->pixels = texture_prepare_pixels(img->pixels, img->width, img->height, &tdata->truew, &tdata->trueh);
+	tdata->cache_buffer = NULL;
+
+	free(img->pixels);
+	free(img);
+
+	texcache_store(path, tdata);
+	return tdata;
 }
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
@@ -58,42 +86,41 @@ void* load_texture_begin(const char *path, unsigned int flags) {
 } while(0)
 
 void* load_texture_end(void *opaque, const char *path, unsigned int flags) {
-	SDL_Surface *surface;
-	ImageData *img = opaque;
+	TextureData *tdata = opaque;
 
-	if(!img) {
+	if(!tdata) {
 		return NULL;
 	}
 
-	surface = SDL_CreateRGBSurfaceFrom(img->pixels, img->width, img->height, img->depth * 4, 0, CLRMASK(R), CLRMASK(G), CLRMASK(B), CLRMASK(A));
+	Texture *texture = malloc(sizeof(Texture));
+	texture_upload(texture, tdata);
 
-	if(!surface) {
-		log_warn("SDL_CreateRGBSurfaceFrom(): failed: %s", SDL_GetError());
-		free(img);
-		return NULL;
+	if(tdata->cache_buffer) {
+		texcache_release(tdata);
+	} else {
+		free(tdata->pixels);
 	}
 
-	Texture *texture = malloc(sizeof(Texture));
-
-	load_sdl_surf(surface, texture);
-	free(surface->pixels);
-	SDL_FreeSurface(surface);
-	free(img);
+	free(tdata);
 
 	return texture;
 }
 
 Texture* get_tex(const char *name) {
-	return get_resource(RES_TEXTURE, name, RESF_DEFAULT | RESF_UNSAFE)->texture;
+	return get_resource(RES_TEXTURE, name, RESF_DEFAULT)->texture;
 }
 
 Texture* prefix_get_tex(const char *name, const char *prefix) {
-	char *full = strjoin(prefix, name, NULL);
-	Texture *tex = get_tex(full);
-	free(full);
+	MemArenaMark mark = marena_mark(&frame_arena);
+	Texture *tex = get_tex(marena_strjoin(&frame_arena, prefix, name, NULL));
+	marena_rewind(&frame_arena, mark);
 	return tex;
 }
 
+Texture* get_tex_interned(const InternedString *name) {
+	return get_resource_interned(RES_TEXTURE, name, RESF_DEFAULT)->texture;
+}
+
 static ImageData* load_png_p(const char *filename, SDL_RWops *rwops) {
 #define PNGFAIL(msg) { log_warn("Couldn't load '%s': %s", filename, msg); return NULL; }
 	png_structp png_ptr;
@@ -156,7 +183,7 @@ static ImageData* load_png_p(const char *filename, SDL_RWops *rwops) {
 }
 
 static ImageData* load_png(const char *filename) {
-	SDL_RWops *rwops = vfs_open(filename, VFS_MODE_READ);
+	SDL_RWops *rwops = vfs_open(filename, VFS_MODE_READ | VFS_MODE_MAP);
 
 	if(!rwops) {
 		log_warn("VFS error: %s", vfs_get_error());
@@ -245,20 +272,12 @@ static uint_fast32_t nearest_with_best_alpha(
 	return result;
 }
 
-void load_sdl_surf(SDL_Surface *surface, Texture *texture) {
-	glGenTextures(1, &texture->gltex);
-	glBindTexture(GL_TEXTURE_2D, texture->gltex);
-
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
+static uint32_t* texture_prepare_pixels(uint32_t *pixels, int w, int h, int *out_nw, int *out_nh) {
 	int nw = 2;
 	int nh = 2;
 
-	while(nw < surface->w) nw *= 2;
-	while(nh < surface->h) nh *= 2;
+	while(nw < w) nw *= 2;
+	while(nh < h) nh *= 2;
 
 	uint32_t *tex = calloc(sizeof(uint32_t), nw*nh);
 	uint32_t clr;
@@ -266,23 +285,15 @@ void load_sdl_surf(SDL_Surface *surface, Texture *texture) {
 
 	for(y = 0; y < nh; y++) {
 		for(x = 0; x < nw; x++) {
-			if(y < surface->h && x < surface->w) {
-				clr = ((uint32_t*)surface->pixels)[y*surface->w+x];
+			if(y < h && x < w) {
+				clr = pixels[y*w+x];
 			} else {
 				clr = '\0';
 			}
 
-			if(y == nh-1 || x == nw-1 || (y <= surface->h && x <= surface->w)) {
+			if(y == nh-1 || x == nw-1 || (y <= h && x <= w)) {
 				if(!(clr & CLRMASK(A))) {
-					clr = nearest_with_best_alpha(
-						(uint32_t*)surface->pixels,
-						surface->w,
-						x,
-						y,
-						nw,
-						nh,
-						surface->h * surface->w
-					);
+					clr = nearest_with_best_alpha(pixels, w, x, y, nw, nh, h * w);
 				}
 			}
 
@@ -290,16 +301,93 @@ void load_sdl_surf(SDL_Surface *surface, Texture *texture) {
 		}
 	}
 
-	texture->w = surface->w;
-	texture->h = surface->h;
+	*out_nw = nw;
+	*out_nh = nh;
 
-	texture->truew = nw;
-	texture->trueh = nh;
+	return tex;
+}
 
+#define TEXTURE_UPLOAD_BUFFERS 2
 
-	glTexImage2D(GL_TEXTURE_2D, 0, 4, nw, nh, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex);
+typedef struct TextureUploadBuffer {
+	GLuint pbo;
+} TextureUploadBuffer;
 
-	free(tex);
+static TextureUploadBuffer texture_upload_buffers[TEXTURE_UPLOAD_BUFFERS];
+static int upload_buffer_next;
+
+static void texture_upload(Texture *texture, TextureData *tdata) {
+	glGenTextures(1, &texture->gltex);
+	glBindTexture(GL_TEXTURE_2D, texture->gltex);
+
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	texture->w = tdata->w;
+	texture->h = tdata->h;
+	texture->truew = tdata->truew;
+	texture->trueh = tdata->trueh;
+
+	size_t size = tdata->truew * tdata->trueh * sizeof(uint32_t);
+	void *pixels = tdata->pixels;
+	TextureUploadBuffer *ubuf = NULL;
+
+	if(glext.pixel_buffer_object && getenvint("TAISEI_TEXTURE_PBO", true)) {
+		// Stage the pixels in a pixel buffer object, so that the driver can do the actual
+		// transfer asynchronously instead of stalling us inside glTexImage2D. The buffers are
+		// reused round-robin; re-specifying the storage orphans the previous contents, so we
+		// never wait for an earlier upload that is still in flight.
+		ubuf = texture_upload_buffers + upload_buffer_next;
+		upload_buffer_next = (upload_buffer_next + 1) % TEXTURE_UPLOAD_BUFFERS;
+
+		if(!ubuf->pbo) {
+			glGenBuffers(1, &ubuf->pbo);
+		}
+
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ubuf->pbo);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+		void *mapped = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+
+		if(mapped) {
+			memcpy(mapped, tdata->pixels, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			pixels = NULL;
+		} else {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			ubuf = NULL;
+		}
+	}
+
+	glTexImage2D(GL_TEXTURE_2D, 0, 4, tdata->truew, tdata->trueh, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	if(ubuf) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+}
+
+void texture_upload_shutdown(void) {
+	for(int i = 0; i < TEXTURE_UPLOAD_BUFFERS; ++i) {
+		if(texture_upload_buffers[i].pbo) {
+			glDeleteBuffers(1, &texture_upload_buffers[i].pbo);
+		}
+	}
+
+	memset(texture_upload_buffers, 0, sizeof(texture_upload_buffers));
+	upload_buffer_next = 0;
+}
+
+void load_sdl_surf(SDL_Surface *surface, Texture *texture) {
+	TextureData tdata = {
+		.w = surface->w,
+		.h = surface->h,
+		.cache_buffer = NULL,
+	};
+
+	tdata.pixels = texture_prepare_pixels(surface->pixels, surface->w, surface->h, &tdata.truew, &tdata.trueh);
+	texture_upload(texture, &tdata);
+	free(tdata.pixels);
 }
 
 void free_texture(Texture *tex) {
@@ -307,6 +395,12 @@ void free_texture(Texture *tex) {
 	free(tex);
 }
 
+size_t texture_size(void *vtex) {
+	// what the driver is likely to allocate for the RGBA8 storage, ignoring alignment
+	Texture *tex = vtex;
+	return sizeof(Texture) + (size_t)tex->truew * tex->trueh * 4;
+}
+
 void draw_texture(float x, float y, const char *name) {
 	draw_texture_p(x, y, get_tex(name));
 }
@@ -421,3 +515,172 @@ void loop_tex_line_p(complex a, complex b, float w, float t, Texture *texture) {
 void loop_tex_line(complex a, complex b, float w, float t, const char *texture) {
 	loop_tex_line_p(a, b, w, t, get_tex(texture));
 }
+
+typedef struct TextureBenchFile {
+	char *path;
+	uint64_t file_size;
+	uint64_t decoded_size;
+	hrtime_t serial_time;
+} TextureBenchFile;
+
+typedef struct TextureBenchList {
+	TextureBenchFile *files;
+	size_t num;
+	size_t capacity;
+} TextureBenchList;
+
+static void texture_bench_collect(TextureBenchList *list, const char *dir) {
+	size_t num;
+	char **entries = vfs_dir_list_sorted(dir, &num, vfs_dir_list_order_ascending, NULL);
+
+	if(!entries) {
+		log_warn("VFS error: %s", vfs_get_error());
+		return;
+	}
+
+	for(size_t i = 0; i < num; ++i) {
+		char *path = strfmt("%s/%s", dir, entries[i]);
+		VFSInfo info = vfs_query(path);
+
+		if(info.is_dir) {
+			texture_bench_collect(list, path);
+			free(path);
+		} else if(check_texture_path(path)) {
+			if(list->num == list->capacity) {
+				list->capacity = list->capacity ? list->capacity * 2 : 64;
+				list->files = realloc(list->files, list->capacity * sizeof(TextureBenchFile));
+			}
+
+			list->files[list->num++] = (TextureBenchFile) {
+				.path = path,
+				.file_size = info.size,
+			};
+		} else {
+			free(path);
+		}
+	}
+
+	vfs_dir_list_free(entries, num);
+}
+
+static void texture_bench_decode(void *arg) {
+	// everything load_texture_begin() does for an uncached texture
+	TextureBenchFile *f = arg;
+	ImageData *img = load_png(f->path);
+
+	if(img) {
+		int w, h;
+		free(texture_prepare_pixels(img->pixels, img->width, img->height, &w, &h));
+		f->decoded_size = (uint64_t)img->width * img->height * sizeof(uint32_t);
+		free(img->pixels);
+		free(img);
+	}
+}
+
+static int texture_bench_compare_size(const void *a, const void *b) {
+	const TextureBenchFile *f1 = *(TextureBenchFile**)a;
+	const TextureBenchFile *f2 = *(TextureBenchFile**)b;
+	return (f1->file_size < f2->file_size) - (f1->file_size > f2->file_size);
+}
+
+static void texture_bench_report(const char *pass, int threads, hrtime_t time, uint64_t in, uint64_t out) {
+	tsfprintf(stdout, "%-24s %2i thread(s): %8.1f ms, %7.1f MB/s in, %7.1f MB/s decoded\n",
+		pass, threads, (double)(time * 1000), in / 1e6 / (double)time, out / 1e6 / (double)time);
+}
+
+static SDL_sem *texture_bench_done;
+
+static void texture_bench_decode_task(void *arg) {
+	texture_bench_decode(arg);
+	SDL_SemPost(texture_bench_done);
+}
+
+static hrtime_t texture_bench_pass(TextureBenchFile **order, size_t num, int *threads) {
+	// the pool's startup and shutdown are not part of the decoding work, keep them out of the timing
+	ThreadPool *pool = threadpool_new("texture benchmark", getenvint("TAISEI_LOADER_THREADS", 0));
+	*threads = threadpool_num_threads(pool);
+	texture_bench_done = SDL_CreateSemaphore(0);
+
+	hrtime_t start = time_get();
+
+	for(size_t i = 0; i < num; ++i) {
+		// equal priorities start in submission order
+		threadpool_submit(pool, texture_bench_decode_task, order[i], 0);
+	}
+
+	for(size_t i = 0; i < num; ++i) {
+		SDL_SemWait(texture_bench_done);
+	}
+
+	hrtime_t time = time_get() - start;
+
+	threadpool_free(pool);
+	SDL_DestroySemaphore(texture_bench_done);
+	texture_bench_done = NULL;
+
+	return time;
+}
+
+void texture_benchmark(void) {
+	TextureBenchList list = { 0 };
+	char dir[] = TEX_PATH_PREFIX;
+	*strrchr(dir, '/') = 0;
+	texture_bench_collect(&list, dir);
+
+	if(!list.num) {
+		log_warn("No textures found in %s", dir);
+		return;
+	}
+
+	// warm up the page cache first, so that the first pass isn't penalized
+	for(size_t i = 0; i < list.num; ++i) {
+		const void *data;
+		size_t size;
+		vfs_unmap(vfs_map(list.files[i].path, &data, &size));
+	}
+
+	uint64_t in = 0, out = 0;
+	hrtime_t serial_time = 0, longest = 0;
+	TextureBenchFile *longest_file = list.files;
+
+	for(size_t i = 0; i < list.num; ++i) {
+		TextureBenchFile *f = list.files + i;
+		hrtime_t start = time_get();
+		texture_bench_decode(f);
+		f->serial_time = time_get() - start;
+		serial_time += f->serial_time;
+		in += f->file_size;
+		out += f->decoded_size;
+
+		if(f->serial_time > longest) {
+			longest = f->serial_time;
+			longest_file = f;
+		}
+	}
+
+	tsfprintf(stdout, "%zu textures, %.1f MB on disk, %.1f MB decoded\n", list.num, in / 1e6, out / 1e6);
+	texture_bench_report("serial", 1, serial_time, in, out);
+
+	TextureBenchFile *order[list.num];
+	int threads;
+
+	for(size_t i = 0; i < list.num; ++i) {
+		order[i] = list.files + i;
+	}
+
+	hrtime_t time = texture_bench_pass(order, list.num, &threads);
+	texture_bench_report("pool, listing order", threads, time, in, out);
+
+	qsort(order, list.num, sizeof(*order), texture_bench_compare_size);
+	time = texture_bench_pass(order, list.num, &threads);
+	texture_bench_report("pool, biggest first", threads, time, in, out);
+
+	tsfprintf(stdout, "Longest single decode: %.1f ms (%s); no schedule can finish faster than that\n",
+		(double)(longest * 1000), longest_file->path);
+
+	for(size_t i = 0; i < list.num; ++i) {
+		free(list.files[i].path);
+	}
+
+	free(list.files);
+}
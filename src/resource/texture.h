@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include "taiseigl.h"
 #include "util.h"
+#include "intern.h"
 
 typedef struct Texture Texture;
 
@@ -21,6 +22,16 @@ struct Texture {
 	GLuint gltex;
 };
 
+// Upload-ready pixel data: padded to power-of-two dimensions and alpha-bled.
+typedef struct TextureData {
+	int w, h;
+	int truew, trueh;
+	uint32_t *pixels;
+
+	// if set, pixels point into this buffer, owned by the texture cache
+	void *cache_buffer;
+} TextureData;
+
 char* texture_path(const char *name);
 void* load_texture_begin(const char *path, unsigned int flags);
 void* load_texture_end(void *opaque, const char *path, unsigned int flags);
@@ -28,6 +39,10 @@ bool check_texture_path(const char *path);
 
 void load_sdl_surf(SDL_Surface *surface, Texture *texture);
 void free_texture(Texture *tex);
+size_t texture_size(void *tex);
+
+// Releases the pixel buffers kept around for uploads; needs the GL context
+void texture_upload_shutdown(void);
 
 void draw_texture(float x, float y, const char *name);
 void draw_texture_p(float x, float y, Texture *tex);
@@ -41,8 +56,12 @@ void fill_screen_p(float xoff, float yoff, float ratio, float aspect, float angl
 void loop_tex_line_p(complex a, complex b, float w, float t, Texture *texture);
 void loop_tex_line(complex a, complex b, float w, float t, const char *texture);
 
+// Decodes everything under TEX_PATH_PREFIX serially and on a thread pool, and prints the throughput
+void texture_benchmark(void);
+
 Texture* get_tex(const char *name);
 Texture* prefix_get_tex(const char *name, const char *prefix);
+Texture* get_tex_interned(const InternedString *name);
 
 #define TEX_PATH_PREFIX "res/gfx/"
 #define TEX_EXTENSION ".png"
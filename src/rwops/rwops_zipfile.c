@@ -6,15 +6,287 @@
  * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
  */
 
+#include <zlib.h>
+
 #include "rwops_zipfile.h"
 #include "util.h"
 
+// distance between inflate checkpoints, in uncompressed bytes
+#define ZIPRW_CHECKPOINT_SPAN (1 << 20)
+#define ZIPRW_INBUF_SIZE (1 << 14)
+
+typedef enum ZipRWMode {
+    ZIPRW_STORED,   // zip_fseek works
+    ZIPRW_DEFLATED, // we inflate the raw data ourselves, and can jump to checkpoints
+    ZIPRW_OTHER,    // libzip decompresses, seeking back means starting over
+} ZipRWMode;
+
+typedef struct ZipRWCheckpoint {
+    uint64_t pos;
+    z_stream state;
+} ZipRWCheckpoint;
+
+typedef struct ZipRW {
+    zip_t *zip;
+    zip_int64_t index;
+    zip_file_t *file;
+    bool autoclose;
+    ZipRWMode mode;
+    uint64_t size;
+    uint64_t pos;
+
+    struct {
+        z_stream strm;
+        bool strm_initialized;
+        bool finished;
+
+        ZipRWCheckpoint *checkpoints;
+        int num_checkpoints;
+        int checkpoints_capacity;
+
+        uint8_t inbuf[ZIPRW_INBUF_SIZE];
+    } deflate;
+} ZipRW;
+
+#define ZIPRW(rw) ((ZipRW*)((rw)->hidden.unknown.data1))
+
+static bool ziprw_set_zip_error(ZipRW *z, zip_file_t *file) {
+    if(file) {
+        SDL_SetError("ZIP error: %s", zip_file_strerror(file));
+    } else {
+        SDL_SetError("ZIP error: %s", zip_strerror(z->zip));
+    }
+
+    return false;
+}
+
+static bool ziprw_reopen(ZipRW *z) {
+    if(z->file) {
+        zip_fclose(z->file);
+    }
+
+    z->file = zip_fopen_index(z->zip, z->index, z->mode == ZIPRW_DEFLATED ? ZIP_FL_COMPRESSED : 0);
+    z->pos = 0;
+
+    if(!z->file) {
+        return ziprw_set_zip_error(z, NULL);
+    }
+
+    return true;
+}
+
+// positions the raw stream at the given offset, for either stored or compressed data
+static bool ziprw_seek_raw(ZipRW *z, uint64_t offset) {
+    if(!zip_fseek(z->file, offset, SEEK_SET)) {
+        return true;
+    }
+
+    // not supported by this libzip, or for this entry; start over and skip
+    if(!ziprw_reopen(z)) {
+        return false;
+    }
+
+    uint8_t buf[4096];
+
+    while(offset) {
+        zip_int64_t n = zip_fread(z->file, buf, offset < sizeof(buf) ? offset : sizeof(buf));
+
+        if(n <= 0) {
+            SDL_SetError("ZIP error: unexpected end of data while seeking");
+            return false;
+        }
+
+        offset -= n;
+    }
+
+    return true;
+}
+
+static bool ziprw_inflate_reset(ZipRW *z) {
+    if(z->deflate.strm_initialized) {
+        inflateEnd(&z->deflate.strm);
+        z->deflate.strm_initialized = false;
+    }
+
+    memset(&z->deflate.strm, 0, sizeof(z_stream));
+
+    // raw deflate data, no zlib header
+    if(inflateInit2(&z->deflate.strm, -MAX_WBITS) != Z_OK) {
+        SDL_SetError("inflateInit2() failed: %s", z->deflate.strm.msg ? z->deflate.strm.msg : "unknown error");
+        return false;
+    }
+
+    z->deflate.strm_initialized = true;
+    z->deflate.finished = false;
+
+    return ziprw_reopen(z);
+}
+
+static void ziprw_add_checkpoint(ZipRW *z) {
+    int n = z->deflate.num_checkpoints;
+
+    if(n && z->deflate.checkpoints[n - 1].pos >= z->pos) {
+        // we've been here before
+        return;
+    }
+
+    if(n == z->deflate.checkpoints_capacity) {
+        z->deflate.checkpoints_capacity = n ? n * 2 : 8;
+        z->deflate.checkpoints = realloc(z->deflate.checkpoints, z->deflate.checkpoints_capacity * sizeof(ZipRWCheckpoint));
+    }
+
+    ZipRWCheckpoint *cp = z->deflate.checkpoints + n;
+
+    if(inflateCopy(&cp->state, &z->deflate.strm) != Z_OK) {
+        // not fatal, we'll just have to inflate more when seeking
+        return;
+    }
+
+    // the copy points into our input buffer; consumption of it is already accounted for in total_in
+    cp->state.next_in = NULL;
+    cp->state.avail_in = 0;
+    cp->pos = z->pos;
+    ++z->deflate.num_checkpoints;
+}
+
+static bool ziprw_restore_checkpoint(ZipRW *z, ZipRWCheckpoint *cp) {
+    if(z->deflate.strm_initialized) {
+        inflateEnd(&z->deflate.strm);
+        z->deflate.strm_initialized = false;
+    }
+
+    if(inflateCopy(&z->deflate.strm, &cp->state) != Z_OK) {
+        SDL_SetError("inflateCopy() failed");
+        return false;
+    }
+
+    z->deflate.strm_initialized = true;
+    z->deflate.finished = false;
+    z->deflate.strm.next_in = z->deflate.inbuf;
+    z->deflate.strm.avail_in = 0;
+
+    if(!ziprw_seek_raw(z, z->deflate.strm.total_in)) {
+        return false;
+    }
+
+    z->pos = cp->pos;
+    return true;
+}
+
+static size_t ziprw_inflate(ZipRW *z, void *ptr, size_t len) {
+    z_stream *strm = &z->deflate.strm;
+    size_t total = 0;
+
+    while(total < len && !z->deflate.finished) {
+        if(!strm->avail_in) {
+            zip_int64_t n = zip_fread(z->file, z->deflate.inbuf, sizeof(z->deflate.inbuf));
+
+            if(n <= 0) {
+                if(n < 0) {
+                    ziprw_set_zip_error(z, z->file);
+                } else {
+                    SDL_SetError("ZIP error: truncated deflate stream");
+                }
+
+                break;
+            }
+
+            strm->next_in = z->deflate.inbuf;
+            strm->avail_in = n;
+        }
+
+        // stop exactly at the next checkpoint boundary, so that one can be taken there
+        size_t chunk = len - total;
+        uint64_t boundary = (z->pos / ZIPRW_CHECKPOINT_SPAN + 1) * ZIPRW_CHECKPOINT_SPAN;
+
+        if(z->pos + chunk > boundary) {
+            chunk = boundary - z->pos;
+        }
+
+        strm->next_out = (uint8_t*)ptr + total;
+        strm->avail_out = chunk;
+
+        int ret = inflate(strm, Z_NO_FLUSH);
+        size_t produced = chunk - strm->avail_out;
+
+        total += produced;
+        z->pos += produced;
+
+        if(ret == Z_STREAM_END) {
+            z->deflate.finished = true;
+        } else if(ret != Z_OK && ret != Z_BUF_ERROR) {
+            SDL_SetError("inflate() failed: %s", strm->msg ? strm->msg : "unknown error");
+            break;
+        }
+
+        if(produced && z->pos % ZIPRW_CHECKPOINT_SPAN == 0) {
+            ziprw_add_checkpoint(z);
+        }
+    }
+
+    return total;
+}
+
+static size_t ziprw_read_internal(ZipRW *z, void *ptr, size_t len) {
+    if(z->pos >= z->size) {
+        return 0;
+    }
+
+    if(len > z->size - z->pos) {
+        len = z->size - z->pos;
+    }
+
+    if(z->mode == ZIPRW_DEFLATED) {
+        return ziprw_inflate(z, ptr, len);
+    }
+
+    zip_int64_t n = zip_fread(z->file, ptr, len);
+
+    if(n < 0) {
+        ziprw_set_zip_error(z, z->file);
+        return 0;
+    }
+
+    z->pos += n;
+    return n;
+}
+
+static bool ziprw_skip(ZipRW *z, uint64_t target) {
+    uint8_t buf[4096];
+
+    while(z->pos < target) {
+        uint64_t want = target - z->pos;
+
+        if(!ziprw_read_internal(z, buf, want < sizeof(buf) ? want : sizeof(buf))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static int ziprw_close(SDL_RWops *rw) {
     if(rw) {
-        if(rw->hidden.unknown.data2) {
-            zip_fclose(rw->hidden.unknown.data1);
+        ZipRW *z = ZIPRW(rw);
+
+        if(z->file) {
+            zip_fclose(z->file);
+        }
+
+        if(z->autoclose) {
+            zip_discard(z->zip);
+        }
+
+        if(z->deflate.strm_initialized) {
+            inflateEnd(&z->deflate.strm);
+        }
+
+        for(int i = 0; i < z->deflate.num_checkpoints; ++i) {
+            inflateEnd(&z->deflate.checkpoints[i].state);
         }
 
+        free(z->deflate.checkpoints);
+        free(z);
         SDL_FreeRW(rw);
     }
 
@@ -22,32 +294,154 @@ static int ziprw_close(SDL_RWops *rw) {
 }
 
 static int64_t ziprw_seek(SDL_RWops *rw, int64_t offset, int whence) {
-    SDL_SetError("Not implemented");
-    return -1;
+    ZipRW *z = ZIPRW(rw);
+    int64_t target;
+
+    switch(whence) {
+        case RW_SEEK_SET: target = offset;          break;
+        case RW_SEEK_CUR: target = z->pos + offset; break;
+        case RW_SEEK_END: target = z->size + offset; break;
+        default: {
+            SDL_SetError("Bad whence value %i", whence);
+            return -1;
+        }
+    }
+
+    if(target < 0) {
+        SDL_SetError("Attempted to seek before the start of the file");
+        return -1;
+    }
+
+    if(target > z->size) {
+        target = z->size;
+    }
+
+    if(target == z->pos) {
+        return target;
+    }
+
+    switch(z->mode) {
+        case ZIPRW_STORED: {
+            if(!ziprw_seek_raw(z, target)) {
+                return -1;
+            }
+
+            z->pos = target;
+            return target;
+        }
+
+        case ZIPRW_DEFLATED: {
+            // find the closest checkpoint at or before the target
+            ZipRWCheckpoint *best = NULL;
+
+            for(int i = 0; i < z->deflate.num_checkpoints; ++i) {
+                if(z->deflate.checkpoints[i].pos > target) {
+                    break;
+                }
+
+                best = z->deflate.checkpoints + i;
+            }
+
+            if(target < z->pos || (best && best->pos > z->pos)) {
+                bool ok = best ? ziprw_restore_checkpoint(z, best) : ziprw_inflate_reset(z);
+
+                if(!ok) {
+                    return -1;
+                }
+            }
+
+            break;
+        }
+
+        case ZIPRW_OTHER: {
+            if(target < z->pos && !ziprw_reopen(z)) {
+                return -1;
+            }
+
+            break;
+        }
+    }
+
+    if(!ziprw_skip(z, target)) {
+        return -1;
+    }
+
+    return z->pos;
 }
 
 static int64_t ziprw_size(SDL_RWops *rw) {
-    SDL_SetError("Not implemented");
-    return -1;
+    return ZIPRW(rw)->size;
 }
 
 static size_t ziprw_read(SDL_RWops *rw, void *ptr, size_t size, size_t maxnum) {
-    zip_file_t *zipfile = rw->hidden.unknown.data1;
-    // XXX: possible size overflow
-    return zip_fread(zipfile, ptr, size * maxnum);
+    if(!size || !maxnum) {
+        return 0;
+    }
+
+    ZipRW *z = ZIPRW(rw);
+    size_t total = 0, len = size * maxnum;
+
+    // libzip may return short reads; keep going until we've got everything, or hit the end
+    while(total < len) {
+        size_t n = ziprw_read_internal(z, (uint8_t*)ptr + total, len - total);
+
+        if(!n) {
+            break;
+        }
+
+        total += n;
+    }
+
+    return total / size;
 }
 
 static size_t ziprw_write(SDL_RWops *rw, const void *ptr, size_t size, size_t maxnum) {
-    SDL_SetError("Not implemented");
-    return -1;
+    SDL_SetError("ZIP archives are read-only");
+    return 0;
 }
 
-SDL_RWops* SDL_RWFromZipFile(zip_file_t *zipfile, bool autoclose) {
+SDL_RWops* SDL_RWFromZipFile(zip_t *zip, zip_int64_t index, bool autoclose) {
+    zip_stat_t zstat;
+
+    if(zip_stat_index(zip, index, 0, &zstat) || !(zstat.valid & ZIP_STAT_SIZE)) {
+        SDL_SetError("ZIP error: %s", zip_strerror(zip));
+        return NULL;
+    }
+
+    ZipRW *z = calloc(1, sizeof(ZipRW));
+    z->zip = zip;
+    z->index = index;
+    z->size = zstat.size;
+    z->autoclose = autoclose;
+
+    bool encrypted = (zstat.valid & ZIP_STAT_ENCRYPTION_METHOD) && zstat.encryption_method != ZIP_EM_NONE;
+    uint16_t method = (zstat.valid & ZIP_STAT_COMP_METHOD) ? zstat.comp_method : ZIP_CM_DEFAULT;
+
+    if(encrypted) {
+        z->mode = ZIPRW_OTHER;
+    } else if(method == ZIP_CM_STORE) {
+        z->mode = ZIPRW_STORED;
+    } else if(method == ZIP_CM_DEFLATE) {
+        z->mode = ZIPRW_DEFLATED;
+    } else {
+        z->mode = ZIPRW_OTHER;
+    }
+
+    bool ok = (z->mode == ZIPRW_DEFLATED) ? ziprw_inflate_reset(z) : ziprw_reopen(z);
+
+    if(!ok) {
+        if(z->deflate.strm_initialized) {
+            inflateEnd(&z->deflate.strm);
+        }
+
+        free(z);
+        return NULL;
+    }
+
     SDL_RWops *rw = SDL_AllocRW();
     memset(rw, 0, sizeof(SDL_RWops));
 
-    rw->hidden.unknown.data1 = zipfile;
-    rw->hidden.unknown.data2 = (void*)(intptr_t)autoclose;
+    rw->hidden.unknown.data1 = z;
     rw->type = SDL_RWOPS_UNKNOWN;
 
     rw->size = ziprw_size;
@@ -58,3 +452,7 @@ SDL_RWops* SDL_RWFromZipFile(zip_file_t *zipfile, bool autoclose) {
 
     return rw;
 }
+
+bool SDL_RWZipFileSeeksCheaply(SDL_RWops *rw) {
+    return ZIPRW(rw)->mode != ZIPRW_OTHER;
+}
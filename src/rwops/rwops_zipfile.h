@@ -12,4 +12,11 @@
 #include <zip.h>
 #include <stdbool.h>
 
-SDL_RWops* SDL_RWFromZipFile(zip_file_t *zipfile, bool autoclose);
+// Opens an entry of the archive as a read-only stream that knows its size and supports seeking.
+// Stored entries seek directly; deflated ones are inflated here, and seek via checkpoints taken along the way.
+// Anything else has to be decompressed from the start again to seek backwards.
+// If autoclose is set, the archive is discarded along with the stream (if it's returned at all).
+SDL_RWops* SDL_RWFromZipFile(zip_t *zip, zip_int64_t index, bool autoclose);
+
+// False if seeking backwards in this stream means decompressing it from the start.
+bool SDL_RWZipFileSeeksCheaply(SDL_RWops *rw);
@@ -473,6 +473,8 @@ static void stage_free(void) {
 	}
 
 	stagetext_free();
+	reset_sounds();
+	marena_reset(&stage_arena);
 }
 
 static void stage_finalize(void *arg) {
@@ -496,17 +498,72 @@ void stage_finish(int gameover) {
 	}
 }
 
-static void stage_preload(void) {
+static void stage_collect_manifest(StageInfo *stage, ResourceManifest *manifest) {
+	resource_manifest_begin(manifest);
+
 	difficulty_preload();
 	projectiles_preload();
 	player_preload();
 	items_preload();
 	boss_preload();
 
-	if(global.stage->type != STAGE_SPELL)
+	if(stage->type != STAGE_SPELL)
 		enemies_preload();
 
-	global.stage->procs->preload();
+	stage->procs->preload();
+
+	resource_manifest_end();
+}
+
+static struct {
+	ResourceManifest current;
+	ResourceManifest next;
+	StageInfo *next_stage;
+	bool prefetched;
+} stage_resources;
+
+void stage_set_next(StageInfo *next) {
+	stage_resources.next_stage = next;
+}
+
+static void stage_preload(void) {
+	stage_collect_manifest(global.stage, &stage_resources.current);
+	resource_manifest_submit(&stage_resources.current);
+}
+
+static void stage_prefetch_next(void) {
+	// wait until the current stage is fully loaded, then until there's a boss on the screen
+	if(
+		stage_resources.prefetched ||
+		!stage_resources.next_stage ||
+		!global.boss ||
+		resource_preload_progress() < 1 ||
+		!getenvint("TAISEI_PREFETCH", true)
+	) {
+		return;
+	}
+
+	stage_collect_manifest(stage_resources.next_stage, &stage_resources.next);
+	resource_manifest_prefetch(&stage_resources.next);
+	stage_resources.prefetched = true;
+}
+
+static void stage_release_resources(void) {
+	if(global.game_over == GAMEOVER_WIN && stage_resources.next_stage) {
+		if(!stage_resources.prefetched) {
+			stage_collect_manifest(stage_resources.next_stage, &stage_resources.next);
+		}
+
+		// drop whatever this stage needed that the next one doesn't, before its own loads pile up
+		resource_manifest_evict(&stage_resources.current, &stage_resources.next);
+	}
+
+	resource_evict_to_budget();
+
+	resource_manifest_free(&stage_resources.current);
+	resource_manifest_free(&stage_resources.next);
+	stage_resources.next_stage = NULL;
+	stage_resources.prefetched = false;
 }
 
 static void display_stage_title(StageInfo *info) {
@@ -563,6 +620,7 @@ static bool stage_frame(void *arg) {
 
 	replay_stage_check_desync(global.replay_stage, global.frames, (tsrand() ^ global.plr.points) & 0xFFFF, global.replaymode);
 	stage_logic();
+	stage_prefetch_next();
 
 	if(global.replaymode == REPLAY_RECORD && global.plr.points > progress.hiscore) {
 		progress.hiscore = global.plr.points;
@@ -625,6 +683,7 @@ void stage_loop(StageInfo *stage) {
 	if(global.game_over == GAMEOVER_WIN) {
 		global.game_over = 0;
 	} else if(global.game_over) {
+		stage_set_next(NULL);
 		return;
 	}
 
@@ -704,6 +763,7 @@ void stage_loop(StageInfo *stage) {
 	player_free(&global.plr);
 	tsrand_switch(&global.rand_visual);
 	free_all_refs();
-	stage_objpools_free();
+	stage_objpools_shrink();
 	stop_sounds();
+	stage_release_resources();
 }
@@ -108,6 +108,9 @@ void stage_init_array(void);
 void stage_free_array(void);
 
 void stage_loop(StageInfo *stage);
+
+// Tells stage_loop() which stage is going to follow the one it runs next, so that it can be prefetched.
+void stage_set_next(StageInfo *next);
 void stage_finish(int gameover);
 
 void stage_pause(void);
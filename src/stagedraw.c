@@ -14,9 +14,11 @@
 #ifdef DEBUG
 	#define GRAPHS_DEFAULT 1
 	#define OBJPOOLSTATS_DEFAULT 1
+	#define RESOURCESTATS_DEFAULT 1
 #else
 	#define GRAPHS_DEFAULT 0
 	#define OBJPOOLSTATS_DEFAULT 0
+	#define RESOURCESTATS_DEFAULT 0
 #endif
 
 static struct {
@@ -31,6 +33,7 @@ static struct {
 	} hud_text;
 	bool framerate_graphs;
 	bool objpool_stats;
+	bool resource_stats;
 } stagedraw;
 
 void stage_draw_preload(void) {
@@ -65,6 +68,7 @@ void stage_draw_preload(void) {
 
 	stagedraw.framerate_graphs = getenvint("TAISEI_FRAMERATE_GRAPHS", GRAPHS_DEFAULT);
 	stagedraw.objpool_stats = getenvint("TAISEI_OBJPOOL_STATS", OBJPOOLSTATS_DEFAULT);
+	stagedraw.resource_stats = getenvint("TAISEI_RESOURCE_STATS", RESOURCESTATS_DEFAULT);
 
 	if(stagedraw.framerate_graphs) {
 		preload_resources(RES_SHADER, RESF_PERMANENT,
@@ -102,11 +106,11 @@ static void draw_wall_of_text(float f, const char *txt) {
 
 	Shader *shader = get_shader("spellcard_walloftext");
 	glUseProgram(shader->prog);
-	glUniform1f(uniloc(shader, "w"), strw/(float)tex->truew);
-	glUniform1f(uniloc(shader, "h"), strh/(float)tex->trueh);
-	glUniform1f(uniloc(shader, "ratio"), h/w);
-	glUniform2f(uniloc(shader, "origin"), creal(global.boss->pos)/h, cimag(global.boss->pos)/w);
-	glUniform1f(uniloc(shader, "t"), f);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("w")), strw/(float)tex->truew);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("h")), strh/(float)tex->trueh);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("ratio")), h/w);
+	glUniform2f(uniloc_interned(shader, INTERN_STATIC("origin")), creal(global.boss->pos)/h, cimag(global.boss->pos)/w);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("t")), f);
 	glBindTexture(GL_TEXTURE_2D, tex->gltex);
 	draw_quad();
 	glUseProgram(0);
@@ -132,7 +136,7 @@ static void draw_spellbg(int t) {
 		glScalef(f,f,f);
 	}
 
-	draw_texture(0,0,"boss_spellcircle0");
+	draw_texture_p(0,0,get_tex_interned(INTERN_STATIC("boss_spellcircle0")));
 	glPopMatrix();
 
 	float delay = ATTACK_START_DELAY;
@@ -181,15 +185,15 @@ static void apply_bg_shaders(ShaderRule *shaderrules, FBO **fbo0, FBO **fbo1) {
 			Shader *shader = get_shader("spellcard_intro");
 			glUseProgram(shader->prog);
 
-			glUniform1f(uniloc(shader, "ratio"), ratio);
-			glUniform2f(uniloc(shader, "origin"), creal(pos)/VIEWPORT_W, 1-cimag(pos)/VIEWPORT_H);
+			glUniform1f(uniloc_interned(shader, INTERN_STATIC("ratio")), ratio);
+			glUniform2f(uniloc_interned(shader, INTERN_STATIC("origin")), creal(pos)/VIEWPORT_W, 1-cimag(pos)/VIEWPORT_H);
 
 			float delay = ATTACK_START_DELAY;
 			if(b->current->type == AT_ExtraSpell)
 				delay = ATTACK_START_DELAY_EXTRA;
 			float duration = ATTACK_START_DELAY_EXTRA;
 
-			glUniform1f(uniloc(shader, "t"), (t+delay)/duration);
+			glUniform1f(uniloc_interned(shader, INTERN_STATIC("t")), (t+delay)/duration);
 		} else if(b->current->endtime) {
 			int tn = global.frames - b->current->endtime;
 			Shader *shader = get_shader("spellcard_outro");
@@ -203,10 +207,10 @@ static void apply_bg_shaders(ShaderRule *shaderrules, FBO **fbo0, FBO **fbo1) {
 				delay = ATTACK_END_DELAY_EXTRA;
 			}
 
-			glUniform1f(uniloc(shader, "ratio"), ratio);
-			glUniform2f(uniloc(shader, "origin"), creal(pos)/VIEWPORT_W, 1-cimag(pos)/VIEWPORT_H);
+			glUniform1f(uniloc_interned(shader, INTERN_STATIC("ratio")), ratio);
+			glUniform2f(uniloc_interned(shader, INTERN_STATIC("origin")), creal(pos)/VIEWPORT_W, 1-cimag(pos)/VIEWPORT_H);
 
-			glUniform1f(uniloc(shader, "t"), max(0,tn/delay+1));
+			glUniform1f(uniloc_interned(shader, INTERN_STATIC("t")), max(0,tn/delay+1));
 
 		} else {
 			glUseProgram(0);
@@ -227,9 +231,9 @@ static void apply_zoom_shader(void) {
 	complex fpos = global.boss->pos;
 	complex pos = fpos + 15*cexp(I*global.frames/4.5);
 
-	glUniform2f(uniloc(shader, "blur_orig"),
+	glUniform2f(uniloc_interned(shader, INTERN_STATIC("blur_orig")),
 			creal(pos)/VIEWPORT_W, 1-cimag(pos)/VIEWPORT_H);
-	glUniform2f(uniloc(shader, "fix_orig"),
+	glUniform2f(uniloc_interned(shader, INTERN_STATIC("fix_orig")),
 			creal(fpos)/VIEWPORT_W, 1-cimag(fpos)/VIEWPORT_H);
 
 	float spellcard_sup = 1;
@@ -246,16 +250,16 @@ static void apply_zoom_shader(void) {
 		spellcard_sup = 1-t*t;
 	}
 
-	glUniform1f(uniloc(shader, "blur_rad"), 1.5*spellcard_sup*(0.2+0.025*sin(global.frames/15.0)));
-	glUniform1f(uniloc(shader, "rad"), 0.24);
-	glUniform1f(uniloc(shader, "ratio"), (float)VIEWPORT_H/VIEWPORT_W);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("blur_rad")), 1.5*spellcard_sup*(0.2+0.025*sin(global.frames/15.0)));
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("rad")), 0.24);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("ratio")), (float)VIEWPORT_H/VIEWPORT_W);
 
 	if(global.boss->zoomcolor) {
 		static float clr[4];
 		parse_color_array(global.boss->zoomcolor, clr);
-		glUniform4fv(uniloc(shader, "color"), 1, clr);
+		glUniform4fv(uniloc_interned(shader, INTERN_STATIC("color")), 1, clr);
 	} else {
-		glUniform4f(uniloc(shader, "color"), 0.1, 0.2, 0.3, 1);
+		glUniform4f(uniloc_interned(shader, INTERN_STATIC("color")), 0.1, 0.2, 0.3, 1);
 	}
 }
 
@@ -304,7 +308,7 @@ static void stage_draw_objects(void) {
 }
 
 static void postprocess_prepare(FBO *fbo, Shader *s) {
-	glUniform1i(uniloc(s, "frames"), global.frames);
+	glUniform1i(uniloc_interned(s, INTERN_STATIC("frames")), global.frames);
 }
 
 void stage_draw_foreground(void) {
@@ -421,7 +425,7 @@ void stage_draw_scene(StageInfo *stage) {
 }
 
 static void draw_star(int x, int y, float fill, float alpha) {
-	Texture *star = get_tex("star");
+	Texture *star = get_tex_interned(INTERN_STATIC("star"));
 	Shader *shader = get_shader("circleclipped_indicator");
 
 	y -= 2;
@@ -443,12 +447,12 @@ static void draw_star(int x, int y, float fill, float alpha) {
 	}
 
 	glUseProgram(shader->prog);
-	glUniform1f(uniloc(shader, "fill"), fill);
-	glUniform1f(uniloc(shader, "tcfactor"), star->truew / (float)star->w);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("fill")), fill);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("tcfactor")), star->truew / (float)star->w);
 	parse_color_array(fill_clr, clr);
-	glUniform4fv(uniloc(shader, "fill_color"), 1, clr);
+	glUniform4fv(uniloc_interned(shader, INTERN_STATIC("fill_color")), 1, clr);
 	parse_color_array(back_clr, clr);
-	glUniform4fv(uniloc(shader, "back_color"), 1, clr);
+	glUniform4fv(uniloc_interned(shader, INTERN_STATIC("back_color")), 1, clr);
 	draw_texture_with_size_p(x, y, 20, 20, star);
 	glUseProgram(0);
 }
@@ -495,7 +499,7 @@ static void stage_draw_hud_scores(float ypos_hiscore, float ypos_score, char *bu
 	glUniform1f(stagedraw.hud_text.u_split, 0.0);
 }
 
-static void stage_draw_hud_objpool_stats(float x, float y, float width, Font *font) {
+static float stage_draw_hud_objpool_stats(float x, float y, float width, Font *font) {
 	ObjectPool **last = &stage_object_pools.first + (sizeof(StageObjectPools)/sizeof(ObjectPool*) - 1);
 
 	for(ObjectPool **pool = &stage_object_pools.first; pool <= last; ++pool) {
@@ -503,7 +507,23 @@ static void stage_draw_hud_objpool_stats(float x, float y, float width, Font *fo
 		char buf[32];
 		objpool_get_stats(*pool, &stats);
 
-		snprintf(buf, sizeof(buf), "%zu | %4zu", stats.usage, stats.peak_usage);
+		snprintf(buf, sizeof(buf), "%zu/%zu | %4zu", stats.usage, stats.capacity, stats.peak_usage);
+		draw_text(AL_Left  | AL_Flag_NoAdjust, (int)x,           (int)y, stats.tag, font);
+		draw_text(AL_Right | AL_Flag_NoAdjust, (int)(x + width), (int)y, buf,       font);
+
+		y += stringheight(buf, font) * 1.1;
+	}
+
+	return y;
+}
+
+static void stage_draw_hud_resource_stats(float x, float y, float width, Font *font) {
+	for(ResourceType type = 0; type < RES_NUMTYPES; ++type) {
+		ResourceStats stats;
+		char buf[32];
+		resource_get_stats(type, &stats);
+
+		snprintf(buf, sizeof(buf), "%3i | %7.2f MiB", stats.num_resident, stats.resident_bytes / (double)(1 << 20));
 		draw_text(AL_Left  | AL_Flag_NoAdjust, (int)x,           (int)y, stats.tag, font);
 		draw_text(AL_Right | AL_Flag_NoAdjust, (int)(x + width), (int)y, buf,       font);
 
@@ -544,8 +564,14 @@ void stage_draw_hud_text(struct labels_s* labels) {
 	draw_text(AL_Left, labels->x.ofs, labels->y.graze,   "Graze:",    _fonts.hud);
 	glUniform4f(stagedraw.hud_text.u_colortint, 1.00, 1.00, 1.00, 1.00);
 
+	float stats_y = labels->y.graze + 32;
+
 	if(stagedraw.objpool_stats) {
-		stage_draw_hud_objpool_stats(labels->x.ofs, labels->y.graze + 32, 250, _fonts.monotiny);
+		stats_y = stage_draw_hud_objpool_stats(labels->x.ofs, stats_y, 250, _fonts.monotiny);
+	}
+
+	if(stagedraw.resource_stats) {
+		stage_draw_hud_resource_stats(labels->x.ofs, stats_y + 8, 250, _fonts.monotiny);
 	}
 
 	// Score/Hi-Score values
@@ -634,11 +660,11 @@ static void stage_draw_framerate_graphs(void) {
 	static float samples[NUM_SAMPLES];
 
 	Shader *s = get_shader("graph");
-	uint32_t u_points = uniloc(s, "points[0]");
+	uint32_t u_points = uniloc_interned(s, INTERN_STATIC("points[0]"));
 	uint32_t u_colors[3] = {
-		uniloc(s, "color_low"),
-		uniloc(s, "color_mid"),
-		uniloc(s, "color_high"),
+		uniloc_interned(s, INTERN_STATIC("color_low")),
+		uniloc_interned(s, INTERN_STATIC("color_mid")),
+		uniloc_interned(s, INTERN_STATIC("color_high")),
 	};
 
 	float pad = 15;
@@ -673,7 +699,7 @@ static void stage_draw_framerate_graphs(void) {
 
 void stage_draw_hud(void) {
 	// Background
-	draw_texture(SCREEN_W/2.0, SCREEN_H/2.0, "hud");
+	draw_texture_p(SCREEN_W/2.0, SCREEN_H/2.0, get_tex_interned(INTERN_STATIC("hud")));
 
 	// Set up positions of most HUD elements
 	static struct labels_s labels = {
@@ -762,7 +788,7 @@ void stage_draw_hud(void) {
 		if(red > 1)
 			red = 0;
 		glColor4f(1,1,1,1-red);
-		draw_texture(VIEWPORT_X+creal(global.boss->pos), 590, "boss_indicator");
+		draw_texture_p(VIEWPORT_X+creal(global.boss->pos), 590, get_tex_interned(INTERN_STATIC("boss_indicator")));
 		glColor4f(1,1,1,1);
 	}
 }
@@ -6,20 +6,66 @@
 #include "laser.h"
 #include "aniplayer.h"
 
-#define MAX_PROJECTILES             8192
-#define MAX_ITEMS                   MAX_PROJECTILES
-#define MAX_ENEMIES                 256
-#define MAX_LASERS                  256
-#define MAX_ANIPLAYERS              32
+// pools are unbounded; these are just the growth increments
+#define CHUNK_PROJECTILES           512
+#define CHUNK_ITEMS                 256
+#define CHUNK_ENEMIES               32
+#define CHUNK_LASERS                32
+#define CHUNK_ANIPLAYERS            8
 
 StageObjectPools stage_object_pools;
 
+static void init_projectile(ObjectInterface *obj) {
+    // _create_projectile() assigns everything else
+    Projectile *p = (Projectile*)obj;
+    p->next = p->prev = NULL;
+
+#ifdef PROJ_DEBUG
+    memset(&p->debug, 0, sizeof(p->debug));
+#endif
+}
+
+static void init_item(ObjectInterface *obj) {
+    // create_item() assigns everything else
+    Item *i = (Item*)obj;
+    i->next = i->prev = NULL;
+}
+
 void stage_objpools_alloc(void) {
-    stage_object_pools.projectiles = objpool_alloc(sizeof(Projectile), MAX_PROJECTILES, "proj+part");
-    stage_object_pools.items = objpool_alloc(sizeof(Item), MAX_ITEMS, "item");
-    stage_object_pools.enemies = objpool_alloc(sizeof(Enemy), MAX_ENEMIES, "enemy");
-    stage_object_pools.lasers = objpool_alloc(sizeof(Laser), MAX_LASERS, "laser");
-    stage_object_pools.aniplayers = objpool_alloc(sizeof(AniPlayer), MAX_ANIPLAYERS, "aniplr");
+    if(stage_object_pools.first) {
+        // kept around from the previous stage
+        return;
+    }
+
+    stage_object_pools.projectiles = objpool_alloc(sizeof(Projectile), CHUNK_PROJECTILES, 0, "proj+part");
+    stage_object_pools.items = objpool_alloc(sizeof(Item), CHUNK_ITEMS, 0, "item");
+    stage_object_pools.enemies = objpool_alloc(sizeof(Enemy), CHUNK_ENEMIES, 0, "enemy");
+    stage_object_pools.lasers = objpool_alloc(sizeof(Laser), CHUNK_LASERS, 0, "laser");
+    stage_object_pools.aniplayers = objpool_alloc(sizeof(AniPlayer), CHUNK_ANIPLAYERS, 0, "aniplr");
+
+    objpool_set_init_func(stage_object_pools.projectiles, init_projectile);
+    objpool_set_init_func(stage_object_pools.items, init_item);
+}
+
+void stage_objpools_shrink(void) {
+    if(!stage_object_pools.first) {
+        return;
+    }
+
+    // a spike in one stage shouldn't keep its memory tied up for the rest of the game
+    size_t keep = getenvint("TAISEI_OBJPOOL_KEEP_CHUNKS", 1);
+    ObjectPool **last = &stage_object_pools.first + (sizeof(StageObjectPools)/sizeof(ObjectPool*) - 1);
+
+    for(ObjectPool **pool = &stage_object_pools.first; pool <= last; ++pool) {
+        ObjectPoolStats stats;
+        objpool_get_stats(*pool, &stats);
+
+        if(stats.usage != 0) {
+            log_warn("[%s] %zu objects still in use", stats.tag, stats.usage);
+        }
+
+        objpool_shrink(*pool, keep);
+    }
 }
 
 void stage_objpools_free(void) {
@@ -28,4 +74,5 @@ void stage_objpools_free(void) {
     objpool_free(stage_object_pools.enemies);
     objpool_free(stage_object_pools.lasers);
     objpool_free(stage_object_pools.aniplayers);
+    memset(&stage_object_pools, 0, sizeof(stage_object_pools));
 }
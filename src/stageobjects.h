@@ -20,4 +20,5 @@ typedef struct StageObjectPools {
 extern StageObjectPools stage_object_pools;
 
 void stage_objpools_alloc(void);
+void stage_objpools_shrink(void);
 void stage_objpools_free(void);
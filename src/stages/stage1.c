@@ -101,7 +101,7 @@ static void stage1_smoke_draw(Vector pos) {
 	glRotatef(global.frames,0,0,1);
 
 	glColor4f(.8,.8,.8,((d-500)*(d-500))/1.5e7);
-	draw_texture(0,0,"stage1/fog");
+	draw_texture_p(0,0,get_tex_interned(INTERN_STATIC("stage1/fog")));
 	glColor4f(1,1,1,1);
 
 	glPopMatrix();
@@ -118,13 +118,13 @@ static void stage1_fog(FBO *fbo) {
 	Shader *shader = get_shader("zbuf_fog");
 
 	glUseProgram(shader->prog);
-	glUniform1i(uniloc(shader, "tex"), 0);
-	glUniform1i(uniloc(shader, "depth"), 1);
-	glUniform4f(uniloc(shader, "fog_color"), 0.8, 0.8, 0.8, 1.0);
-	glUniform1f(uniloc(shader, "start"), 0.0);
-	glUniform1f(uniloc(shader, "end"), 0.8);
-	glUniform1f(uniloc(shader, "exponent"), 3.0);
-	glUniform1f(uniloc(shader, "sphereness"), 0.2);
+	glUniform1i(uniloc_interned(shader, INTERN_STATIC("tex")), 0);
+	glUniform1i(uniloc_interned(shader, INTERN_STATIC("depth")), 1);
+	glUniform4f(uniloc_interned(shader, INTERN_STATIC("fog_color")), 0.8, 0.8, 0.8, 1.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("start")), 0.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("end")), 0.8);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("exponent")), 3.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("sphereness")), 0.2);
 	glActiveTexture(GL_TEXTURE0 + 1);
 	glBindTexture(GL_TEXTURE_2D, fbo->depth);
 	glActiveTexture(GL_TEXTURE0);
@@ -42,7 +42,7 @@ static void stage2_bg_leaves_draw(Vector pos) {
 	glScalef(-1,1,1);
 	glMatrixMode(GL_MODELVIEW);
 
-	Texture *leaves = get_tex("stage2/leaves");
+	Texture *leaves = get_tex_interned(INTERN_STATIC("stage2/leaves"));
 	glBindTexture(GL_TEXTURE_2D, leaves->gltex);
 
 	glPushMatrix();
@@ -64,7 +64,7 @@ static void stage2_bg_leaves_draw(Vector pos) {
 
 static void stage2_bg_grass_draw(Vector pos) {
 	glDisable(GL_DEPTH_TEST);
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage2/roadgrass")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage2/roadgrass"))->gltex);
 
 	glPushMatrix();
 	glTranslatef(pos[0]+250,pos[1],pos[2]+40);
@@ -82,7 +82,7 @@ static void stage2_bg_ground_draw(Vector pos) {
 	glTranslatef(pos[0]-50,pos[1],pos[2]);
 	glScalef(-1000,1000,1);
 
-	Texture *road = get_tex("stage2/roadstones");
+	Texture *road = get_tex_interned(INTERN_STATIC("stage2/roadstones"));
 
 	glBindTexture(GL_TEXTURE_2D, road->gltex);
 
@@ -105,7 +105,7 @@ static void stage2_bg_ground_draw(Vector pos) {
 
 	glPushMatrix();
 
-	Texture *border = get_tex("stage2/border");
+	Texture *border = get_tex_interned(INTERN_STATIC("stage2/border"));
 	glBindTexture(GL_TEXTURE_2D, border->gltex);
 
 	glTranslatef(pos[0]+410,pos[1],pos[2]+600);
@@ -146,12 +146,12 @@ static void stage2_fog(FBO *fbo) {
 	Shader *shader = get_shader("zbuf_fog");
 
 	glUseProgram(shader->prog);
-	glUniform1i(uniloc(shader, "depth"),2);
-	glUniform4f(uniloc(shader, "fog_color"),0.05,0.0,0.03,1.0);
-	glUniform1f(uniloc(shader, "start"),0.2);
-	glUniform1f(uniloc(shader, "end"),0.8);
-	glUniform1f(uniloc(shader, "exponent"),3.0);
-	glUniform1f(uniloc(shader, "sphereness"),0);
+	glUniform1i(uniloc_interned(shader, INTERN_STATIC("depth")),2);
+	glUniform4f(uniloc_interned(shader, INTERN_STATIC("fog_color")),0.05,0.0,0.03,1.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("start")),0.2);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("end")),0.8);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("exponent")),3.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("sphereness")),0);
 	glActiveTexture(GL_TEXTURE0 + 2);
 	glBindTexture(GL_TEXTURE_2D, fbo->depth);
 	glActiveTexture(GL_TEXTURE0);
@@ -164,9 +164,9 @@ static void stage2_bloom(FBO *fbo) {
 	Shader *shader = get_shader("bloom");
 
 	glUseProgram(shader->prog);
-	glUniform1i(uniloc(shader, "samples"), 10);
-	glUniform1f(uniloc(shader, "intensity"), 0.05);
-	glUniform1f(uniloc(shader, "radius"), 0.03);
+	glUniform1i(uniloc_interned(shader, INTERN_STATIC("samples")), 10);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("intensity")), 0.05);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("radius")), 0.03);
 	draw_fbo_viewport(fbo);
 	glUseProgram(0);
 }
@@ -72,7 +72,7 @@ static void stage3_bg_tunnel_draw(Vector pos) {
 	glPushMatrix();
 	glTranslatef(pos[0], pos[1], pos[2]);
 
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage3/border")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage3/border"))->gltex);
 	for(i = 0; i < n; i++) {
 		glPushMatrix();
 		glRotatef(360.0/n*i + stgstate.tunnel_angle, 0, 1, 0);
@@ -87,12 +87,12 @@ static void stage3_bg_tunnel_draw(Vector pos) {
 
 static void stage3_tunnel(FBO *fbo) {
 	Shader *shader = get_shader("tunnel");
-	assert(uniloc(shader, "mixfactor") >= 0); // just so people don't forget to 'make install'; remove this later
+	assert(uniloc_interned(shader, INTERN_STATIC("mixfactor")) >= 0); // just so people don't forget to 'make install'; remove this later
 
 	glColor4f(1,1,1,1);
 	glUseProgram(shader->prog);
-	glUniform3f(uniloc(shader, "color"),stgstate.clr_r,stgstate.clr_g,stgstate.clr_b);
-	glUniform1f(uniloc(shader, "mixfactor"), stgstate.clr_mixfactor);
+	glUniform3f(uniloc_interned(shader, INTERN_STATIC("color")),stgstate.clr_r,stgstate.clr_g,stgstate.clr_b);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("mixfactor")), stgstate.clr_mixfactor);
 	glActiveTexture(GL_TEXTURE0 + 2);
 	glBindTexture(GL_TEXTURE_2D, fbo->depth);
 	glActiveTexture(GL_TEXTURE0);
@@ -106,12 +106,12 @@ static void stage3_fog(FBO *fbo) {
 
 	glColor4f(1,1,1,1);
 	glUseProgram(shader->prog);
-	glUniform1i(uniloc(shader, "depth"), 2);
-	glUniform4f(uniloc(shader, "fog_color"), stgstate.fog_brightness, stgstate.fog_brightness, stgstate.fog_brightness, 1.0);
-	glUniform1f(uniloc(shader, "start"), 0.2);
-	glUniform1f(uniloc(shader, "end"), 0.8);
-	glUniform1f(uniloc(shader, "exponent"), stgstate.fog_exp/2);
-	glUniform1f(uniloc(shader, "sphereness"),0);
+	glUniform1i(uniloc_interned(shader, INTERN_STATIC("depth")), 2);
+	glUniform4f(uniloc_interned(shader, INTERN_STATIC("fog_color")), stgstate.fog_brightness, stgstate.fog_brightness, stgstate.fog_brightness, 1.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("start")), 0.2);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("end")), 0.8);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("exponent")), stgstate.fog_exp/2);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("sphereness")),0);
 	glActiveTexture(GL_TEXTURE0 + 2);
 	glBindTexture(GL_TEXTURE_2D, fbo->depth);
 	glActiveTexture(GL_TEXTURE0);
@@ -134,8 +134,8 @@ static void stage3_glitch(FBO *fbo) {
 
 	if(strength > 0) {
 		glUseProgram(shader->prog);
-		glUniform1f(uniloc(shader, "strength"), strength);
-		glUniform1i(uniloc(shader, "frames"), global.frames + tsrand() % 30);
+		glUniform1f(uniloc_interned(shader, INTERN_STATIC("strength")), strength);
+		glUniform1i(uniloc_interned(shader, INTERN_STATIC("frames")), global.frames + tsrand() % 30);
 	} else {
 		glUseProgram(0);
 	}
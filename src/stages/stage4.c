@@ -55,12 +55,12 @@ static void stage4_fog(FBO *fbo) {
 	}
 
 	glUseProgram(shader->prog);
-	glUniform1i(uniloc(shader, "depth"),2);
-	glUniform4f(uniloc(shader, "fog_color"),10*f,0,0.1-f,1.0);
-	glUniform1f(uniloc(shader, "start"),0.4);
-	glUniform1f(uniloc(shader, "end"),0.8);
-	glUniform1f(uniloc(shader, "exponent"),4.0);
-	glUniform1f(uniloc(shader, "sphereness"),0);
+	glUniform1i(uniloc_interned(shader, INTERN_STATIC("depth")),2);
+	glUniform4f(uniloc_interned(shader, INTERN_STATIC("fog_color")),10*f,0,0.1-f,1.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("start")),0.4);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("end")),0.8);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("exponent")),4.0);
+	glUniform1f(uniloc_interned(shader, INTERN_STATIC("sphereness")),0);
 	glActiveTexture(GL_TEXTURE0 + 2);
 	glBindTexture(GL_TEXTURE_2D, fbo->depth);
 	glActiveTexture(GL_TEXTURE0);
@@ -86,7 +86,7 @@ static Vector **stage4_fountain_pos(Vector pos, float maxrange) {
 }
 
 static void stage4_fountain_draw(Vector pos) {
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage2/border")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage2/border"))->gltex);
 
 	glPushMatrix();
 	glTranslatef(pos[0], pos[1], pos[2]);
@@ -100,29 +100,11 @@ static void stage4_fountain_draw(Vector pos) {
 
 static Vector **stage4_lake_pos(Vector pos, float maxrange) {
 	Vector p = {0, 600, 0};
-	Vector d;
-
-	int i;
-
-	for(i = 0; i < 3; i++)
-		d[i] = p[i] - pos[i];
-
-	if(length(d) > maxrange) {
-		return NULL;
-	} else {
-		Vector **list = calloc(2, sizeof(Vector*));
-
-		list[0] = malloc(sizeof(Vector));
-		for(i = 0; i < 3; i++)
-			(*list[0])[i] = p[i];
-		list[1] = NULL;
-
-		return list;
-	}
+	return single3dpos(pos, maxrange, p);
 }
 
 static void stage4_lake_draw(Vector pos) {
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage4/lake")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage4/lake"))->gltex);
 
 	glPushMatrix();
 	glTranslatef(pos[0], pos[1]+140, pos[2]);
@@ -135,7 +117,7 @@ static void stage4_lake_draw(Vector pos) {
 	glTranslatef(pos[0], pos[1]+944, pos[2]+50);
 	glScalef(30,30,30);
 
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage4/mansion")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage4/mansion"))->gltex);
 
 	draw_model("mansion");
 	glPopMatrix();
@@ -158,7 +140,7 @@ static Vector **stage4_corridor_pos(Vector pos, float maxrange) {
 }
 
 static void stage4_corridor_draw(Vector pos) {
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage4/planks")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage4/planks"))->gltex);
 
 	glMatrixMode(GL_TEXTURE);
 	glScalef(1,2,1);
@@ -174,7 +156,7 @@ static void stage4_corridor_draw(Vector pos) {
 	draw_quad();
 	glPopMatrix();
 
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage4/wall")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage4/wall"))->gltex);
 
 	glMatrixMode(GL_TEXTURE);
 	glLoadIdentity();
@@ -52,7 +52,7 @@ static Vector **stage5_stairs_pos(Vector pos, float maxrange) {
 }
 
 static void stage5_stairs_draw(Vector pos) {
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage5/tower")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage5/tower"))->gltex);
 
 	glPushMatrix();
 	glTranslatef(pos[0], pos[1], pos[2]);
@@ -60,9 +60,9 @@ static void stage5_stairs_draw(Vector pos) {
 
 	Shader *sha = get_shader("tower_light");
 	glUseProgram(sha->prog);
-	glUniform3f(uniloc(sha, "lightvec"), 0, 0, 0);
-	glUniform4f(uniloc(sha, "color"), 0.1, 0.1, 0.5, 1);
-	glUniform1f(uniloc(sha, "strength"), stagedata.light_strength);
+	glUniform3f(uniloc_interned(sha, INTERN_STATIC("lightvec")), 0, 0, 0);
+	glUniform4f(uniloc_interned(sha, INTERN_STATIC("color")), 0.1, 0.1, 0.5, 1);
+	glUniform1f(uniloc_interned(sha, INTERN_STATIC("strength")), stagedata.light_strength);
 
 	draw_model("tower");
 
@@ -107,32 +107,32 @@ static void stage5_update(void) {
 }
 
 void iku_spell_bg(Boss *b, int t) {
-	fill_screen(0, 300, 1, "stage5/spell_bg");
+	fill_screen_p(0, 300, 1, 1, 0, get_tex_interned(INTERN_STATIC("stage5/spell_bg")));
 
 	glBlendFunc(GL_ZERO, GL_SRC_COLOR);
-	fill_screen(0, t*0.001, 0.7, "stage5/noise");
+	fill_screen_p(0, t*0.001, 0.7, 1, 0, get_tex_interned(INTERN_STATIC("stage5/noise")));
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	glPushMatrix();
 	glTranslatef(0, -100, 0);
 
-	fill_screen(t/100.0,0,0.5,"stage5/spell_clouds");
+	fill_screen_p(t/100.0,0,0.5,1, 0, get_tex_interned(INTERN_STATIC("stage5/spell_clouds")));
 	glPushMatrix();
 	glTranslatef(0, 100, 0);
-	fill_screen(t/100.0*0.75,0,0.6,"stage5/spell_clouds");
+	fill_screen_p(t/100.0*0.75,0,0.6,1, 0, get_tex_interned(INTERN_STATIC("stage5/spell_clouds")));
 	glPushMatrix();
 	glTranslatef(0, 100, 0);
-	fill_screen(t/100.0*0.5,0,0.7,"stage5/spell_clouds");
+	fill_screen_p(t/100.0*0.5,0,0.7,1, 0, get_tex_interned(INTERN_STATIC("stage5/spell_clouds")));
 	glPushMatrix();
 	glTranslatef(0, 100, 0);
-	fill_screen(t/100.0*0.25,0,0.8,"stage5/spell_clouds");
+	fill_screen_p(t/100.0*0.25,0,0.8,1, 0, get_tex_interned(INTERN_STATIC("stage5/spell_clouds")));
 	glPopMatrix();
 	glPopMatrix();
 	glPopMatrix();
 	glPopMatrix();
 
 	glColor4f(1,1,1,0.05*stagedata.light_strength);
-	fill_screen(0, 300, 1, "stage5/spell_lightning");
+	fill_screen_p(0, 300, 1, 1, 0, get_tex_interned(INTERN_STATIC("stage5/spell_lightning")));
 	glColor4f(1,1,1,1);
 }
 
@@ -75,7 +75,7 @@ Vector **stage6_towerwall_pos(Vector pos, float maxrange) {
 }
 
 void stage6_towerwall_draw(Vector pos) {
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage6/towerwall")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage6/towerwall"))->gltex);
 
 	Shader *s = get_shader("tower_wall");
 	glUseProgram(s->prog);
@@ -97,7 +97,7 @@ static Vector **stage6_towertop_pos(Vector pos, float maxrange) {
 }
 
 static void stage6_towertop_draw(Vector pos) {
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage6/towertop")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage6/towertop"))->gltex);
 
 	glPushMatrix();
 	glTranslatef(pos[0], pos[1], pos[2]);
@@ -115,7 +115,7 @@ static void stage6_skysphere_draw(Vector pos) {
 	Shader *s = get_shader("stage6_sky");
 	glUseProgram(s->prog);
 
-	glBindTexture(GL_TEXTURE_2D, get_tex("stage6/sky")->gltex);
+	glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("stage6/sky"))->gltex);
 
 	glPushMatrix();
 	glTranslatef(pos[0], pos[1], pos[2]-30);
@@ -131,7 +131,7 @@ static void stage6_skysphere_draw(Vector pos) {
 		glTranslatef(x,y,z);
 		glRotatef(180/M_PI*acos(starpos[3*i+2]),-y,x,0);
 		glScalef(1./4000,1./4000,1./4000);
-		draw_texture(0,0,"part/lasercurve");
+		draw_texture_p(0,0,get_tex_interned(INTERN_STATIC("part/lasercurve")));
 		glPopMatrix();
 	}
 
@@ -15,8 +15,9 @@ static StageText *textlist = NULL;
 #define NUM_PLACEHOLDER "........................"
 
 StageText* stagetext_add(const char *text, complex pos, Alignment align, Font **font, Color clr, int delay, int lifetime, int fadeintime, int fadeouttime) {
-    StageText *t = (StageText*)list_append((List**)&textlist, malloc(sizeof(StageText)));
-    t->text = strdup(text);
+    // released along with the rest of the stage arena in stage_free()
+    StageText *t = (StageText*)list_append((List**)&textlist, marena_alloc(&stage_arena, sizeof(StageText)));
+    t->text = marena_strdup(&stage_arena, text);
     t->font = font;
     t->pos = pos;
     t->align = align;
@@ -44,13 +45,12 @@ StageText* stagetext_add_numeric(int n, complex pos, Alignment align, Font **fon
 }
 
 static void* stagetext_delete(List **dest, List *txt, void *arg) {
-    free(((StageText*)txt)->text);
-    free(list_unlink(dest, txt));
+    list_unlink(dest, txt);
     return NULL;
 }
 
 void stagetext_free(void) {
-    list_foreach((List**)&textlist, stagetext_delete, NULL);
+    textlist = NULL;
 }
 
 static void stagetext_draw_single(StageText *txt) {
@@ -72,16 +72,16 @@ static void stagetext_draw_single(StageText *txt) {
 
     Shader *sha = get_shader("stagetitle");
     glUseProgram(sha->prog);
-    glUniform1i(uniloc(sha, "trans"), 1);
-    glUniform1f(uniloc(sha, "t"), 1.0 - f);
+    glUniform1i(uniloc_interned(sha, INTERN_STATIC("trans")), 1);
+    glUniform1f(uniloc_interned(sha, INTERN_STATIC("t")), 1.0 - f);
 
     glActiveTexture(GL_TEXTURE0 + 1);
-    glBindTexture(GL_TEXTURE_2D, get_tex("titletransition")->gltex);
+    glBindTexture(GL_TEXTURE_2D, get_tex_interned(INTERN_STATIC("titletransition"))->gltex);
     glActiveTexture(GL_TEXTURE0);
 
-    glUniform3f(uniloc(sha, "color"), 0,0,0);
+    glUniform3f(uniloc_interned(sha, INTERN_STATIC("color")), 0,0,0);
     draw_text(txt->align, creal(txt->pos)+10*f*f+1, cimag(txt->pos)+10*f*f+1, txt->text, *txt->font);
-    glUniform3fv(uniloc(sha, "color"), 1, txt->clr);
+    glUniform3fv(uniloc_interned(sha, INTERN_STATIC("color")), 1, txt->clr);
     draw_text(txt->align, creal(txt->pos)+10*f*f, cimag(txt->pos)+10*f*f, txt->text, *txt->font);
 
     glUseProgram(0);
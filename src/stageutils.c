@@ -63,15 +63,16 @@ void draw_stage3d(Stage3D *s, float maxrange) {
 		glTranslatef(-s->cx[0],-s->cx[1],-s->cx[2]);
 
 	for(int i = 0; i < s->msize; i++) {
+		// position rules allocate their results from the frame arena
+		MemArenaMark mark = marena_mark(&frame_arena);
 		Vector **list;
 		list = s->models[i].pos(s->cx, maxrange);
 
 		for(int j = 0; list && list[j] != NULL; j++) {
 			s->models[i].draw(*list[j]);
-			free(list[j]);
 		}
 
-		free(list);
+		marena_rewind(&frame_arena, mark);
 	}
 
 	glPopMatrix();
@@ -81,17 +82,10 @@ void free_stage3d(Stage3D *s) {
 	free(s->models);
 }
 
-Vector **linear3dpos(Vector q, float maxrange, Vector p, Vector r) {
+static int linear3dpos_walk(Vector q, float maxrange, Vector p, Vector r, float t, Vector *out) {
+	// visits the segments in range starting from t, going forward and then backward.
+	// returns how many there are, and writes them to out if it's not NULL.
 	int i;
-	float n = 0, z = 0;
-	for(i = 0; i < 3; i++) {
-		n += q[i]*r[i] - p[i]*r[i];
-		z += r[i]*r[i];
-	}
-
-	float t = n/z;
-
-	Vector **list = NULL;
 	int size = 0;
 	int mod = 1;
 
@@ -103,10 +97,11 @@ Vector **linear3dpos(Vector q, float maxrange, Vector p, Vector r) {
 			dif[i] = q[i] - p[i] - r[i]*num;
 
 		if(length(dif) < maxrange) {
-			list = realloc(list, (++size)*sizeof(Vector*));
-			list[size-1] = malloc(sizeof(Vector));
-			for(i = 0; i < 3; i++)
-				(*list[size-1])[i] = p[i] + r[i]*num;
+			if(out) {
+				for(i = 0; i < 3; i++)
+					out[size][i] = p[i] + r[i]*num;
+			}
+			++size;
 		} else if(mod == 1) {
 			mod = -1;
 			num = t;
@@ -117,8 +112,30 @@ Vector **linear3dpos(Vector q, float maxrange, Vector p, Vector r) {
 		num += mod;
 	}
 
-	list = realloc(list, (++size)*sizeof(Vector*));
-	list[size-1] = NULL;
+	return size;
+}
+
+Vector **linear3dpos(Vector q, float maxrange, Vector p, Vector r) {
+	int i;
+	float n = 0, z = 0;
+	for(i = 0; i < 3; i++) {
+		n += q[i]*r[i] - p[i]*r[i];
+		z += r[i]*r[i];
+	}
+
+	float t = n/z;
+
+	// count first, so that the whole result is just two allocations
+	int size = linear3dpos_walk(q, maxrange, p, r, t, NULL);
+
+	Vector **list = marena_alloc_array(&frame_arena, size + 1, sizeof(Vector*));
+	Vector *vecs = marena_alloc_array(&frame_arena, size, sizeof(Vector));
+	linear3dpos_walk(q, maxrange, p, r, t, vecs);
+
+	for(i = 0; i < size; i++)
+		list[i] = vecs + i;
+
+	list[size] = NULL;
 
 	return list;
 }
@@ -134,9 +151,9 @@ Vector **single3dpos(Vector q, float maxrange, Vector p) {
 	if(length(d) > maxrange) {
 		return NULL;
 	} else {
-		Vector **list = calloc(2, sizeof(Vector*));
+		Vector **list = marena_alloc_array(&frame_arena, 2, sizeof(Vector*));
 
-		list[0] = malloc(sizeof(Vector));
+		list[0] = marena_alloc(&frame_arena, sizeof(Vector));
 		for(i = 0; i < 3; i++)
 			(*list[0])[i] = p[i];
 		list[1] = NULL;
@@ -13,7 +13,7 @@
 typedef struct StageSegment StageSegment;
 
 typedef void (*SegmentDrawRule)(Vector pos);
-typedef Vector **(*SegmentPositionRule)(Vector q, float maxrange); // returns NULL-terminated array
+typedef Vector **(*SegmentPositionRule)(Vector q, float maxrange); // returns NULL-terminated array, allocated from frame_arena
 
 struct StageSegment {
 	SegmentDrawRule draw;
@@ -129,6 +129,42 @@ static void check_glext_debug_output(void) {
 	}
 }
 
+static void check_glext_get_program_binary(void) {
+	GLint num_formats = 0;
+
+	if(!(
+		(glext.version.major > 4 || (glext.version.major == 4 && glext.version.minor >= 1)) ||
+		extension_supported("GL_ARB_get_program_binary")
+	)) {
+		return;
+	}
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+	// some drivers advertise the extension, but don't support any formats
+	if((glext.get_program_binary = (num_formats > 0))) {
+		log_debug("Using GL_ARB_get_program_binary (%i formats)", num_formats);
+	}
+}
+
+static void check_glext_pixel_buffer_object(void) {
+	if((glext.pixel_buffer_object = (
+		(glext.version.major > 2 || (glext.version.major == 2 && glext.version.minor >= 1)) ||
+		extension_supported("GL_ARB_pixel_buffer_object")
+	))) {
+		log_debug("Using GL_ARB_pixel_buffer_object");
+	}
+}
+
+static void check_glext_sync(void) {
+	if((glext.sync = (
+		(glext.version.major > 3 || (glext.version.major == 3 && glext.version.minor >= 2)) ||
+		extension_supported("GL_ARB_sync")
+	) && tsglFenceSync && tsglClientWaitSync && tsglDeleteSync)) {
+		log_debug("Using GL_ARB_sync");
+	}
+}
+
 void check_gl_extensions(void) {
 	memset(&glext, 0, sizeof(glext));
 	get_gl_version(&glext.version.major, &glext.version.minor);
@@ -147,6 +183,9 @@ void check_gl_extensions(void) {
 
 	check_glext_draw_instanced();
 	check_glext_debug_output();
+	check_glext_get_program_binary();
+	check_glext_pixel_buffer_object();
+	check_glext_sync();
 }
 
 void load_gl_library(void) {
@@ -147,6 +147,7 @@ typedef void (APIENTRY *tsglBufferData_ptr)(GLenum target, GLsizeiptr size, cons
 typedef void (APIENTRY *tsglBufferSubData_ptr)(GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 typedef void (GLAPIENTRY *tsglClear_ptr)(GLbitfield mask);
 typedef void (GLAPIENTRY *tsglClearColor_ptr)(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha);
+typedef GLenum (APIENTRY *tsglClientWaitSync_ptr)(GLsync sync, GLbitfield flags, GLuint64 timeout);
 typedef void (GLAPIENTRY *tsglColor3f_ptr)(GLfloat red, GLfloat green, GLfloat blue);
 typedef void (GLAPIENTRY *tsglColor4f_ptr)(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
 typedef void (APIENTRY *tsglCompileShader_ptr)(GLuint shader);
@@ -161,6 +162,7 @@ typedef void (APIENTRY *tsglDeleteBuffers_ptr)(GLsizei n, const GLuint *buffers)
 typedef void (APIENTRY *tsglDeleteFramebuffers_ptr)(GLsizei n, const GLuint *framebuffers);
 typedef void (APIENTRY *tsglDeleteProgram_ptr)(GLuint program);
 typedef void (APIENTRY *tsglDeleteShader_ptr)(GLuint shader);
+typedef void (APIENTRY *tsglDeleteSync_ptr)(GLsync sync);
 typedef void (GLAPIENTRY *tsglDeleteTextures_ptr)(GLsizei n, const GLuint *textures);
 typedef void (GLAPIENTRY *tsglDepthFunc_ptr)(GLenum func);
 typedef void (GLAPIENTRY *tsglDepthMask_ptr)(GLboolean flag);
@@ -172,6 +174,7 @@ typedef void (APIENTRY *tsglDrawArraysInstancedEXT_ptr)(GLenum mode, GLint start
 typedef void (GLAPIENTRY *tsglDrawElements_ptr)(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
 typedef void (GLAPIENTRY *tsglEnable_ptr)(GLenum cap);
 typedef void (GLAPIENTRY *tsglEnableClientState_ptr)(GLenum cap);
+typedef GLsync (APIENTRY *tsglFenceSync_ptr)(GLenum condition, GLbitfield flags);
 typedef void (APIENTRY *tsglFramebufferTexture2D_ptr)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
 typedef void (GLAPIENTRY *tsglFrustum_ptr)(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_val, GLdouble far_val);
 typedef void (APIENTRY *tsglGenBuffers_ptr)(GLsizei n, GLuint *buffers);
@@ -179,6 +182,7 @@ typedef void (APIENTRY *tsglGenFramebuffers_ptr)(GLsizei n, GLuint *framebuffers
 typedef void (GLAPIENTRY *tsglGenTextures_ptr)(GLsizei n, GLuint *textures);
 typedef void (APIENTRY *tsglGetActiveUniform_ptr)(GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name);
 typedef void (GLAPIENTRY *tsglGetIntegerv_ptr)(GLenum pname, GLint *params);
+typedef void (APIENTRY *tsglGetProgramBinary_ptr)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
 typedef void (APIENTRY *tsglGetProgramInfoLog_ptr)(GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
 typedef void (APIENTRY *tsglGetProgramiv_ptr)(GLuint program, GLenum pname, GLint *params);
 typedef void (APIENTRY *tsglGetShaderInfoLog_ptr)(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
@@ -192,6 +196,8 @@ typedef void (GLAPIENTRY *tsglMatrixMode_ptr)(GLenum mode);
 typedef void (GLAPIENTRY *tsglNormalPointer_ptr)(GLenum type, GLsizei stride, const GLvoid *ptr);
 typedef void (GLAPIENTRY *tsglOrtho_ptr)(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_val, GLdouble far_val);
 typedef void (GLAPIENTRY *tsglPopMatrix_ptr)(void);
+typedef void (APIENTRY *tsglProgramBinary_ptr)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRY *tsglProgramParameteri_ptr)(GLuint program, GLenum pname, GLint value);
 typedef void (GLAPIENTRY *tsglPushMatrix_ptr)(void);
 typedef void (GLAPIENTRY *tsglReadBuffer_ptr)(GLenum mode);
 typedef void (GLAPIENTRY *tsglReadPixels_ptr)(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels);
@@ -241,6 +247,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #undef glBufferSubData
 #undef glClear
 #undef glClearColor
+#undef glClientWaitSync
 #undef glColor3f
 #undef glColor4f
 #undef glCompileShader
@@ -255,6 +262,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #undef glDeleteFramebuffers
 #undef glDeleteProgram
 #undef glDeleteShader
+#undef glDeleteSync
 #undef glDeleteTextures
 #undef glDepthFunc
 #undef glDepthMask
@@ -266,6 +274,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #undef glDrawElements
 #undef glEnable
 #undef glEnableClientState
+#undef glFenceSync
 #undef glFramebufferTexture2D
 #undef glFrustum
 #undef glGenBuffers
@@ -273,6 +282,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #undef glGenTextures
 #undef glGetActiveUniform
 #undef glGetIntegerv
+#undef glGetProgramBinary
 #undef glGetProgramInfoLog
 #undef glGetProgramiv
 #undef glGetShaderInfoLog
@@ -286,6 +296,8 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #undef glNormalPointer
 #undef glOrtho
 #undef glPopMatrix
+#undef glProgramBinary
+#undef glProgramParameteri
 #undef glPushMatrix
 #undef glReadBuffer
 #undef glReadPixels
@@ -336,6 +348,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #define glBufferSubData tsglBufferSubData
 #define glClear tsglClear
 #define glClearColor tsglClearColor
+#define glClientWaitSync tsglClientWaitSync
 #define glColor3f tsglColor3f
 #define glColor4f tsglColor4f
 #define glCompileShader tsglCompileShader
@@ -350,6 +363,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #define glDeleteFramebuffers tsglDeleteFramebuffers
 #define glDeleteProgram tsglDeleteProgram
 #define glDeleteShader tsglDeleteShader
+#define glDeleteSync tsglDeleteSync
 #define glDeleteTextures tsglDeleteTextures
 #define glDepthFunc tsglDepthFunc
 #define glDepthMask tsglDepthMask
@@ -361,6 +375,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #define glDrawElements tsglDrawElements
 #define glEnable tsglEnable
 #define glEnableClientState tsglEnableClientState
+#define glFenceSync tsglFenceSync
 #define glFramebufferTexture2D tsglFramebufferTexture2D
 #define glFrustum tsglFrustum
 #define glGenBuffers tsglGenBuffers
@@ -368,6 +383,7 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #define glGenTextures tsglGenTextures
 #define glGetActiveUniform tsglGetActiveUniform
 #define glGetIntegerv tsglGetIntegerv
+#define glGetProgramBinary tsglGetProgramBinary
 #define glGetProgramInfoLog tsglGetProgramInfoLog
 #define glGetProgramiv tsglGetProgramiv
 #define glGetShaderInfoLog tsglGetShaderInfoLog
@@ -381,6 +397,8 @@ typedef void (GLAPIENTRY *tsglViewport_ptr)(GLint x, GLint y, GLsizei width, GLs
 #define glNormalPointer tsglNormalPointer
 #define glOrtho tsglOrtho
 #define glPopMatrix tsglPopMatrix
+#define glProgramBinary tsglProgramBinary
+#define glProgramParameteri tsglProgramParameteri
 #define glPushMatrix tsglPushMatrix
 #define glReadBuffer tsglReadBuffer
 #define glReadPixels tsglReadPixels
@@ -433,6 +451,7 @@ GLDEF(glBufferData, tsglBufferData, tsglBufferData_ptr) \
 GLDEF(glBufferSubData, tsglBufferSubData, tsglBufferSubData_ptr) \
 GLDEF(glClear, tsglClear, tsglClear_ptr) \
 GLDEF(glClearColor, tsglClearColor, tsglClearColor_ptr) \
+GLDEF(glClientWaitSync, tsglClientWaitSync, tsglClientWaitSync_ptr) \
 GLDEF(glColor3f, tsglColor3f, tsglColor3f_ptr) \
 GLDEF(glColor4f, tsglColor4f, tsglColor4f_ptr) \
 GLDEF(glCompileShader, tsglCompileShader, tsglCompileShader_ptr) \
@@ -447,6 +466,7 @@ GLDEF(glDeleteBuffers, tsglDeleteBuffers, tsglDeleteBuffers_ptr) \
 GLDEF(glDeleteFramebuffers, tsglDeleteFramebuffers, tsglDeleteFramebuffers_ptr) \
 GLDEF(glDeleteProgram, tsglDeleteProgram, tsglDeleteProgram_ptr) \
 GLDEF(glDeleteShader, tsglDeleteShader, tsglDeleteShader_ptr) \
+GLDEF(glDeleteSync, tsglDeleteSync, tsglDeleteSync_ptr) \
 GLDEF(glDeleteTextures, tsglDeleteTextures, tsglDeleteTextures_ptr) \
 GLDEF(glDepthFunc, tsglDepthFunc, tsglDepthFunc_ptr) \
 GLDEF(glDepthMask, tsglDepthMask, tsglDepthMask_ptr) \
@@ -458,6 +478,7 @@ GLDEF(glDrawArraysInstancedEXT, tsglDrawArraysInstancedEXT, tsglDrawArraysInstan
 GLDEF(glDrawElements, tsglDrawElements, tsglDrawElements_ptr) \
 GLDEF(glEnable, tsglEnable, tsglEnable_ptr) \
 GLDEF(glEnableClientState, tsglEnableClientState, tsglEnableClientState_ptr) \
+GLDEF(glFenceSync, tsglFenceSync, tsglFenceSync_ptr) \
 GLDEF(glFramebufferTexture2D, tsglFramebufferTexture2D, tsglFramebufferTexture2D_ptr) \
 GLDEF(glFrustum, tsglFrustum, tsglFrustum_ptr) \
 GLDEF(glGenBuffers, tsglGenBuffers, tsglGenBuffers_ptr) \
@@ -465,6 +486,7 @@ GLDEF(glGenFramebuffers, tsglGenFramebuffers, tsglGenFramebuffers_ptr) \
 GLDEF(glGenTextures, tsglGenTextures, tsglGenTextures_ptr) \
 GLDEF(glGetActiveUniform, tsglGetActiveUniform, tsglGetActiveUniform_ptr) \
 GLDEF(glGetIntegerv, tsglGetIntegerv, tsglGetIntegerv_ptr) \
+GLDEF(glGetProgramBinary, tsglGetProgramBinary, tsglGetProgramBinary_ptr) \
 GLDEF(glGetProgramInfoLog, tsglGetProgramInfoLog, tsglGetProgramInfoLog_ptr) \
 GLDEF(glGetProgramiv, tsglGetProgramiv, tsglGetProgramiv_ptr) \
 GLDEF(glGetShaderInfoLog, tsglGetShaderInfoLog, tsglGetShaderInfoLog_ptr) \
@@ -478,6 +500,8 @@ GLDEF(glMatrixMode, tsglMatrixMode, tsglMatrixMode_ptr) \
 GLDEF(glNormalPointer, tsglNormalPointer, tsglNormalPointer_ptr) \
 GLDEF(glOrtho, tsglOrtho, tsglOrtho_ptr) \
 GLDEF(glPopMatrix, tsglPopMatrix, tsglPopMatrix_ptr) \
+GLDEF(glProgramBinary, tsglProgramBinary, tsglProgramBinary_ptr) \
+GLDEF(glProgramParameteri, tsglProgramParameteri, tsglProgramParameteri_ptr) \
 GLDEF(glPushMatrix, tsglPushMatrix, tsglPushMatrix_ptr) \
 GLDEF(glReadBuffer, tsglReadBuffer, tsglReadBuffer_ptr) \
 GLDEF(glReadPixels, tsglReadPixels, tsglReadPixels_ptr) \
@@ -534,6 +558,7 @@ GLAPI void APIENTRY glBufferData (GLenum target, GLsizeiptr size, const void *da
 GLAPI void APIENTRY glBufferSubData (GLenum target, GLintptr offset, GLsizeiptr size, const void *data);
 GLAPI void GLAPIENTRY glClear( GLbitfield mask );
 GLAPI void GLAPIENTRY glClearColor( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha );
+GLAPI GLenum APIENTRY glClientWaitSync (GLsync sync, GLbitfield flags, GLuint64 timeout);
 GLAPI void GLAPIENTRY glColor3f( GLfloat red, GLfloat green, GLfloat blue );
 GLAPI void GLAPIENTRY glColor4f( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha );
 GLAPI void APIENTRY glCompileShader (GLuint shader);
@@ -548,6 +573,7 @@ GLAPI void APIENTRY glDeleteBuffers (GLsizei n, const GLuint *buffers);
 GLAPI void APIENTRY glDeleteFramebuffers (GLsizei n, const GLuint *framebuffers);
 GLAPI void APIENTRY glDeleteProgram (GLuint program);
 GLAPI void APIENTRY glDeleteShader (GLuint shader);
+GLAPI void APIENTRY glDeleteSync (GLsync sync);
 GLAPI void GLAPIENTRY glDeleteTextures( GLsizei n, const GLuint *textures);
 GLAPI void GLAPIENTRY glDepthFunc( GLenum func );
 GLAPI void GLAPIENTRY glDepthMask( GLboolean flag );
@@ -559,6 +585,7 @@ GLAPI void APIENTRY glDrawArraysInstancedEXT (GLenum mode, GLint start, GLsizei
 GLAPI void GLAPIENTRY glDrawElements( GLenum mode, GLsizei count, GLenum type, const GLvoid *indices );
 GLAPI void GLAPIENTRY glEnable( GLenum cap );
 GLAPI void GLAPIENTRY glEnableClientState( GLenum cap );
+GLAPI GLsync APIENTRY glFenceSync (GLenum condition, GLbitfield flags);
 GLAPI void APIENTRY glFramebufferTexture2D (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
 GLAPI void GLAPIENTRY glFrustum( GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_val, GLdouble far_val );
 GLAPI void APIENTRY glGenBuffers (GLsizei n, GLuint *buffers);
@@ -566,6 +593,7 @@ GLAPI void APIENTRY glGenFramebuffers (GLsizei n, GLuint *framebuffers);
 GLAPI void GLAPIENTRY glGenTextures( GLsizei n, GLuint *textures );
 GLAPI void APIENTRY glGetActiveUniform (GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name);
 GLAPI void GLAPIENTRY glGetIntegerv( GLenum pname, GLint *params );
+GLAPI void APIENTRY glGetProgramBinary (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
 GLAPI void APIENTRY glGetProgramInfoLog (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
 GLAPI void APIENTRY glGetProgramiv (GLuint program, GLenum pname, GLint *params);
 GLAPI void APIENTRY glGetShaderInfoLog (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog);
@@ -579,6 +607,8 @@ GLAPI void GLAPIENTRY glMatrixMode( GLenum mode );
 GLAPI void GLAPIENTRY glNormalPointer( GLenum type, GLsizei stride, const GLvoid *ptr );
 GLAPI void GLAPIENTRY glOrtho( GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble near_val, GLdouble far_val );
 GLAPI void GLAPIENTRY glPopMatrix( void );
+GLAPI void APIENTRY glProgramBinary (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+GLAPI void APIENTRY glProgramParameteri (GLuint program, GLenum pname, GLint value);
 GLAPI void GLAPIENTRY glPushMatrix( void );
 GLAPI void GLAPIENTRY glReadBuffer( GLenum mode );
 GLAPI void GLAPIENTRY glReadPixels( GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels );
@@ -628,6 +658,7 @@ GLAPI void GLAPIENTRY glViewport( GLint x, GLint y, GLsizei width, GLsizei heigh
 #define tsglBufferSubData glBufferSubData
 #define tsglClear glClear
 #define tsglClearColor glClearColor
+#define tsglClientWaitSync glClientWaitSync
 #define tsglColor3f glColor3f
 #define tsglColor4f glColor4f
 #define tsglCompileShader glCompileShader
@@ -642,6 +673,7 @@ GLAPI void GLAPIENTRY glViewport( GLint x, GLint y, GLsizei width, GLsizei heigh
 #define tsglDeleteFramebuffers glDeleteFramebuffers
 #define tsglDeleteProgram glDeleteProgram
 #define tsglDeleteShader glDeleteShader
+#define tsglDeleteSync glDeleteSync
 #define tsglDeleteTextures glDeleteTextures
 #define tsglDepthFunc glDepthFunc
 #define tsglDepthMask glDepthMask
@@ -653,6 +685,7 @@ GLAPI void GLAPIENTRY glViewport( GLint x, GLint y, GLsizei width, GLsizei heigh
 #define tsglDrawElements glDrawElements
 #define tsglEnable glEnable
 #define tsglEnableClientState glEnableClientState
+#define tsglFenceSync glFenceSync
 #define tsglFramebufferTexture2D glFramebufferTexture2D
 #define tsglFrustum glFrustum
 #define tsglGenBuffers glGenBuffers
@@ -660,6 +693,7 @@ GLAPI void GLAPIENTRY glViewport( GLint x, GLint y, GLsizei width, GLsizei heigh
 #define tsglGenTextures glGenTextures
 #define tsglGetActiveUniform glGetActiveUniform
 #define tsglGetIntegerv glGetIntegerv
+#define tsglGetProgramBinary glGetProgramBinary
 #define tsglGetProgramInfoLog glGetProgramInfoLog
 #define tsglGetProgramiv glGetProgramiv
 #define tsglGetShaderInfoLog glGetShaderInfoLog
@@ -673,6 +707,8 @@ GLAPI void GLAPIENTRY glViewport( GLint x, GLint y, GLsizei width, GLsizei heigh
 #define tsglNormalPointer glNormalPointer
 #define tsglOrtho glOrtho
 #define tsglPopMatrix glPopMatrix
+#define tsglProgramBinary glProgramBinary
+#define tsglProgramParameteri glProgramParameteri
 #define tsglPushMatrix glPushMatrix
 #define tsglReadBuffer glReadBuffer
 #define tsglReadPixels glReadPixels
@@ -719,6 +755,9 @@ struct glext_s {
     unsigned int debug_output: 1;
     unsigned int EXT_draw_instanced: 1;
     unsigned int ARB_draw_instanced: 1;
+    unsigned int get_program_binary: 1;
+    unsigned int pixel_buffer_object: 1;
+    unsigned int sync: 1;
 
     tsglDrawArraysInstanced_ptr DrawArraysInstanced;
     tsglDebugMessageControl_ptr DebugMessageControl;
@@ -0,0 +1,207 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include <SDL.h>
+
+#include "threadpool.h"
+#include "util.h"
+
+typedef struct ThreadPoolTask {
+    ThreadPoolTaskFunc func;
+    void *arg;
+    int priority;
+    uint32_t seqnum;
+} ThreadPoolTask;
+
+struct ThreadPool {
+    char *name;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    bool shutdown;
+
+    // binary max-heap, ordered by (priority, -seqnum)
+    ThreadPoolTask *queue;
+    size_t queue_size;
+    size_t queue_capacity;
+    uint32_t next_seqnum;
+
+    int num_threads;
+    SDL_Thread *threads[];
+};
+
+static inline bool threadpool_task_before(ThreadPoolTask *a, ThreadPoolTask *b) {
+    if(a->priority != b->priority) {
+        return a->priority > b->priority;
+    }
+
+    // wraparound-safe FIFO order
+    return (int32_t)(a->seqnum - b->seqnum) < 0;
+}
+
+static void threadpool_queue_push(ThreadPool *pool, ThreadPoolTask *task) {
+    if(pool->queue_size == pool->queue_capacity) {
+        pool->queue_capacity = pool->queue_capacity ? pool->queue_capacity * 2 : 32;
+        pool->queue = realloc(pool->queue, sizeof(ThreadPoolTask) * pool->queue_capacity);
+    }
+
+    size_t i = pool->queue_size++;
+    ThreadPoolTask *q = pool->queue;
+
+    while(i > 0) {
+        size_t parent = (i - 1) / 2;
+
+        if(!threadpool_task_before(task, q + parent)) {
+            break;
+        }
+
+        q[i] = q[parent];
+        i = parent;
+    }
+
+    q[i] = *task;
+}
+
+static void threadpool_queue_pop(ThreadPool *pool, ThreadPoolTask *task) {
+    assert(pool->queue_size > 0);
+
+    ThreadPoolTask *q = pool->queue;
+    ThreadPoolTask last = q[--pool->queue_size];
+    size_t size = pool->queue_size;
+    size_t i = 0;
+
+    *task = q[0];
+
+    while(true) {
+        size_t child = 2 * i + 1;
+
+        if(child >= size) {
+            break;
+        }
+
+        if(child + 1 < size && threadpool_task_before(q + child + 1, q + child)) {
+            ++child;
+        }
+
+        if(!threadpool_task_before(q + child, &last)) {
+            break;
+        }
+
+        q[i] = q[child];
+        i = child;
+    }
+
+    q[i] = last;
+}
+
+static int threadpool_worker(void *arg) {
+    ThreadPool *pool = arg;
+    ThreadPoolTask task;
+
+    SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+    SDL_LockMutex(pool->mutex);
+
+    while(true) {
+        while(!pool->queue_size && !pool->shutdown) {
+            SDL_CondWait(pool->cond, pool->mutex);
+        }
+
+        if(!pool->queue_size) {
+            // shutting down and nothing left to do
+            break;
+        }
+
+        threadpool_queue_pop(pool, &task);
+
+        SDL_UnlockMutex(pool->mutex);
+        task.func(task.arg);
+        SDL_LockMutex(pool->mutex);
+    }
+
+    SDL_UnlockMutex(pool->mutex);
+    return 0;
+}
+
+ThreadPool* threadpool_new(const char *name, int num_threads) {
+    if(num_threads <= 0 && (num_threads = SDL_GetCPUCount()) < 1) {
+        num_threads = 1;
+    }
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool) + sizeof(SDL_Thread*) * num_threads);
+    pool->name = strdup(name);
+    pool->mutex = SDL_CreateMutex();
+    pool->cond = SDL_CreateCond();
+
+    for(int i = 0; i < num_threads; ++i) {
+        char *tname = strfmt("%s %i", name, i);
+        SDL_Thread *thread = SDL_CreateThread(threadpool_worker, tname, pool);
+        free(tname);
+
+        if(!thread) {
+            log_warn("SDL_CreateThread() failed: %s", SDL_GetError());
+            break;
+        }
+
+        pool->threads[pool->num_threads++] = thread;
+    }
+
+    log_debug("Thread pool '%s' started with %i threads", name, pool->num_threads);
+
+    return pool;
+}
+
+void threadpool_free(ThreadPool *pool) {
+    if(!pool) {
+        return;
+    }
+
+    SDL_LockMutex(pool->mutex);
+    pool->shutdown = true;
+    SDL_CondBroadcast(pool->cond);
+    SDL_UnlockMutex(pool->mutex);
+
+    for(int i = 0; i < pool->num_threads; ++i) {
+        SDL_WaitThread(pool->threads[i], NULL);
+    }
+
+    // if no threads could be created, the remaining tasks never ran
+    while(pool->queue_size) {
+        ThreadPoolTask task;
+        threadpool_queue_pop(pool, &task);
+        task.func(task.arg);
+    }
+
+    SDL_DestroyCond(pool->cond);
+    SDL_DestroyMutex(pool->mutex);
+    free(pool->queue);
+    free(pool->name);
+    free(pool);
+}
+
+void threadpool_submit(ThreadPool *pool, ThreadPoolTaskFunc func, void *arg, int priority) {
+    if(!pool->num_threads) {
+        func(arg);
+        return;
+    }
+
+    SDL_LockMutex(pool->mutex);
+
+    ThreadPoolTask task = {
+        .func = func,
+        .arg = arg,
+        .priority = priority,
+        .seqnum = pool->next_seqnum++,
+    };
+
+    threadpool_queue_push(pool, &task);
+    SDL_CondSignal(pool->cond);
+    SDL_UnlockMutex(pool->mutex);
+}
+
+int threadpool_num_threads(ThreadPool *pool) {
+    return pool->num_threads;
+}
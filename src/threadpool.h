@@ -0,0 +1,28 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/*
+ *  A fixed set of worker threads executing tasks from a shared priority queue.
+ *  Tasks with a higher priority are started first; tasks of equal priority run in submission order.
+ */
+
+typedef struct ThreadPool ThreadPool;
+typedef void (*ThreadPoolTaskFunc)(void *arg);
+
+// num_threads <= 0 means one thread per CPU core
+ThreadPool* threadpool_new(const char *name, int num_threads);
+
+// waits for all pending tasks to complete, then stops the workers
+void threadpool_free(ThreadPool *pool);
+
+void threadpool_submit(ThreadPool *pool, ThreadPoolTaskFunc func, void *arg, int priority);
+int threadpool_num_threads(ThreadPool *pool);
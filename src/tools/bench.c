@@ -0,0 +1,506 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+/*
+ *  taisei-bench: microbenchmarks for the core containers and hashing primitives.
+ *  Links against the game's own sources (minus main.c), so it measures exactly what the game runs.
+ *
+ *  Usage: taisei-bench [name-filter...]
+ *
+ *  Runs every benchmark whose name contains one of the filters (all of them by default) and prints
+ *  the results to stdout as JSON. Inputs are generated from fixed seeds and the output has a fixed
+ *  layout, so two runs can be diffed directly; the per-benchmark checksum changes only if the work
+ *  being done changes, which tells apart "got faster" from "does something else now".
+ *
+ *  TAISEI_BENCH_REPEATS sets how many times each benchmark is run (default: 7). The minimum and the
+ *  median time per operation are reported.
+ */
+
+#include <inttypes.h>
+
+#include "util.h"
+#include "list.h"
+#include "hashtable.h"
+#include "intern.h"
+#include "objectpool.h"
+#include "projectile.h"
+#include "replay.h"
+#include "random.h"
+#include "hirestime.h"
+#include "rwops/all.h"
+
+#define BENCH_FORMAT_VERSION 1
+
+#define NUM_RESOURCE_NAMES 640
+#define NUM_LOOKUPS (1 << 20)
+#define NUM_PROJECTILES 8192
+#define NUM_CHURN_FRAMES 600
+#define NUM_REPLAY_EVENTS 65536
+
+typedef struct BenchState {
+    hrtime_t begin;
+    hrtime_t elapsed;
+    uint64_t ops;
+    uint32_t checksum;
+    RandomState rng;
+} BenchState;
+
+typedef struct Benchmark {
+    const char *name;
+    void (*func)(BenchState *b);
+} Benchmark;
+
+typedef struct BenchNode {
+    List list_interface;
+    int prio;
+    uint32_t value;
+} BenchNode;
+
+static char *resource_names[NUM_RESOURCE_NAMES];
+
+// only the code between these is timed, so setup and teardown don't skew the results
+static void bench_begin(BenchState *b) {
+    b->begin = time_get();
+}
+
+static void bench_end(BenchState *b) {
+    b->elapsed += time_get() - b->begin;
+}
+
+static uint32_t bench_rand(BenchState *b, uint32_t limit) {
+    return tsrand_p(&b->rng) % limit;
+}
+
+static void bench_mix(BenchState *b, uint32_t value) {
+    b->checksum = (b->checksum ^ value) * 16777619u;
+}
+
+static void init_resource_names(void) {
+    // shaped like the names the resource system actually looks up
+    static const char *types[] = { "gfx", "sfx", "bgm", "shader", "model", "font" };
+    static const char *subdirs[] = { "stage1", "stage2", "stage3", "stage4", "stage5", "stage6", "dialog", "proj", "part", "" };
+    static const char *words[] = { "ball", "rice", "bigball", "plainball", "card", "wave", "flare", "lasercurve", "boss_spellcircle", "youmu", "marisa", "titletransition" };
+
+    for(int i = 0; i < NUM_RESOURCE_NAMES; ++i) {
+        const char *type = types[i % (sizeof(types)/sizeof(*types))];
+        const char *subdir = subdirs[(i / (sizeof(types)/sizeof(*types))) % (sizeof(subdirs)/sizeof(*subdirs))];
+        const char *word = words[(i * 7) % (sizeof(words)/sizeof(*words))];
+
+        resource_names[i] = strfmt("%s/%s%s%s%d", type, subdir, *subdir ? "/" : "", word, i);
+    }
+}
+
+static void free_resource_names(void) {
+    for(int i = 0; i < NUM_RESOURCE_NAMES; ++i) {
+        free(resource_names[i]);
+    }
+}
+
+static void bench_list_append_unlink(BenchState *b) {
+    BenchNode *nodes = calloc(NUM_PROJECTILES, sizeof(BenchNode));
+    int *order = calloc(NUM_PROJECTILES, sizeof(int));
+    BenchNode *head = NULL;
+    const int rounds = 4;
+
+    for(int i = 0; i < NUM_PROJECTILES; ++i) {
+        nodes[i].value = i;
+        order[i] = i;
+    }
+
+    for(int i = NUM_PROJECTILES - 1; i > 0; --i) {
+        int j = bench_rand(b, i + 1);
+        int t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    bench_begin(b);
+
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < NUM_PROJECTILES; ++i) {
+            list_append((List**)&head, (List*)(nodes + i));
+        }
+
+        for(int i = 0; i < NUM_PROJECTILES; ++i) {
+            BenchNode *n = nodes + order[i];
+            bench_mix(b, n->value);
+            list_unlink((List**)&head, (List*)n);
+        }
+    }
+
+    bench_end(b);
+    b->ops = rounds * 2 * NUM_PROJECTILES;
+
+    free(order);
+    free(nodes);
+}
+
+static int bench_node_prio(List *elem) {
+    return ((BenchNode*)elem)->prio;
+}
+
+static void bench_list_insert_at_priority(BenchState *b) {
+    // a realistic draw-ordering workload: a few layers, lots of ties
+    const int num = 2048;
+    BenchNode *nodes = calloc(num, sizeof(BenchNode));
+    BenchNode *head = NULL;
+
+    for(int i = 0; i < num; ++i) {
+        nodes[i].prio = bench_rand(b, 16);
+    }
+
+    bench_begin(b);
+
+    for(int i = 0; i < num; ++i) {
+        list_insert_at_priority((List**)&head, (List*)(nodes + i), nodes[i].prio, bench_node_prio);
+    }
+
+    bench_end(b);
+    b->ops = num;
+
+    for(BenchNode *n = head; n; n = (BenchNode*)n->list_interface.next) {
+        bench_mix(b, n - nodes);
+    }
+
+    free(nodes);
+}
+
+static void fill_lookup_order(BenchState *b, int *order) {
+    // every 16th lookup is for a name that isn't in the table
+    for(int i = 0; i < NUM_LOOKUPS; ++i) {
+        order[i] = (i & 15) ? (int)bench_rand(b, NUM_RESOURCE_NAMES / 2) : -1;
+    }
+}
+
+static void bench_hashtable_string_lookup(BenchState *b) {
+    Hashtable *ht = hashtable_new_stringkeys(HT_DYNAMIC_SIZE);
+    int *order = calloc(NUM_LOOKUPS, sizeof(int));
+    fill_lookup_order(b, order);
+
+    for(int i = 0; i < NUM_RESOURCE_NAMES / 2; ++i) {
+        hashtable_set_string(ht, resource_names[i], resource_names[i]);
+    }
+
+    const char *missing = "gfx/stage7/nonexistent";
+
+    bench_begin(b);
+
+    for(int i = 0; i < NUM_LOOKUPS; ++i) {
+        bench_mix(b, hashtable_get_string(ht, order[i] < 0 ? missing : resource_names[order[i]]) != NULL);
+    }
+
+    bench_end(b);
+    b->ops = NUM_LOOKUPS;
+
+    free(order);
+    hashtable_free(ht);
+}
+
+static void bench_hashtable_interned_lookup(BenchState *b) {
+    Hashtable *ht = hashtable_new_internedkeys(HT_DYNAMIC_SIZE);
+    const InternedString **keys = calloc(NUM_RESOURCE_NAMES / 2, sizeof(*keys));
+    int *order = calloc(NUM_LOOKUPS, sizeof(int));
+    fill_lookup_order(b, order);
+
+    for(int i = 0; i < NUM_RESOURCE_NAMES / 2; ++i) {
+        keys[i] = intern_string(resource_names[i]);
+        hashtable_set(ht, (void*)keys[i], resource_names[i]);
+    }
+
+    const InternedString *missing = intern_string("gfx/stage7/nonexistent");
+
+    bench_begin(b);
+
+    for(int i = 0; i < NUM_LOOKUPS; ++i) {
+        bench_mix(b, hashtable_get_interned(ht, order[i] < 0 ? missing : keys[order[i]]) != NULL);
+    }
+
+    bench_end(b);
+    b->ops = NUM_LOOKUPS;
+
+    free(order);
+    free(keys);
+    hashtable_free(ht);
+}
+
+static void bench_hashtable_set_unset(BenchState *b) {
+    Hashtable *ht = hashtable_new_stringkeys(HT_DYNAMIC_SIZE);
+    const int rounds = 64;
+
+    bench_begin(b);
+
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < NUM_RESOURCE_NAMES; ++i) {
+            hashtable_set_string(ht, resource_names[i], resource_names[i]);
+        }
+
+        for(int i = 0; i < NUM_RESOURCE_NAMES; ++i) {
+            hashtable_unset_string(ht, resource_names[i]);
+        }
+    }
+
+    bench_end(b);
+    b->ops = rounds * 2 * NUM_RESOURCE_NAMES;
+
+    HashtableStats stats;
+    hashtable_get_stats(ht, &stats);
+    bench_mix(b, stats.num_elements);
+
+    hashtable_free(ht);
+}
+
+static void bench_objpool_churn(BenchState *b) {
+    // a dense bullet pattern: a full screen of projectiles, an eighth of them replaced every frame
+    ObjectPool *pool = objpool_alloc(sizeof(Projectile), 512, 0, "bench");
+    ObjectInterface **live = calloc(NUM_PROJECTILES, sizeof(*live));
+    uint32_t *victims = calloc(NUM_CHURN_FRAMES * (NUM_PROJECTILES / 8), sizeof(uint32_t));
+    uint64_t ops = 0;
+
+    for(int i = 0; i < NUM_CHURN_FRAMES * (NUM_PROJECTILES / 8); ++i) {
+        victims[i] = bench_rand(b, NUM_PROJECTILES);
+    }
+
+    bench_begin(b);
+
+    for(int i = 0; i < NUM_PROJECTILES; ++i) {
+        live[i] = objpool_acquire(pool);
+    }
+
+    ops += NUM_PROJECTILES;
+
+    for(int frame = 0; frame < NUM_CHURN_FRAMES; ++frame) {
+        uint32_t *v = victims + frame * (NUM_PROJECTILES / 8);
+
+        for(int i = 0; i < NUM_PROJECTILES / 8; ++i) {
+            if(live[v[i]]) {
+                objpool_release(pool, live[v[i]]);
+                live[v[i]] = NULL;
+                ++ops;
+            }
+        }
+
+        for(int i = 0; i < NUM_PROJECTILES / 8; ++i) {
+            if(!live[v[i]]) {
+                live[v[i]] = objpool_acquire(pool);
+                ++ops;
+            }
+        }
+    }
+
+    for(int i = 0; i < NUM_PROJECTILES; ++i) {
+        objpool_release(pool, live[i]);
+    }
+
+    ops += NUM_PROJECTILES;
+
+    bench_end(b);
+    b->ops = ops;
+
+    ObjectPoolStats stats;
+    objpool_get_stats(pool, &stats);
+    bench_mix(b, stats.peak_usage);
+    bench_mix(b, stats.usage);
+
+    free(victims);
+    free(live);
+    objpool_free(pool);
+}
+
+static void write_replay_events(BenchState *b, SDL_RWops *dest) {
+    // roughly what replay_write_stage_event() produces for a full stage of play
+    uint32_t frame = 0;
+
+    for(int i = 0; i < NUM_REPLAY_EVENTS; ++i) {
+        frame += bench_rand(b, 8);
+        SDL_WriteLE32(dest, frame);
+        SDL_WriteU8(dest, 1 + bench_rand(b, 3));
+        SDL_WriteLE16(dest, bench_rand(b, 16));
+    }
+}
+
+static size_t deflate_replay(BenchState *b, void **buf, bool timed) {
+    SDL_RWops *abuf = SDL_RWAutoBuffer(buf, 64 * 1024);
+    SDL_RWops *zw = SDL_RWWrapZWriter(abuf, REPLAY_COMPRESSION_CHUNK_SIZE, false);
+
+    if(timed) {
+        bench_begin(b);
+    }
+
+    write_replay_events(b, zw);
+    SDL_RWclose(zw);
+
+    if(timed) {
+        bench_end(b);
+    }
+
+    size_t size = SDL_RWtell(abuf);
+    SDL_RWclose(abuf);
+    return size;
+}
+
+static void bench_zlib_deflate_replay(BenchState *b) {
+    void *buf = NULL;
+    size_t size = deflate_replay(b, &buf, true);
+
+    b->ops = NUM_REPLAY_EVENTS;
+    bench_mix(b, size);
+    free(buf);
+}
+
+static void bench_zlib_inflate_replay(BenchState *b) {
+    void *buf = NULL;
+    size_t size = deflate_replay(b, &buf, false);
+    SDL_RWops *zr = SDL_RWWrapZReader(SDL_RWFromConstMem(buf, size), REPLAY_COMPRESSION_CHUNK_SIZE, true);
+
+    bench_begin(b);
+
+    for(int i = 0; i < NUM_REPLAY_EVENTS; ++i) {
+        bench_mix(b, SDL_ReadLE32(zr));
+        bench_mix(b, SDL_ReadU8(zr));
+        bench_mix(b, SDL_ReadLE16(zr));
+    }
+
+    bench_end(b);
+    b->ops = NUM_REPLAY_EVENTS;
+
+    SDL_RWclose(zr);
+    free(buf);
+}
+
+static void bench_crc32(BenchState *b, uint32_t (*hashfunc)(uint32_t, const char*)) {
+    const int rounds = 2048;
+    uint32_t hash = 0;
+
+    bench_begin(b);
+
+    for(int round = 0; round < rounds; ++round) {
+        for(int i = 0; i < NUM_RESOURCE_NAMES; ++i) {
+            hash += hashfunc(0, resource_names[i]);
+        }
+    }
+
+    bench_end(b);
+    b->ops = rounds * NUM_RESOURCE_NAMES;
+    bench_mix(b, hash);
+}
+
+static void bench_crc32str(BenchState *b) {
+    bench_crc32(b, crc32str);
+}
+
+static void bench_crc32str_sse42(BenchState *b) {
+    // falls back to crc32str in builds without HAVE_INTEL_INTRIN, so the numbers should match then
+    bench_crc32(b, crc32str_sse42);
+}
+
+static Benchmark benchmarks[] = {
+    { "list_append_unlink",         bench_list_append_unlink },
+    { "list_insert_at_priority",    bench_list_insert_at_priority },
+    { "hashtable_string_lookup",    bench_hashtable_string_lookup },
+    { "hashtable_interned_lookup",  bench_hashtable_interned_lookup },
+    { "hashtable_set_unset",        bench_hashtable_set_unset },
+    { "objpool_projectile_churn",   bench_objpool_churn },
+    { "zlib_deflate_replay",        bench_zlib_deflate_replay },
+    { "zlib_inflate_replay",        bench_zlib_inflate_replay },
+    { "crc32str",                   bench_crc32str },
+    { "crc32str_sse42",             bench_crc32str_sse42 },
+};
+
+static bool bench_selected(const Benchmark *bench, int argc, char **argv) {
+    if(argc < 2) {
+        return true;
+    }
+
+    for(int i = 1; i < argc; ++i) {
+        if(strstr(bench->name, argv[i])) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int cmp_times(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_benchmark(const Benchmark *bench, int repeats, bool first) {
+    double ns_per_op[repeats];
+    uint64_t ops = 0;
+    uint32_t checksum = 0;
+
+    for(int i = 0; i < repeats; ++i) {
+        BenchState b = { .checksum = 2166136261u };
+
+        // same seed every time, so every run does exactly the same work
+        tsrand_init(&b.rng, 0x7a15e1);
+        bench->func(&b);
+
+        if(i && (b.ops != ops || b.checksum != checksum)) {
+            log_warn("%s: run %i did different work than the first one", bench->name, i);
+        }
+
+        ops = b.ops;
+        checksum = b.checksum;
+        ns_per_op[i] = (double)(b.elapsed * 1e9 / b.ops);
+    }
+
+    qsort(ns_per_op, repeats, sizeof(double), cmp_times);
+
+    tsfprintf(stdout,
+        "%s\n"
+        "    {\n"
+        "      \"name\": \"%s\",\n"
+        "      \"ops\": %"PRIu64",\n"
+        "      \"checksum\": \"%08x\",\n"
+        "      \"min_ns_per_op\": %.3f,\n"
+        "      \"median_ns_per_op\": %.3f\n"
+        "    }",
+        first ? "" : ",",
+        bench->name, ops, checksum, ns_per_op[0], ns_per_op[repeats / 2]
+    );
+}
+
+int main(int argc, char **argv) {
+    log_init(LOG_ALERT, LOG_FATAL);
+    log_add_output(LOG_ALERT, SDL_RWFromFP(stderr, false));
+    time_init();
+    init_resource_names();
+
+    int repeats = getenvint("TAISEI_BENCH_REPEATS", 7);
+
+    if(repeats < 1) {
+        repeats = 1;
+    }
+
+    tsfprintf(stdout,
+        "{\n"
+        "  \"version\": %i,\n"
+        "  \"repeats\": %i,\n"
+        "  \"benchmarks\": [",
+        BENCH_FORMAT_VERSION, repeats
+    );
+
+    bool first = true;
+
+    for(int i = 0; i < sizeof(benchmarks)/sizeof(*benchmarks); ++i) {
+        if(bench_selected(benchmarks + i, argc, argv)) {
+            run_benchmark(benchmarks + i, repeats, first);
+            first = false;
+        }
+    }
+
+    tsfprintf(stdout, "\n  ]\n}\n");
+
+    free_resource_names();
+    intern_shutdown();
+    time_shutdown();
+    log_shutdown();
+    return 0;
+}
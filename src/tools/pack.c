@@ -0,0 +1,392 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+/*
+ *  taisei-pack: builds a .tpk package (see vfs/pakfile_format.h) out of a directory tree.
+ *  This is a build-time tool; it only needs libc and zlib, and doesn't link against the game.
+ *
+ *  Usage: taisei-pack [-0..-9] <output.tpk> <directory>
+ *
+ *  -0 stores everything uncompressed; -1..-9 set the zlib level (default: 9).
+ *  Files are only stored compressed if that saves a meaningful amount of space; already compressed
+ *  formats (png, ogg, ...) end up stored as-is and can be mapped directly at runtime.
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "vfs/pakfile_format.h"
+
+typedef struct PackItem {
+    char *path;     // relative to the package root, '/'-separated
+    char *srcpath;  // on the filesystem
+    bool is_dir;
+    size_t parent;  // index into the collection array, or SIZE_MAX
+    size_t final;   // position in the package index
+    PakEntry entry;
+} PackItem;
+
+typedef struct PackItems {
+    PackItem *items;
+    size_t num;
+    size_t capacity;
+} PackItems;
+
+static int compress_level = Z_BEST_COMPRESSION;
+
+static void* xalloc(void *ptr, size_t size) {
+    ptr = realloc(ptr, size);
+
+    if(!ptr && size) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+
+    return ptr;
+}
+
+static char* join(const char *a, const char *sep, const char *b) {
+    size_t alen = strlen(a), slen = strlen(sep), blen = strlen(b);
+    char *r = xalloc(NULL, alen + slen + blen + 1);
+    memcpy(r, a, alen);
+    memcpy(r + alen, sep, slen);
+    memcpy(r + alen + slen, b, blen + 1);
+    return r;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static size_t add_item(PackItems *items, const char *path, const char *srcpath, bool is_dir, size_t parent) {
+    if(items->num == items->capacity) {
+        items->capacity = items->capacity ? items->capacity * 2 : 256;
+        items->items = xalloc(items->items, items->capacity * sizeof(PackItem));
+    }
+
+    PackItem *item = items->items + items->num;
+    memset(item, 0, sizeof(PackItem));
+    item->path = strdup(path);
+    item->srcpath = strdup(srcpath);
+    item->is_dir = is_dir;
+    item->parent = parent;
+    item->entry.hash = pak_hash(path, strlen(path));
+
+    return items->num++;
+}
+
+static void collect(PackItems *items, const char *srcdir, const char *reldir, size_t parent) {
+    DIR *dir = opendir(srcdir);
+
+    if(!dir) {
+        fprintf(stderr, "Can't open directory %s\n", srcdir);
+        exit(1);
+    }
+
+    // read the whole listing first, so that the result doesn't depend on the filesystem's ordering
+    char **names = NULL;
+    size_t num_names = 0;
+
+    for(struct dirent *e; (e = readdir(dir));) {
+        if(!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) {
+            continue;
+        }
+
+        names = xalloc(names, ++num_names * sizeof(char*));
+        names[num_names - 1] = strdup(e->d_name);
+    }
+
+    closedir(dir);
+    qsort(names, num_names, sizeof(char*), compare_names);
+
+    for(size_t i = 0; i < num_names; ++i) {
+        char *srcpath = join(srcdir, "/", names[i]);
+        char *relpath = *reldir ? join(reldir, "/", names[i]) : strdup(names[i]);
+        struct stat st;
+
+        if(stat(srcpath, &st)) {
+            fprintf(stderr, "Can't stat %s\n", srcpath);
+            exit(1);
+        }
+
+        if(S_ISDIR(st.st_mode)) {
+            size_t idx = add_item(items, relpath, srcpath, true, parent);
+            collect(items, srcpath, relpath, idx);
+        } else if(S_ISREG(st.st_mode)) {
+            add_item(items, relpath, srcpath, false, parent);
+        } else {
+            fprintf(stderr, "Skipping %s: not a regular file\n", srcpath);
+        }
+
+        free(srcpath);
+        free(relpath);
+        free(names[i]);
+    }
+
+    free(names);
+}
+
+static int compare_index_order(const void *a, const void *b) {
+    const PackItem *i1 = *(PackItem* const*)a;
+    const PackItem *i2 = *(PackItem* const*)b;
+
+    if(i1->entry.hash != i2->entry.hash) {
+        return i1->entry.hash < i2->entry.hash ? -1 : 1;
+    }
+
+    return strcmp(i1->path, i2->path);
+}
+
+static void put32(uint8_t **p, uint32_t v) {
+    for(int i = 0; i < 4; ++i) {
+        *(*p)++ = (v >> (i * 8)) & 0xFF;
+    }
+}
+
+static void put64(uint8_t **p, uint64_t v) {
+    for(int i = 0; i < 8; ++i) {
+        *(*p)++ = (v >> (i * 8)) & 0xFF;
+    }
+}
+
+static uint8_t* read_file(const char *path, uint64_t *size) {
+    FILE *in = fopen(path, "rb");
+
+    if(!in) {
+        fprintf(stderr, "Can't open %s\n", path);
+        exit(1);
+    }
+
+    uint8_t *data = NULL;
+    size_t len = 0, cap = 0, r;
+
+    do {
+        if(len == cap) {
+            cap = cap ? cap * 2 : 65536;
+            data = xalloc(data, cap);
+        }
+
+        len += r = fread(data + len, 1, cap - len, in);
+    } while(r);
+
+    if(ferror(in)) {
+        fprintf(stderr, "Error reading %s\n", path);
+        exit(1);
+    }
+
+    fclose(in);
+    *size = len;
+    return data;
+}
+
+static void write_data(FILE *out, const void *data, size_t size, const char *outpath) {
+    if(size && fwrite(data, size, 1, out) != 1) {
+        fprintf(stderr, "Error writing %s\n", outpath);
+        exit(1);
+    }
+}
+
+static uint64_t pad_to_alignment(FILE *out, uint64_t pos, const char *outpath) {
+    static const uint8_t zeros[PAK_ALIGNMENT];
+    uint64_t aligned = (pos + PAK_ALIGNMENT - 1) / PAK_ALIGNMENT * PAK_ALIGNMENT;
+    write_data(out, zeros, aligned - pos, outpath);
+    return aligned;
+}
+
+static void pack_file(FILE *out, PackItem *item, uint64_t *pos, const char *outpath) {
+    uint64_t size;
+    uint8_t *data = read_file(item->srcpath, &size);
+    uint8_t *stored = data;
+    uint64_t stored_size = size;
+    uint8_t *zdata = NULL;
+
+    if(compress_level > 0 && size > 0) {
+        uLongf zsize = compressBound(size);
+        zdata = xalloc(NULL, zsize);
+
+        // only worth it if it saves at least 1/8 of the file; otherwise keep it mappable
+        if(compress2(zdata, &zsize, data, size, compress_level) == Z_OK && zsize < size - size / 8) {
+            stored = zdata;
+            stored_size = zsize;
+            item->entry.flags |= PAK_ENTRY_DEFLATE;
+        }
+    }
+
+    // reported as the entry's modification stamp, so that caches derived from it notice changes
+    uLong crc = crc32(0L, Z_NULL, 0);
+
+    for(uint64_t ofs = 0; ofs < size;) {
+        uInt chunk = size - ofs > UINT32_MAX ? UINT32_MAX : (uInt)(size - ofs);
+        crc = crc32(crc, data + ofs, chunk);
+        ofs += chunk;
+    }
+
+    item->entry.checksum = crc;
+
+    *pos = pad_to_alignment(out, *pos, outpath);
+    item->entry.offset = *pos;
+    item->entry.size = size;
+    item->entry.stored_size = stored_size;
+    write_data(out, stored, stored_size, outpath);
+    *pos += stored_size;
+
+    free(zdata);
+    free(data);
+}
+
+static int compare_paths(const void *a, const void *b) {
+    return strcmp((*(PackItem* const*)a)->path, (*(PackItem* const*)b)->path);
+}
+
+static void pack(PackItems *items, const char *outpath) {
+    PackItem *sorted[items->num ? items->num : 1];
+
+    for(size_t i = 0; i < items->num; ++i) {
+        sorted[i] = items->items + i;
+    }
+
+    // index order: by hash, so that the VFS can binary search it
+    qsort(sorted, items->num, sizeof(PackItem*), compare_index_order);
+
+    size_t names_size = 0;
+
+    for(size_t i = 0; i < items->num; ++i) {
+        PackItem *item = sorted[i];
+        item->final = i;
+        item->entry.name_offset = names_size;
+        item->entry.name_len = strlen(item->path);
+        item->entry.flags = item->is_dir ? PAK_ENTRY_DIR : 0;
+        names_size += item->entry.name_len + 1;
+    }
+
+    for(size_t i = 0; i < items->num; ++i) {
+        PackItem *item = items->items + i;
+        item->entry.parent = item->parent == SIZE_MAX ? PAK_NO_PARENT : items->items[item->parent].final;
+    }
+
+    uint64_t names_offset = items->num * sizeof(PakEntry);
+    uint64_t index_size = names_offset + names_size;
+
+    FILE *out = fopen(outpath, "wb");
+
+    if(!out) {
+        fprintf(stderr, "Can't open %s for writing\n", outpath);
+        exit(1);
+    }
+
+    // data order: by path, so that files from the same directory end up next to each other
+    uint64_t pos = sizeof(PakHeader) + index_size;
+    uint8_t *placeholder = xalloc(NULL, pos);
+    memset(placeholder, 0, pos);
+    write_data(out, placeholder, pos, outpath);
+    free(placeholder);
+
+    qsort(sorted, items->num, sizeof(PackItem*), compare_paths);
+
+    for(size_t i = 0; i < items->num; ++i) {
+        if(!sorted[i]->is_dir) {
+            pack_file(out, sorted[i], &pos, outpath);
+        }
+    }
+
+    qsort(sorted, items->num, sizeof(PackItem*), compare_index_order);
+
+    uint8_t *index = xalloc(NULL, sizeof(PakHeader) + index_size);
+    uint8_t *p = index;
+
+    memcpy(p, PAK_MAGIC, PAK_MAGIC_SIZE);
+    p += PAK_MAGIC_SIZE;
+    put32(&p, PAK_VERSION);
+    put32(&p, items->num);
+    put64(&p, sizeof(PakHeader));
+    put64(&p, index_size);
+    put64(&p, names_offset);
+    put32(&p, PAK_ALIGNMENT);
+
+    for(int i = 0; i < 5; ++i) {
+        put32(&p, 0);
+    }
+
+    for(size_t i = 0; i < items->num; ++i) {
+        PakEntry *e = &sorted[i]->entry;
+        put32(&p, e->hash);
+        put32(&p, e->name_offset);
+        put32(&p, e->name_len);
+        put32(&p, e->parent);
+        put32(&p, e->flags);
+        put32(&p, e->checksum);
+        put64(&p, e->offset);
+        put64(&p, e->size);
+        put64(&p, e->stored_size);
+    }
+
+    for(size_t i = 0; i < items->num; ++i) {
+        memcpy(p, sorted[i]->path, sorted[i]->entry.name_len + 1);
+        p += sorted[i]->entry.name_len + 1;
+    }
+
+    if(fseek(out, 0, SEEK_SET)) {
+        fprintf(stderr, "Can't seek in %s\n", outpath);
+        exit(1);
+    }
+
+    write_data(out, index, p - index, outpath);
+    free(index);
+
+    if(fclose(out)) {
+        fprintf(stderr, "Error writing %s\n", outpath);
+        exit(1);
+    }
+
+    uint64_t total_size = 0, total_stored = 0, num_compressed = 0;
+
+    for(size_t i = 0; i < items->num; ++i) {
+        total_size += items->items[i].entry.size;
+        total_stored += items->items[i].entry.stored_size;
+        num_compressed += (items->items[i].entry.flags & PAK_ENTRY_DEFLATE) != 0;
+    }
+
+    printf("%s: %zu entries (%llu compressed), %llu bytes of data stored in %llu bytes, package size %llu bytes\n",
+        outpath, items->num, (unsigned long long)num_compressed,
+        (unsigned long long)total_size, (unsigned long long)total_stored, (unsigned long long)pos);
+}
+
+int main(int argc, char **argv) {
+    int argi = 1;
+
+    if(argi < argc && argv[argi][0] == '-' && argv[argi][1] >= '0' && argv[argi][1] <= '9' && !argv[argi][2]) {
+        compress_level = argv[argi][1] - '0';
+        ++argi;
+    }
+
+    if(argc - argi != 2) {
+        fprintf(stderr, "Usage: %s [-0..-9] <output%s> <directory>\n", argv[0], PAK_EXTENSION);
+        return 1;
+    }
+
+    PackItems items = { 0 };
+    collect(&items, argv[argi + 1], "", SIZE_MAX);
+    pack(&items, argv[argi]);
+
+    for(size_t i = 0; i < items.num; ++i) {
+        free(items.items[i].path);
+        free(items.items[i].srcpath);
+    }
+
+    free(items.items);
+    return 0;
+}
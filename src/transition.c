@@ -20,10 +20,40 @@ void TransFadeWhite(double fade) {
 	colorfill(1, 1, 1, fade);
 }
 
+static void draw_preload_progress(double fade) {
+	double progress = resource_preload_progress();
+
+	if(progress >= 1) {
+		return;
+	}
+
+	float w = SCREEN_W * 0.5, h = 4;
+
+	glDisable(GL_TEXTURE_2D);
+	glPushMatrix();
+	glTranslatef(SCREEN_W/2, SCREEN_H - 40, 0);
+
+	glPushMatrix();
+	glScalef(w, h, 1);
+	glColor4f(1, 1, 1, 0.25 * fade);
+	draw_quad();
+	glPopMatrix();
+
+	glTranslatef(-w * (1 - progress) / 2, 0, 0);
+	glScalef(w * progress, h, 1);
+	glColor4f(1, 1, 1, fade);
+	draw_quad();
+
+	glPopMatrix();
+	glColor4f(1, 1, 1, 1);
+	glEnable(GL_TEXTURE_2D);
+}
+
 void TransLoader(double fade) {
 	glColor4f(1, 1, 1, fade);
 	draw_texture(SCREEN_W/2, SCREEN_H/2, "loading");
 	glColor4f(1, 1, 1, 1);
+	draw_preload_progress(fade);
 }
 
 void TransMenu(double fade) {
@@ -349,6 +349,9 @@ void loop_at_fps(bool (*frame_func)(void*), bool (*limiter_cond_func)(void*), vo
 
     // fpscounter_reset(&global.fps_busy);
 
+    // this loop may be nested in a frame of another one, so only rewind what our own frames allocate
+    MemArenaMark frame_mark = marena_mark(&frame_arena);
+
     while(true) {
         real_time = time_get();
 
@@ -357,9 +360,13 @@ void loop_at_fps(bool (*frame_func)(void*), bool (*limiter_cond_func)(void*), vo
         }
 
 begin_frame:
+        marena_rewind(&frame_arena, frame_mark);
         global.fps_busy.last_update_time = time_get();
+        video_update_screenshots();
         glClear(GL_COLOR_BUFFER_BIT);
 
+        resource_update_async_loads();
+
         if(!frame_func(arg)) {
             return;
         }
@@ -452,7 +459,7 @@ char* read_all(const char *filename, int *outsize) {
     char *text;
     size_t size;
 
-    SDL_RWops *file = vfs_open(filename, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+    SDL_RWops *file = vfs_open(filename, VFS_MODE_READ | VFS_MODE_SEEKABLE | VFS_MODE_MAP);
 
     if(!file) {
         log_warn("VFS error: %s", vfs_get_error());
@@ -529,7 +536,7 @@ bool parse_keyvalue_stream_cb(SDL_RWops *strm, KVCallback callback, void *data)
 }
 
 bool parse_keyvalue_file_cb(const char *filename, KVCallback callback, void *data) {
-    SDL_RWops *strm = vfs_open(filename, VFS_MODE_READ);
+    SDL_RWops *strm = vfs_open(filename, VFS_MODE_READ | VFS_MODE_MAP);
 
     if(!strm) {
         log_warn("VFS error: %s", vfs_get_error());
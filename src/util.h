@@ -17,6 +17,7 @@
 #include <SDL.h>
 #include "util_sse42.h"
 #include "hashtable.h"
+#include "memarena.h"
 #include "vfs/public.h"
 #include "log.h"
 #include "compat.h"
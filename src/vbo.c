@@ -7,6 +7,7 @@
  */
 
 #include "vbo.h"
+#include <stdlib.h>
 #include <string.h>
 #include "log.h"
 
@@ -15,6 +16,8 @@ VBO _vbo;
 void init_vbo(VBO *vbo, int size) {
 	memset(vbo, 0, sizeof(VBO));
 	vbo->size = size;
+	vbo->initial_size = size;
+	vbo->shadow = calloc(size, sizeof(Vertex));
 
 	glGenBuffers(1, &vbo->vbo);
 
@@ -32,13 +35,136 @@ void init_vbo(VBO *vbo, int size) {
 	glEnableClientState(GL_NORMAL_ARRAY);
 }
 
+static void vbo_resize(VBO *vbo, int size) {
+	log_debug("Resizing VBO %u: %i -> %i vertices (%i in use)", vbo->vbo, vbo->size, size, vbo->offset - vbo->holes);
+
+	vbo->shadow = realloc(vbo->shadow, sizeof(Vertex)*size);
+	vbo->size = size;
+
+	// Reallocating the storage of the same buffer object keeps the vertex array pointers valid.
+	glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex)*size, NULL, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex)*vbo->offset, vbo->shadow);
+}
+
+VBOBlock* vbo_alloc_verts(VBO *vbo, Vertex *verts, int count) {
+	VBOBlock *block = calloc(1, sizeof(VBOBlock));
+	VBOBlock *prev = NULL;
+	int offset = 0;
+
+	block->count = count;
+
+	if(vbo->holes >= count) {
+		// first fit into a gap between existing blocks
+		for(VBOBlock *b = vbo->blocks; b; prev = b, b = b->next) {
+			if(b->offset - offset >= count) {
+				break;
+			}
+
+			offset = b->offset + b->count;
+		}
+
+		if(prev == vbo->last_block) {
+			offset = vbo->offset;
+		} else {
+			vbo->holes -= count;
+		}
+	} else {
+		prev = vbo->last_block;
+		offset = vbo->offset;
+	}
+
+	if(offset + count > vbo->size) {
+		int size = vbo->size;
+
+		while(offset + count > size) {
+			size *= 2;
+		}
+
+		vbo_resize(vbo, size);
+	}
+
+	block->offset = offset;
+	block->prev = prev;
+
+	if(prev) {
+		block->next = prev->next;
+		prev->next = block;
+	} else {
+		block->next = vbo->blocks;
+		vbo->blocks = block;
+	}
+
+	if(block->next) {
+		block->next->prev = block;
+	} else {
+		vbo->last_block = block;
+		vbo->offset = offset + count;
+	}
+
+	memcpy(vbo->shadow + offset, verts, sizeof(Vertex)*count);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex)*offset, sizeof(Vertex)*count, verts);
+
+	return block;
+}
+
 void vbo_add_verts(VBO *vbo, Vertex *verts, int count) {
-	if(vbo->offset + count > vbo->size)
-		log_fatal("Cannot add Vertices: VBO too small!");
+	// for permanent data that is never freed; the block will be reclaimed in delete_vbo
+	vbo_alloc_verts(vbo, verts, count);
+}
 
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex)*vbo->offset, sizeof(Vertex)*count, verts);
+void vbo_free_verts(VBO *vbo, VBOBlock *block) {
+	if(block->prev) {
+		block->prev->next = block->next;
+	} else {
+		vbo->blocks = block->next;
+	}
+
+	if(block->next) {
+		block->next->prev = block->prev;
+		vbo->holes += block->count;
+	} else {
+		vbo->last_block = block->prev;
+		vbo->offset = block->prev ? block->prev->offset + block->prev->count : 0;
+		vbo->holes -= block->offset - vbo->offset;
+	}
+
+	free(block);
+}
+
+void vbo_compact(VBO *vbo) {
+	if(vbo->holes) {
+		int offset = 0;
+
+		for(VBOBlock *b = vbo->blocks; b; b = b->next) {
+			if(b->offset != offset) {
+				memmove(vbo->shadow + offset, vbo->shadow + b->offset, sizeof(Vertex)*b->count);
+				b->offset = offset;
+			}
+
+			offset += b->count;
+		}
+
+		log_debug("Compacted VBO %u: %i -> %i vertices", vbo->vbo, vbo->offset, offset);
+
+		vbo->offset = offset;
+		vbo->holes = 0;
 
-	vbo->offset += count;
+		glBindBuffer(GL_ARRAY_BUFFER, vbo->vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex)*offset, vbo->shadow);
+	}
+
+	int size = vbo->size;
+
+	while(size > vbo->initial_size && vbo->offset <= size / 4) {
+		size /= 2;
+	}
+
+	if(size != vbo->size) {
+		vbo_resize(vbo, size);
+	}
 }
 
 void init_quadvbo(void) {
@@ -63,6 +189,14 @@ void init_quadvbo(void) {
 
 void delete_vbo(VBO *vbo) {
 	glDeleteBuffers(1, &vbo->vbo);
+
+	for(VBOBlock *b = vbo->blocks, *next; b; b = next) {
+		next = b->next;
+		free(b);
+	}
+
+	free(vbo->shadow);
+	memset(vbo, 0, sizeof(VBO));
 }
 
 void draw_quad(void) {
@@ -14,18 +14,9 @@
 #include "taiseigl.h"
 
 enum {
-	VBO_SIZE = 8192, // * sizeof(Vertex)
+	VBO_SIZE = 8192, // * sizeof(Vertex), initial size; the buffer grows as needed
 };
 
-typedef struct VBO VBO;
-struct VBO {
-	GLuint vbo;
-	int offset;
-	int size;
-};
-
-extern VBO _vbo;
-
 typedef struct Vertex Vertex;
 struct Vertex {
 	Vector x;
@@ -34,8 +25,39 @@ struct Vertex {
 	float t;
 };
 
+// A contiguous range of vertices owned by someone (e.g. a model).
+// The offset may change when the VBO is compacted.
+typedef struct VBOBlock VBOBlock;
+struct VBOBlock {
+	VBOBlock *next;
+	VBOBlock *prev;
+	int offset;
+	int count;
+};
+
+typedef struct VBO VBO;
+struct VBO {
+	GLuint vbo;
+	int offset; // end of the last allocated block
+	int size;
+	int initial_size;
+	int holes; // number of vertices in the gaps between blocks
+
+	// CPU-side copy of the buffer, used to refill it when growing or compacting
+	Vertex *shadow;
+
+	// live allocations, ordered by offset
+	VBOBlock *blocks;
+	VBOBlock *last_block;
+};
+
+extern VBO _vbo;
+
 void init_vbo(VBO *vbo, int size);
 void vbo_add_verts(VBO *vbo, Vertex *verts, int count);
+VBOBlock* vbo_alloc_verts(VBO *vbo, Vertex *verts, int count);
+void vbo_free_verts(VBO *vbo, VBOBlock *block);
+void vbo_compact(VBO *vbo);
 
 void init_quadvbo(void);
 void draw_quad(void);
@@ -0,0 +1,324 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "pakfile.h"
+#include "pakfile_impl.h"
+
+static void vfs_pakfile_free(VFSNode *node) {
+    if(node) {
+        VFSPakFileData *pdata = node->data1;
+
+        if(pdata) {
+            vfs_unmap(pdata->mapping);
+            free(pdata->index_copy);
+
+            if(pdata->source) {
+                vfs_decref(pdata->source);
+            }
+
+            free(pdata);
+        }
+    }
+}
+
+static VFSInfo vfs_pakfile_query(VFSNode *node) {
+    return (VFSInfo) {
+        .exists = true,
+        .is_dir = true,
+    };
+}
+
+static char* vfs_pakfile_syspath(VFSNode *node) {
+    VFSPakFileData *pdata = node->data1;
+
+    if(pdata->source->funcs->syspath) {
+        return pdata->source->funcs->syspath(pdata->source);
+    }
+
+    return NULL;
+}
+
+static char* vfs_pakfile_repr(VFSNode *node) {
+    VFSPakFileData *pdata = node->data1;
+    char *srcrepr = vfs_repr_node(pdata->source, false);
+    char *pakrepr = strfmt("package %s", srcrepr);
+    free(srcrepr);
+    return pakrepr;
+}
+
+static int64_t vfs_pakfile_lookup(VFSPakFileData *pdata, const char *path) {
+    size_t len = strlen(path);
+    uint32_t hash = pak_hash(path, len);
+    uint32_t lo = 0, hi = pdata->num_entries;
+
+    // find the first entry with this hash
+    while(lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if(pdata->entries[mid].hash < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    for(; lo < pdata->num_entries && pdata->entries[lo].hash == hash; ++lo) {
+        const PakEntry *e = pdata->entries + lo;
+
+        if(e->name_len == len && !memcmp(vfs_pakfile_entry_name(pdata, e), path, len)) {
+            return lo;
+        }
+    }
+
+    return -1;
+}
+
+static VFSNode* vfs_pakfile_locate(VFSNode *node, const char *path) {
+    VFSPakFileData *pdata = node->data1;
+    int64_t idx = vfs_pakfile_lookup(pdata, path);
+
+    if(idx < 0) {
+        return NULL;
+    }
+
+    VFSNode *n = vfs_alloc();
+    vfs_pakpath_init(n, node, idx);
+    return n;
+}
+
+const char* vfs_pakfile_iter_shared(VFSPakFileData *pdata, uint32_t parent, void **opaque) {
+    VFSPakFileIterData *idata = *opaque;
+
+    if(!idata) {
+        *opaque = idata = calloc(1, sizeof(VFSPakFileIterData));
+        idata->parent = parent;
+    }
+
+    for(; idata->idx < pdata->num_entries; ++idata->idx) {
+        const PakEntry *e = pdata->entries + idata->idx;
+
+        if(e->parent == idata->parent) {
+            const char *name = vfs_pakfile_entry_name(pdata, e);
+            const char *sep = strrchr(name, '/');
+            ++idata->idx;
+            return sep ? sep + 1 : name;
+        }
+    }
+
+    return NULL;
+}
+
+static const char* vfs_pakfile_iter(VFSNode *node, void **opaque) {
+    return vfs_pakfile_iter_shared(node->data1, PAK_NO_PARENT, opaque);
+}
+
+void vfs_pakfile_iter_stop(VFSNode *node, void **opaque) {
+    free(*opaque);
+    *opaque = NULL;
+}
+
+static VFSNodeFuncs vfs_funcs_pakfile = {
+    .repr = vfs_pakfile_repr,
+    .query = vfs_pakfile_query,
+    .free = vfs_pakfile_free,
+    .syspath = vfs_pakfile_syspath,
+    .locate = vfs_pakfile_locate,
+    .iter = vfs_pakfile_iter,
+    .iter_stop = vfs_pakfile_iter_stop,
+};
+
+static bool vfs_pakfile_read_index(VFSNode *node, PakHeader *hdr, uint64_t *pak_size) {
+    VFSPakFileData *pdata = node->data1;
+    VFSNode *source = pdata->source;
+
+    if(source->funcs->map) {
+        pdata->mapping = source->funcs->map(source);
+    }
+
+    if(pdata->mapping) {
+        *pak_size = pdata->mapping->size;
+
+        if(*pak_size < sizeof(PakHeader)) {
+            vfs_set_error("File is too small to be a package");
+            return false;
+        }
+
+        memcpy(hdr, pdata->mapping->data, sizeof(PakHeader));
+    } else {
+        // can't map it; read the index into memory and open the entries as segments of the source instead
+        if(!source->funcs->open) {
+            vfs_set_error("Package source can't be opened");
+            return false;
+        }
+
+        SDL_RWops *rw = source->funcs->open(source, VFS_MODE_READ | VFS_MODE_SEEKABLE);
+
+        if(!rw) {
+            return false;
+        }
+
+        Sint64 rwsize = SDL_RWsize(rw);
+
+        if(rwsize < 0) {
+            vfs_set_error("Failed to determine the package size: %s", SDL_GetError());
+            SDL_RWclose(rw);
+            return false;
+        }
+
+        *pak_size = rwsize;
+
+        if(SDL_RWread(rw, hdr, sizeof(PakHeader), 1) != 1) {
+            vfs_set_error("Failed to read the package header: %s", SDL_GetError());
+            SDL_RWclose(rw);
+            return false;
+        }
+
+        uint64_t index_offset = SDL_SwapLE64(hdr->index_offset);
+        uint64_t index_size = SDL_SwapLE64(hdr->index_size);
+
+        // checked separately, so that a corrupt header can't wrap the sum around
+        if(index_offset > *pak_size || index_size > *pak_size - index_offset || index_size > SIZE_MAX) {
+            vfs_set_error("Package index is out of bounds");
+            SDL_RWclose(rw);
+            return false;
+        }
+
+        pdata->index_copy = malloc(index_size);
+
+        if(
+            SDL_RWseek(rw, index_offset, RW_SEEK_SET) < 0 ||
+            (index_size && SDL_RWread(rw, pdata->index_copy, index_size, 1) != 1)
+        ) {
+            vfs_set_error("Failed to read the package index: %s", SDL_GetError());
+            SDL_RWclose(rw);
+            return false;
+        }
+
+        SDL_RWclose(rw);
+    }
+
+    hdr->version = SDL_SwapLE32(hdr->version);
+    hdr->num_entries = SDL_SwapLE32(hdr->num_entries);
+    hdr->index_offset = SDL_SwapLE64(hdr->index_offset);
+    hdr->index_size = SDL_SwapLE64(hdr->index_size);
+    hdr->names_offset = SDL_SwapLE64(hdr->names_offset);
+    hdr->alignment = SDL_SwapLE32(hdr->alignment);
+
+    if(memcmp(hdr->magic, PAK_MAGIC, PAK_MAGIC_SIZE)) {
+        vfs_set_error("Not a package (bad magic)");
+        return false;
+    }
+
+    if(hdr->version != PAK_VERSION) {
+        vfs_set_error("Unsupported package version %u", hdr->version);
+        return false;
+    }
+
+    if(
+        hdr->index_offset > *pak_size ||
+        hdr->index_size > *pak_size - hdr->index_offset ||
+        hdr->names_offset > hdr->index_size ||
+        hdr->num_entries > hdr->names_offset / sizeof(PakEntry)
+    ) {
+        vfs_set_error("Package index is corrupted");
+        return false;
+    }
+
+    if(pdata->mapping) {
+        const char *index = (const char*)pdata->mapping->data + hdr->index_offset;
+
+        if(SDL_BYTEORDER == SDL_BIG_ENDIAN || (uintptr_t)index % _Alignof(PakEntry)) {
+            pdata->index_copy = malloc(hdr->index_size);
+            memcpy(pdata->index_copy, index, hdr->index_size);
+        } else {
+            pdata->entries = (const PakEntry*)index;
+        }
+    }
+
+    if(pdata->index_copy) {
+        pdata->entries = pdata->index_copy;
+
+    #if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        for(PakEntry *e = pdata->index_copy, *end = e + hdr->num_entries; e < end; ++e) {
+            e->hash = SDL_SwapLE32(e->hash);
+            e->name_offset = SDL_SwapLE32(e->name_offset);
+            e->name_len = SDL_SwapLE32(e->name_len);
+            e->parent = SDL_SwapLE32(e->parent);
+            e->flags = SDL_SwapLE32(e->flags);
+            e->checksum = SDL_SwapLE32(e->checksum);
+            e->offset = SDL_SwapLE64(e->offset);
+            e->size = SDL_SwapLE64(e->size);
+            e->stored_size = SDL_SwapLE64(e->stored_size);
+        }
+    #endif
+    }
+
+    pdata->names = (const char*)pdata->entries + hdr->names_offset;
+    pdata->num_entries = hdr->num_entries;
+
+    return true;
+}
+
+static bool vfs_pakfile_validate(VFSPakFileData *pdata, const PakHeader *hdr, uint64_t pak_size) {
+    // everything past this point trusts the index, so make sure a truncated or damaged package can't send us out of bounds
+    uint64_t names_size = hdr->index_size - hdr->names_offset;
+
+    for(uint32_t i = 0; i < pdata->num_entries; ++i) {
+        const PakEntry *e = pdata->entries + i;
+
+        if(
+            (uint64_t)e->name_offset + e->name_len >= names_size ||
+            pdata->names[e->name_offset + e->name_len] != 0 ||
+            (e->parent != PAK_NO_PARENT && (e->parent >= pdata->num_entries || !(pdata->entries[e->parent].flags & PAK_ENTRY_DIR))) ||
+            e->offset > pak_size ||
+            e->stored_size > pak_size - e->offset ||
+            (i && e->hash < pdata->entries[i - 1].hash)
+        ) {
+            vfs_set_error("Package entry %u is corrupted", i);
+            return false;
+        }
+
+        if(!(e->flags & PAK_ENTRY_DEFLATE) && e->size != e->stored_size) {
+            vfs_set_error("Package entry %u is corrupted", i);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool vfs_pakfile_init(VFSNode *node, VFSNode *source) {
+    VFSNode backup;
+    memcpy(&backup, node, sizeof(VFSNode));
+
+    VFSPakFileData *pdata = calloc(1, sizeof(VFSPakFileData));
+    pdata->source = source;
+
+    node->data1 = pdata;
+    node->funcs = &vfs_funcs_pakfile;
+
+    PakHeader hdr;
+    uint64_t pak_size;
+
+    if(!vfs_pakfile_read_index(node, &hdr, &pak_size) || !vfs_pakfile_validate(pdata, &hdr, pak_size)) {
+        char *r = vfs_repr_node(source, true);
+        char *e = strdup(vfs_get_error());
+        vfs_set_error("Failed to open package '%s': %s", r, e);
+        free(e);
+        free(r);
+        goto error;
+    }
+
+    return true;
+
+error:
+    pdata->source = NULL; // don't decref it
+    node->funcs->free(node);
+    memcpy(node, &backup, sizeof(VFSNode));
+    return false;
+}
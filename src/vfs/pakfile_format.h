@@ -0,0 +1,76 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#pragma once
+
+/*
+ *  On-disk layout of Taisei's native .tpk packages.
+ *  Shared between the VFS and the build-time packer, so this must not depend on anything but libc.
+ *
+ *  [PakHeader] [PakEntry × num_entries] [names] ... padding ... [entry data, each PAK_ALIGNMENT-aligned] ...
+ *
+ *  All integers are little-endian. The whole package is meant to be mapped into memory as-is:
+ *  the index is read in place, and uncompressed entries are served straight from the mapping.
+ *
+ *  Entries are sorted by (hash, name), so a lookup is a binary search on the hash followed by a
+ *  name comparison. Directories are stored as entries too, and every entry knows the index of its
+ *  parent directory, which makes listing a directory a linear scan without any string processing.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PAK_MAGIC "TAISEIPK"
+#define PAK_MAGIC_SIZE 8
+#define PAK_VERSION 2
+#define PAK_ALIGNMENT 4096
+#define PAK_NO_PARENT UINT32_MAX
+#define PAK_EXTENSION ".tpk"
+
+typedef enum PakEntryFlags {
+    PAK_ENTRY_DIR = 1,
+    PAK_ENTRY_DEFLATE = 2, // stored as a zlib stream; stored_size is the compressed size
+} PakEntryFlags;
+
+typedef struct PakHeader {
+    char magic[PAK_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t num_entries;
+    uint64_t index_offset;  // absolute offset of the entry table
+    uint64_t index_size;    // size of the entry table + the names block
+    uint64_t names_offset;  // relative to index_offset
+    uint32_t alignment;
+    uint32_t reserved[5];
+} PakHeader;
+
+typedef struct PakEntry {
+    uint32_t hash;          // pak_hash() of the full normalized path
+    uint32_t name_offset;   // relative to the names block; names are NUL-terminated
+    uint32_t name_len;      // not including the terminator
+    uint32_t parent;        // index of the parent directory entry, or PAK_NO_PARENT for top-level entries
+    uint32_t flags;
+    uint32_t checksum;      // crc32 of the uncompressed data; 0 for directories
+    uint64_t offset;        // absolute offset of the data
+    uint64_t size;          // uncompressed size
+    uint64_t stored_size;   // size of the data as stored in the package
+} PakEntry;
+
+_Static_assert(sizeof(PakHeader) == 64, "PakHeader must be tightly packed");
+_Static_assert(sizeof(PakEntry) == 48, "PakEntry must be tightly packed");
+
+// FNV-1a
+static inline uint32_t pak_hash(const char *str, size_t len) {
+    uint32_t h = 2166136261u;
+
+    for(size_t i = 0; i < len; ++i) {
+        h ^= (uint8_t)str[i];
+        h *= 16777619u;
+    }
+
+    return h;
+}
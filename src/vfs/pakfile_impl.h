@@ -0,0 +1,43 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#pragma once
+#include "private.h"
+#include "pakfile_format.h"
+
+/* pakfile */
+
+typedef struct VFSPakFileData {
+    VFSNode *source;
+    VFSMapping *mapping;        // the whole package, if the source could be mapped
+    void *index_copy;           // private copy of the index, if it couldn't be used in place
+    const PakEntry *entries;
+    const char *names;
+    uint32_t num_entries;
+} VFSPakFileData;
+
+typedef struct VFSPakFileIterData {
+    uint32_t idx;
+    uint32_t parent;
+} VFSPakFileIterData;
+
+const char* vfs_pakfile_iter_shared(VFSPakFileData *pdata, uint32_t parent, void **opaque);
+void vfs_pakfile_iter_stop(VFSNode *node, void **opaque);
+
+static inline const char* vfs_pakfile_entry_name(VFSPakFileData *pdata, const PakEntry *e) {
+    return pdata->names + e->name_offset;
+}
+
+/* pakpath */
+
+typedef struct VFSPakPathData {
+    VFSNode *paknode;
+    uint32_t index;
+} VFSPakPathData;
+
+void vfs_pakpath_init(VFSNode *node, VFSNode *paknode, uint32_t index);
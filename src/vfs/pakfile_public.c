@@ -0,0 +1,36 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "pakfile.h"
+
+bool vfs_mount_pakfile(const char *mountpoint, const char *pakpath) {
+    char p[strlen(pakpath)+1];
+    pakpath = vfs_path_normalize(pakpath, p);
+    VFSNode *node = vfs_locate(vfs_root, pakpath);
+
+    if(!node) {
+        vfs_set_error("Node '%s' does not exist", pakpath);
+        return false;
+    }
+
+    VFSNode *pnode = vfs_alloc();
+
+    if(!vfs_pakfile_init(pnode, node)) {
+        vfs_decref(pnode);
+        vfs_decref(node);
+        return false;
+    }
+
+    if(!vfs_mount(vfs_root, mountpoint, pnode)) {
+        // this also releases the source node
+        vfs_decref(pnode);
+        return false;
+    }
+
+    return true;
+}
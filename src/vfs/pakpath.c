@@ -0,0 +1,255 @@
+/*
+ * This software is licensed under the terms of the MIT-License
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2017, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2017, Andrei Alexeyev <akari@alienslab.net>.
+ */
+
+#include "pakfile.h"
+#include "pakfile_impl.h"
+#include "syspath.h"
+#include "rwops/all.h"
+
+#define PAK_ZBUF_SIZE 65536
+
+typedef struct VFSPakMapping {
+    VFSMapping mapping;
+    VFSNode *paknode;
+} VFSPakMapping;
+
+static VFSPakFileData* vfs_pakpath_pak(VFSNode *node) {
+    return ((VFSPakPathData*)node->data1)->paknode->data1;
+}
+
+static const PakEntry* vfs_pakpath_entry(VFSNode *node) {
+    return vfs_pakpath_pak(node)->entries + ((VFSPakPathData*)node->data1)->index;
+}
+
+static const char* vfs_pakpath_name(VFSNode *node) {
+    return vfs_pakfile_entry_name(vfs_pakpath_pak(node), vfs_pakpath_entry(node));
+}
+
+static void vfs_pakpath_free(VFSNode *node) {
+    VFSPakPathData *pdata = node->data1;
+    vfs_decref(pdata->paknode);
+    free(pdata);
+}
+
+static char* vfs_pakpath_repr(VFSNode *node) {
+    VFSPakPathData *pdata = node->data1;
+    char *pakrepr = vfs_repr_node(pdata->paknode, false);
+    char *ppathrepr = strfmt("%s '%s' in %s",
+        (vfs_pakpath_entry(node)->flags & PAK_ENTRY_DIR) ? "directory" : "file", vfs_pakpath_name(node), pakrepr);
+    free(pakrepr);
+    return ppathrepr;
+}
+
+static char* vfs_pakpath_syspath(VFSNode *node) {
+    VFSPakPathData *pdata = node->data1;
+    char *pakpath = vfs_repr_node(pdata->paknode, true);
+    char *subpath = strfmt("%s%c%s", pakpath, vfs_syspath_preferred_separator, vfs_pakpath_name(node));
+    free(pakpath);
+    return subpath;
+}
+
+static VFSInfo vfs_pakpath_query(VFSNode *node) {
+    const PakEntry *e = vfs_pakpath_entry(node);
+
+    return (VFSInfo) {
+        .exists = true,
+        .is_dir = (e->flags & PAK_ENTRY_DIR) != 0,
+        .size = e->size,
+        // packages don't keep timestamps; the checksum serves the same purpose for change detection
+        .mtime = e->checksum,
+    };
+}
+
+static VFSNode* vfs_pakpath_locate(VFSNode *node, const char *path) {
+    VFSPakPathData *pdata = node->data1;
+
+    const char *mypath = vfs_pakpath_name(node);
+    char fullpath[strlen(mypath) + strlen(path) + 2];
+    snprintf(fullpath, sizeof(fullpath), "%s%c%s", mypath, VFS_PATH_SEP, path);
+    vfs_path_normalize_inplace(fullpath);
+
+    return vfs_locate(pdata->paknode, fullpath);
+}
+
+static const char* vfs_pakpath_iter(VFSNode *node, void **opaque) {
+    VFSPakPathData *pdata = node->data1;
+
+    if(!(vfs_pakpath_entry(node)->flags & PAK_ENTRY_DIR)) {
+        return NULL;
+    }
+
+    return vfs_pakfile_iter_shared(pdata->paknode->data1, pdata->index, opaque);
+}
+
+#define vfs_pakpath_iter_stop vfs_pakfile_iter_stop
+
+static void vfs_pakpath_unmap(VFSMapping *mapping) {
+    vfs_decref(((VFSPakMapping*)mapping)->paknode);
+    free(mapping);
+}
+
+static VFSMapping* vfs_pakpath_map_range(VFSNode *paknode, uint64_t offset, uint64_t size) {
+    // the mapping may outlive this node, so keep the package alive until it is unmapped
+    VFSPakMapping *m = malloc(sizeof(VFSPakMapping));
+    m->mapping.data = (const char*)((VFSPakFileData*)paknode->data1)->mapping->data + offset;
+    m->mapping.size = size;
+    m->mapping.unmap = vfs_pakpath_unmap;
+    m->paknode = paknode;
+    vfs_incref(paknode);
+    return &m->mapping;
+}
+
+static VFSMapping* vfs_pakpath_map(VFSNode *node) {
+    VFSPakPathData *pdata = node->data1;
+    const PakEntry *e = vfs_pakpath_entry(node);
+
+    if(e->flags & PAK_ENTRY_DIR) {
+        vfs_set_error("Can't map a directory");
+        return NULL;
+    }
+
+    if(e->flags & PAK_ENTRY_DEFLATE) {
+        vfs_set_error("File is compressed in the package");
+        return NULL;
+    }
+
+    if(!vfs_pakpath_pak(node)->mapping) {
+        vfs_set_error("Package is not mapped");
+        return NULL;
+    }
+
+    if(!e->size) {
+        vfs_set_error("Can't map an empty file");
+        return NULL;
+    }
+
+    return vfs_pakpath_map_range(pdata->paknode, e->offset, e->stored_size);
+}
+
+static int64_t vfs_pakpath_empty_seek(SDL_RWops *rw, int64_t offset, int whence) {
+    return 0;
+}
+
+static int64_t vfs_pakpath_empty_size(SDL_RWops *rw) {
+    return 0;
+}
+
+static size_t vfs_pakpath_empty_read(SDL_RWops *rw, void *ptr, size_t size, size_t maxnum) {
+    return 0;
+}
+
+static size_t vfs_pakpath_empty_write(SDL_RWops *rw, const void *ptr, size_t size, size_t maxnum) {
+    SDL_SetError("Attempted to write to a package entry");
+    return 0;
+}
+
+static int vfs_pakpath_empty_close(SDL_RWops *rw) {
+    SDL_FreeRW(rw);
+    return 0;
+}
+
+static SDL_RWops* vfs_pakpath_open_empty(void) {
+    // SDL_RWFromConstMem() refuses zero-sized buffers, and segments can't be empty either
+    SDL_RWops *rw = SDL_AllocRW();
+
+    if(!rw) {
+        vfs_set_error_from_sdl();
+        return NULL;
+    }
+
+    memset(rw, 0, sizeof(SDL_RWops));
+    rw->type = SDL_RWOPS_UNKNOWN;
+    rw->seek = vfs_pakpath_empty_seek;
+    rw->size = vfs_pakpath_empty_size;
+    rw->read = vfs_pakpath_empty_read;
+    rw->write = vfs_pakpath_empty_write;
+    rw->close = vfs_pakpath_empty_close;
+    return rw;
+}
+
+static SDL_RWops* vfs_pakpath_open_stored(VFSNode *node) {
+    VFSPakPathData *pdata = node->data1;
+    VFSPakFileData *pak = vfs_pakpath_pak(node);
+    const PakEntry *e = vfs_pakpath_entry(node);
+
+    if(pak->mapping) {
+        return vfs_mapping_stream(vfs_pakpath_map_range(pdata->paknode, e->offset, e->stored_size));
+    }
+
+    VFSNode *source = pak->source;
+    SDL_RWops *srcrw = source->funcs->open ? source->funcs->open(source, VFS_MODE_READ) : NULL;
+
+    if(!srcrw) {
+        vfs_set_error("Failed to open the package source: %s", vfs_get_error());
+        return NULL;
+    }
+
+    if(SDL_RWseek(srcrw, e->offset, RW_SEEK_SET) < 0) {
+        vfs_set_error_from_sdl();
+        SDL_RWclose(srcrw);
+        return NULL;
+    }
+
+    return SDL_RWWrapSegment(srcrw, e->offset, e->offset + e->stored_size, true);
+}
+
+static SDL_RWops* vfs_pakpath_open(VFSNode *node, VFSOpenMode mode) {
+    if(mode & VFS_MODE_WRITE) {
+        vfs_set_error("Packages are read-only");
+        return NULL;
+    }
+
+    const PakEntry *e = vfs_pakpath_entry(node);
+
+    if(e->flags & PAK_ENTRY_DIR) {
+        vfs_set_error("Can't open a directory");
+        return NULL;
+    }
+
+    if(!e->size) {
+        return vfs_pakpath_open_empty();
+    }
+
+    SDL_RWops *rw = vfs_pakpath_open_stored(node);
+
+    if(!rw || !(e->flags & PAK_ENTRY_DEFLATE)) {
+        return rw;
+    }
+
+    rw = SDL_RWWrapZReader(rw, e->stored_size < PAK_ZBUF_SIZE ? e->stored_size : PAK_ZBUF_SIZE, true);
+
+    if(!rw || !(mode & VFS_MODE_SEEKABLE)) {
+        return rw;
+    }
+
+    SDL_RWops *bufrw = SDL_RWCopyToBuffer(rw);
+    SDL_RWclose(rw);
+    return bufrw;
+}
+
+static VFSNodeFuncs vfs_funcs_pakpath = {
+    .repr = vfs_pakpath_repr,
+    .query = vfs_pakpath_query,
+    .free = vfs_pakpath_free,
+    .syspath = vfs_pakpath_syspath,
+    .locate = vfs_pakpath_locate,
+    .iter = vfs_pakpath_iter,
+    .iter_stop = vfs_pakpath_iter_stop,
+    .open = vfs_pakpath_open,
+    .map = vfs_pakpath_map,
+};
+
+void vfs_pakpath_init(VFSNode *node, VFSNode *paknode, uint32_t index) {
+    VFSPakPathData *pdata = calloc(1, sizeof(VFSPakPathData));
+    pdata->paknode = paknode;
+    pdata->index = index;
+    vfs_incref(paknode);
+
+    node->data1 = pdata;
+    node->funcs = &vfs_funcs_pakpath;
+}
@@ -24,6 +24,7 @@ typedef struct vfs_shutdownhook_t {
 static SDL_TLSID vfs_tls_id;
 static vfs_tls_t *vfs_tls_fallback;
 static vfs_shutdownhook_t *shutdown_hooks;
+static SDL_atomic_t mount_generation;
 
 static void vfs_free(VFSNode *node);
 
@@ -90,6 +91,14 @@ void vfs_hook_on_shutdown(VFSShutdownHandler func, void *arg) {
     hook->arg = arg;
 }
 
+int vfs_get_mount_generation(void) {
+    return SDL_AtomicGet(&mount_generation);
+}
+
+void vfs_bump_mount_generation(void) {
+    SDL_AtomicAdd(&mount_generation, 1);
+}
+
 VFSNode* vfs_alloc(void) {
     VFSNode *node = calloc(1, sizeof(VFSNode));
     vfs_incref(node);
@@ -174,6 +183,7 @@ bool vfs_mount(VFSNode *root, const char *mountpoint, VFSNode *subtree) {
         if(mpnode->funcs->mount) {
             // expected to set error on failure
             result = mpnode->funcs->mount(mpnode, NULL, subtree);
+            vfs_bump_mount_generation();
         } else {
             result = false;
             vfs_set_error("Mountpoint '%s' already exists and does not support merging", mountpoint);
@@ -189,6 +199,7 @@ bool vfs_mount(VFSNode *root, const char *mountpoint, VFSNode *subtree) {
         if(mpnode->funcs->mount) {
             // expected to set error on failure
             result = mpnode->funcs->mount(mpnode, mpname, subtree);
+            vfs_bump_mount_generation();
         } else {
             result = false;
             vfs_set_error("Parent directory '%s' of mountpoint '%s' does not support mounting", mpbase, mountpoint);
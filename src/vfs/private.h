@@ -34,6 +34,13 @@ typedef const char* (*VFSIterFunc)(VFSNode *dirnode, void **opaque);
 typedef void (*VFSIterStopFunc)(VFSNode *dirnode, void **opaque);
 typedef bool (*VFSMkDirFunc)(VFSNode *parent, const char *subdir);
 typedef SDL_RWops* (*VFSOpenFunc)(VFSNode *filenode, VFSOpenMode mode);
+typedef VFSMapping* (*VFSMapFunc)(VFSNode *filenode);
+
+struct VFSMapping {
+    const void *data;
+    size_t size;
+    void (*unmap)(VFSMapping *mapping);
+};
 
 typedef struct VFSNodeFuncs {
     VFSReprFunc repr;
@@ -47,6 +54,7 @@ typedef struct VFSNodeFuncs {
     VFSIterStopFunc iter_stop;
     VFSMkDirFunc mkdir;
     VFSOpenFunc open;
+    VFSMapFunc map;
 } VFSNodeFuncs;
 
 typedef struct VFSNode {
@@ -71,9 +79,17 @@ bool vfs_mount_or_decref(VFSNode *root, const char *mountpoint, VFSNode *subtree
 const char* vfs_iter(VFSNode *node, void **opaque);
 void vfs_iter_stop(VFSNode *node, void **opaque);
 
+// Wraps a mapping into a read-only stream, which takes ownership of it and unmaps it on close.
+// Accepts NULL for convenience.
+SDL_RWops* vfs_mapping_stream(VFSMapping *mapping);
+
 void vfs_set_error(char *fmt, ...) __attribute__((format(FORMAT_ATTR, 1, 2)));
 void vfs_set_error_from_sdl(void);
 
 void vfs_hook_on_shutdown(VFSShutdownHandler, void *arg);
 
+// Changes whenever the tree may have changed shape (mount, unmount, mkdir). Used to invalidate lookup caches.
+int vfs_get_mount_generation(void);
+void vfs_bump_mount_generation(void);
+
 void vfs_print_tree_recurse(SDL_RWops *dest, VFSNode *root, char *prefix, const char *name);
@@ -41,6 +41,7 @@ bool vfs_unmount(const char *path) {
 
         if(node->funcs->unmount) {
             result = node->funcs->unmount(node, subdir);
+            vfs_bump_mount_generation();
         } else {
             result = false;
             vfs_set_error("Node '%s' doesn't support unmounting", parent);
@@ -54,6 +55,109 @@ bool vfs_unmount(const char *path) {
     return false;
 }
 
+typedef struct VFSMappedStream {
+    SDL_RWops *mem;
+    VFSMapping *mapping;
+} VFSMappedStream;
+
+#define MAPPED_STREAM(rw) ((VFSMappedStream*)((rw)->hidden.unknown.data1))
+
+static int64_t vfs_mapped_stream_seek(SDL_RWops *rw, int64_t offset, int whence) {
+    return SDL_RWseek(MAPPED_STREAM(rw)->mem, offset, whence);
+}
+
+static int64_t vfs_mapped_stream_size(SDL_RWops *rw) {
+    return SDL_RWsize(MAPPED_STREAM(rw)->mem);
+}
+
+static size_t vfs_mapped_stream_read(SDL_RWops *rw, void *ptr, size_t size, size_t maxnum) {
+    return SDL_RWread(MAPPED_STREAM(rw)->mem, ptr, size, maxnum);
+}
+
+static size_t vfs_mapped_stream_write(SDL_RWops *rw, const void *ptr, size_t size, size_t maxnum) {
+    SDL_SetError("Attempted to write to a read-only mapped file");
+    return 0;
+}
+
+static int vfs_mapped_stream_close(SDL_RWops *rw) {
+    if(rw) {
+        VFSMappedStream *s = MAPPED_STREAM(rw);
+        SDL_RWclose(s->mem);
+        vfs_unmap(s->mapping);
+        free(s);
+        SDL_FreeRW(rw);
+    }
+
+    return 0;
+}
+
+SDL_RWops* vfs_mapping_stream(VFSMapping *mapping) {
+    if(!mapping) {
+        return NULL;
+    }
+
+    SDL_RWops *mem = SDL_RWFromConstMem(mapping->data, mapping->size);
+    SDL_RWops *rw = mem ? SDL_AllocRW() : NULL;
+
+    if(!rw) {
+        if(mem) {
+            SDL_RWclose(mem);
+        }
+
+        vfs_unmap(mapping);
+        return NULL;
+    }
+
+    memset(rw, 0, sizeof(SDL_RWops));
+
+    rw->type = SDL_RWOPS_UNKNOWN;
+    rw->seek = vfs_mapped_stream_seek;
+    rw->size = vfs_mapped_stream_size;
+    rw->read = vfs_mapped_stream_read;
+    rw->write = vfs_mapped_stream_write;
+    rw->close = vfs_mapped_stream_close;
+
+    VFSMappedStream *s = malloc(sizeof(VFSMappedStream));
+    s->mem = mem;
+    s->mapping = mapping;
+    rw->hidden.unknown.data1 = s;
+
+    return rw;
+}
+
+VFSMapping* vfs_map(const char *path, const void **data, size_t *size) {
+    char p[strlen(path)+1];
+    path = vfs_path_normalize(path, p);
+    VFSNode *node = vfs_locate(vfs_root, path);
+    VFSMapping *mapping = NULL;
+
+    if(node) {
+        if(node->funcs->map) {
+            // expected to set error on failure
+            mapping = node->funcs->map(node);
+        } else {
+            vfs_set_error("Node '%s' can't be mapped", path);
+        }
+
+        vfs_decref(node);
+    } else {
+        vfs_set_error("Node '%s' does not exist", path);
+    }
+
+    if(mapping) {
+        *data = mapping->data;
+        *size = mapping->size;
+    }
+
+    return mapping;
+}
+
+void vfs_unmap(VFSMapping *mapping) {
+    if(mapping) {
+        mapping->unmap(mapping);
+    }
+}
+
 SDL_RWops* vfs_open(const char *path, VFSOpenMode mode) {
     SDL_RWops *rwops = NULL;
     char p[strlen(path)+1];
@@ -63,11 +167,26 @@ SDL_RWops* vfs_open(const char *path, VFSOpenMode mode) {
     if(node) {
         assert(node->funcs != NULL);
 
-        if(node->funcs->open) {
-            // expected to set error on failure
-            rwops = node->funcs->open(node, mode);
-        } else {
-            vfs_set_error("Node '%s' can't be opened as a file", path);
+        // a new file may be visible through other paths (e.g. storage/resources through res),
+        // which the union caches could still remember as missing
+        bool creating = (mode & VFS_MODE_WRITE) && !vfs_query_node(node).exists;
+
+        if((mode & VFS_MODE_MAP) && (mode & VFS_MODE_RWMASK) == VFS_MODE_READ && node->funcs->map) {
+            // silently falls back to a regular stream if this fails
+            rwops = vfs_mapping_stream(node->funcs->map(node));
+        }
+
+        if(!rwops) {
+            if(node->funcs->open) {
+                // expected to set error on failure
+                rwops = node->funcs->open(node, mode);
+            } else {
+                vfs_set_error("Node '%s' can't be opened as a file", path);
+            }
+        }
+
+        if(rwops && creating) {
+            vfs_bump_mount_generation();
         }
 
         vfs_decref(node);
@@ -105,7 +224,14 @@ bool vfs_mkdir(const char *path) {
     bool ok = false;
 
     if(node && node->funcs->mkdir) {
+        // the caches only care about new directories; this gets called a lot on existing ones
+        bool existed = vfs_query_node(node).is_dir;
         ok = node->funcs->mkdir(node, NULL);
+
+        if(ok && !existed) {
+            vfs_bump_mount_generation();
+        }
+
         vfs_decref(node);
         return ok;
     }
@@ -119,7 +245,12 @@ bool vfs_mkdir(const char *path) {
     if(node) {
         if(node->funcs->mkdir) {
             ok = node->funcs->mkdir(node, subdir);
-            node->funcs->mkdir(node, subdir);
+
+            if(ok) {
+                vfs_bump_mount_generation();
+            }
+
+            vfs_decref(node);
             return ok;
         } else {
             vfs_set_error("Node '%s' does not support creation of subdirectories", parent);
@@ -153,6 +284,29 @@ char* vfs_repr(const char *path, bool try_syspath) {
     return NULL;
 }
 
+char* vfs_syspath(const char *path) {
+    char buf[strlen(path)+1];
+    path = vfs_path_normalize(path, buf);
+    VFSNode *node = vfs_locate(vfs_root, path);
+    char *p = NULL;
+
+    if(!node) {
+        vfs_set_error("Node '%s' does not exist", path);
+        return NULL;
+    }
+
+    if(node->funcs->syspath) {
+        p = node->funcs->syspath(node);
+    } else {
+        char *r = vfs_repr_node(node, false);
+        vfs_set_error("%s has no system path", r);
+        free(r);
+    }
+
+    vfs_decref(node);
+    return p;
+}
+
 bool vfs_print_tree(SDL_RWops *dest, const char *path) {
     char p[strlen(path)+3], *trail;
     vfs_path_normalize(path, p);
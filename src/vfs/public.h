@@ -14,11 +14,16 @@
 #include "syspath_public.h"
 #include "union_public.h"
 #include "zipfile_public.h"
+#include "pakfile_public.h"
 
 typedef struct VFSInfo {
     unsigned int error: 1;
     unsigned int exists : 1;
     unsigned int is_dir : 1;
+    // only meaningful for files, zero if unknown
+    // mtime is in platform-specific units and should only be compared for equality
+    uint64_t size;
+    int64_t mtime;
 } VFSInfo;
 
 #define VFSINFO_ERROR ((VFSInfo){.error = true, 0})
@@ -27,13 +32,21 @@ typedef enum VFSOpenMode {
     VFS_MODE_READ = 1,
     VFS_MODE_WRITE = 2,
     VFS_MODE_SEEKABLE  = 4,
+    VFS_MODE_MAP = 8, // read-only: serve reads from a memory mapping, if the file can be mapped
 } VFSOpenMode;
 
 #define VFS_MODE_RWMASK (VFS_MODE_READ | VFS_MODE_WRITE)
 
 typedef struct VFSDir VFSDir;
 
+typedef struct VFSMapping VFSMapping;
+
 SDL_RWops* vfs_open(const char *path, VFSOpenMode mode);
+
+// Maps a file into memory, read-only. Returns NULL if the file can't be mapped (e.g. it's stored compressed in a package);
+// use vfs_open() in that case. The data stays valid until vfs_unmap().
+VFSMapping* vfs_map(const char *path, const void **data, size_t *size);
+void vfs_unmap(VFSMapping *mapping);
 VFSInfo vfs_query(const char *path);
 
 bool vfs_mkdir(const char *path);
@@ -52,6 +65,7 @@ int vfs_dir_list_order_ascending(const char **a, const char **b);
 int vfs_dir_list_order_descending(const char **a, const char **b);
 
 char* vfs_repr(const char *path, bool try_syspath);
+char* vfs_syspath(const char *path);
 bool vfs_print_tree(SDL_RWops *dest, const char *path);
 
 // these are defined in private.c, but need to be accessible from external code
@@ -43,6 +43,7 @@ static struct pkg_loader_t {
     bool (*mount)(const char *mp, const char *arg);
 } pkg_loaders[] = {
     { ".zip",       vfs_mount_zipfile },
+    { ".tpk",       vfs_mount_pakfile },
     { NULL },
 };
 
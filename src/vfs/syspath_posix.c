@@ -9,8 +9,10 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 
 #include "syspath.h"
 
@@ -31,6 +33,8 @@ static VFSInfo vfs_syspath_query(VFSNode *node) {
     if(stat(node->_path_, &fstat) >= 0) {
         i.exists = true;
         i.is_dir = S_ISDIR(fstat.st_mode);
+        i.size = fstat.st_size;
+        i.mtime = fstat.st_mtime;
     }
 
     return i;
@@ -47,6 +51,42 @@ static SDL_RWops* vfs_syspath_open(VFSNode *node, VFSOpenMode mode) {
     return rwops;
 }
 
+static void vfs_syspath_unmap(VFSMapping *mapping) {
+    munmap((void*)mapping->data, mapping->size);
+    free(mapping);
+}
+
+static VFSMapping* vfs_syspath_map(VFSNode *node) {
+    int fd = open(node->_path_, O_RDONLY);
+
+    if(fd < 0) {
+        vfs_set_error("Can't open %s (errno: %i)", (char*)node->_path_, errno);
+        return NULL;
+    }
+
+    struct stat fstat_buf;
+    VFSMapping *mapping = NULL;
+
+    if(fstat(fd, &fstat_buf) < 0 || !S_ISREG(fstat_buf.st_mode) || fstat_buf.st_size <= 0) {
+        // mmap can't do empty files, and anything that's not a regular file is better off being streamed
+        vfs_set_error("%s can't be mapped", (char*)node->_path_);
+    } else {
+        void *data = mmap(NULL, fstat_buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if(data == MAP_FAILED) {
+            vfs_set_error("mmap() failed for %s (errno: %i)", (char*)node->_path_, errno);
+        } else {
+            mapping = malloc(sizeof(VFSMapping));
+            mapping->data = data;
+            mapping->size = fstat_buf.st_size;
+            mapping->unmap = vfs_syspath_unmap;
+        }
+    }
+
+    close(fd);
+    return mapping;
+}
+
 static VFSNode* vfs_syspath_locate(VFSNode *node, const char *path) {
     VFSNode *n = vfs_alloc();
     vfs_syspath_init_internal(n, strfmt("%s%c%s", (char*)node->_path_, VFS_PATH_SEP, path));
@@ -133,6 +173,7 @@ static VFSNodeFuncs vfs_funcs_syspath = {
     .iter_stop = vfs_syspath_iter_stop,
     .mkdir = vfs_syspath_mkdir,
     .open = vfs_syspath_open,
+    .map = vfs_syspath_map,
 };
 
 void vfs_syspath_normalize(char *buf, size_t bufsize, const char *path) {
@@ -69,15 +69,17 @@ static VFSInfo vfs_syspath_query(VFSNode *node) {
         return i;
     }
 
-    DWORD attrib = GetFileAttributes(node->_wpath_);
+    WIN32_FILE_ATTRIBUTE_DATA attrs;
 
-    if(attrib == INVALID_FILE_ATTRIBUTES) {
+    if(!GetFileAttributesEx(node->_wpath_, GetFileExInfoStandard, &attrs)) {
         vfs_set_error_win32();
         return VFSINFO_ERROR;
     }
 
     i.exists = true;
-    i.is_dir = (bool)(attrib & FILE_ATTRIBUTE_DIRECTORY);
+    i.is_dir = (bool)(attrs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY);
+    i.size = ((uint64_t)attrs.nFileSizeHigh << 32) | attrs.nFileSizeLow;
+    i.mtime = ((int64_t)attrs.ftLastWriteTime.dwHighDateTime << 32) | attrs.ftLastWriteTime.dwLowDateTime;
 
     return i;
 }
@@ -8,8 +8,30 @@
 
 #include "union.h"
 
-#define _members_ data1
-#define _primary_member_ data2
+// Only mounted unions get a cache: the temporary ones built by vfs_union_locate_uncached() are thrown
+// away right after the lookup, so they'd pay for a mutex and never hit it.
+typedef struct VFSUnionCache {
+    // path -> located node (or vfs_union_negative_entry for misses), holds a reference to each node
+    // dropped entirely whenever the mount generation changes, or when it grows past the limit
+    Hashtable *entries;
+    size_t num_entries;
+    int generation;
+    SDL_mutex *mutex;
+} VFSUnionCache;
+
+typedef struct VFSUnionData {
+    ListContainer *members;
+    VFSNode *primary_member;
+    VFSUnionCache *cache;
+} VFSUnionData;
+
+#define _udata_(node) ((VFSUnionData*)(node)->data1)
+
+// Lookups are by resource path, so a full cache is a few thousand entries in practice; the limit is
+// just a safety net against unbounded growth from paths that are only ever looked up once.
+#define VFS_UNION_CACHE_MAX_ENTRIES 8192
+
+static char vfs_union_negative_entry;
 
 static bool vfs_union_mount_internal(VFSNode *unode, const char *mountpoint, VFSNode *mountee, VFSInfo info, bool seterror);
 
@@ -21,16 +43,118 @@ static void* vfs_union_delete_callback(List **list, List *elem, void *arg) {
     return NULL;
 }
 
+static void vfs_union_cache_clear(VFSUnionCache *cache) {
+    if(!cache->entries) {
+        return;
+    }
+
+    HashtableIterator i;
+    VFSNode *n;
+
+    for(hashtable_iter_init(cache->entries, &i); hashtable_iter_next(&i, NULL, (void**)&n);) {
+        if(n != (void*)&vfs_union_negative_entry) {
+            vfs_decref(n);
+        }
+    }
+
+    hashtable_free(cache->entries);
+    cache->entries = NULL;
+    cache->num_entries = 0;
+}
+
 static void vfs_union_free(VFSNode *node) {
-    list_foreach(&node->_members_, vfs_union_delete_callback, NULL);
+    VFSUnionData *udata = _udata_(node);
+    list_foreach(&udata->members, vfs_union_delete_callback, NULL);
+
+    if(udata->cache) {
+        vfs_union_cache_clear(udata->cache);
+        SDL_DestroyMutex(udata->cache->mutex);
+        free(udata->cache);
+    }
+
+    free(udata);
 }
 
+static VFSNode* vfs_union_locate_uncached(VFSNode *node, const char *path);
+
 static VFSNode* vfs_union_locate(VFSNode *node, const char *path) {
+    VFSUnionCache *cache = _udata_(node)->cache;
+    VFSNode *n;
+
+    if(!cache) {
+        return vfs_union_locate_uncached(node, path);
+    }
+
+    int generation = vfs_get_mount_generation();
+
+    SDL_LockMutex(cache->mutex);
+
+    if(cache->generation != generation) {
+        vfs_union_cache_clear(cache);
+        cache->generation = generation;
+    }
+
+    if(cache->entries && (n = hashtable_get_string(cache->entries, path))) {
+        if(n == (void*)&vfs_union_negative_entry) {
+            n = NULL;
+        } else {
+            vfs_incref(n);
+        }
+
+        SDL_UnlockMutex(cache->mutex);
+        return n;
+    }
+
+    SDL_UnlockMutex(cache->mutex);
+
+    // done unlocked, the members may be unions themselves
+    n = vfs_union_locate_uncached(node, path);
+
+    SDL_LockMutex(cache->mutex);
+
+    if(cache->generation == generation) {
+        if(cache->num_entries >= VFS_UNION_CACHE_MAX_ENTRIES) {
+            vfs_union_cache_clear(cache);
+        }
+
+        if(!cache->entries) {
+            cache->entries = hashtable_new_stringkeys(HT_DYNAMIC_SIZE);
+        }
+
+        VFSNode *cached = hashtable_get_string(cache->entries, path);
+
+        if(cached) {
+            // someone else got here first, keep theirs
+            if(cached != (void*)&vfs_union_negative_entry) {
+                vfs_incref(cached);
+                vfs_decref(n);
+                n = cached;
+            } else {
+                vfs_decref(n);
+                n = NULL;
+            }
+        } else {
+            if(n) {
+                vfs_incref(n);
+                hashtable_set_string(cache->entries, path, n);
+            } else {
+                hashtable_set_string(cache->entries, path, &vfs_union_negative_entry);
+            }
+
+            ++cache->num_entries;
+        }
+    }
+
+    SDL_UnlockMutex(cache->mutex);
+    return n;
+}
+
+static VFSNode* vfs_union_locate_uncached(VFSNode *node, const char *path) {
     VFSNode *u = vfs_alloc();
     vfs_union_init(u); // uniception!
 
     VFSInfo prim_info = VFSINFO_ERROR;
-    ListContainer *first = node->_members_;
+    ListContainer *first = _udata_(node)->members;
     ListContainer *last = first;
     ListContainer *c;
 
@@ -53,11 +177,11 @@ static VFSNode* vfs_union_locate(VFSNode *node, const char *path) {
         }
     }
 
-    if(u->_primary_member_) {
-        if(!((List*)(u->_members_))->next || !prim_info.is_dir) {
+    if(_udata_(u)->primary_member) {
+        if(!((List*)(_udata_(u)->members))->next || !prim_info.is_dir) {
             // the temporary union contains just one member, or doesn't represent a directory
             // in those cases it's just a useless wrapper, so let's just return the primary member directly
-            VFSNode *n = u->_primary_member_;
+            VFSNode *n = _udata_(u)->primary_member;
 
             // incref primary member to keep it alive
             vfs_incref(n);
@@ -89,7 +213,7 @@ static const char* vfs_union_iter(VFSNode *node, void **opaque) {
 
     if(!i) {
         i = malloc(sizeof(VFSUnionIterData));
-        i->current = node->_members_;
+        i->current = _udata_(node)->members;
         i->opaque = NULL;
 
          // XXX: this may not be the most efficient implementation of a "set" structure...
@@ -132,8 +256,8 @@ static void vfs_union_iter_stop(VFSNode *node, void **opaque) {
 }
 
 static VFSInfo vfs_union_query(VFSNode *node) {
-    if(node->_primary_member_) {
-        return vfs_query_node(node->_primary_member_);
+    if(_udata_(node)->primary_member) {
+        return vfs_query_node(_udata_(node)->primary_member);
     }
 
     vfs_set_error("Union object has no members");
@@ -158,8 +282,8 @@ static bool vfs_union_mount_internal(VFSNode *unode, const char *mountpoint, VFS
         return false;
     }
 
-    list_push(&unode->_members_, list_wrap_container(mountee));
-    unode->_primary_member_ = mountee;
+    list_push(&_udata_(unode)->members, list_wrap_container(mountee));
+    _udata_(unode)->primary_member = mountee;
 
     return true;
 }
@@ -174,7 +298,7 @@ static bool vfs_union_mount(VFSNode *unode, const char *mountpoint, VFSNode *mou
 }
 
 static SDL_RWops* vfs_union_open(VFSNode *unode, VFSOpenMode mode) {
-    VFSNode *n = unode->_primary_member_;
+    VFSNode *n = _udata_(unode)->primary_member;
 
     if(n) {
         if(n->funcs->open) {
@@ -189,10 +313,21 @@ static SDL_RWops* vfs_union_open(VFSNode *unode, VFSOpenMode mode) {
     return NULL;
 }
 
+static VFSMapping* vfs_union_map(VFSNode *unode) {
+    VFSNode *n = _udata_(unode)->primary_member;
+
+    if(n && n->funcs->map) {
+        return n->funcs->map(n);
+    }
+
+    vfs_set_error("Primary union member can't be mapped");
+    return NULL;
+}
+
 static char* vfs_union_repr(VFSNode *node) {
     char *mlist = strdup("union: "), *r;
 
-    for(ListContainer *c = node->_members_; c; c = c->next) {
+    for(ListContainer *c = _udata_(node)->members; c; c = c->next) {
         VFSNode *n = c->data;
 
         strappend(&mlist, r = vfs_repr_node(n, false));
@@ -207,7 +342,7 @@ static char* vfs_union_repr(VFSNode *node) {
 }
 
 static char* vfs_union_syspath(VFSNode *node) {
-    VFSNode *n = node->_primary_member_;
+    VFSNode *n = _udata_(node)->primary_member;
 
     if(n) {
         if(n->funcs->syspath) {
@@ -222,11 +357,11 @@ static char* vfs_union_syspath(VFSNode *node) {
 }
 
 static bool vfs_union_mkdir(VFSNode *node, const char *subdir) {
-    VFSNode *n = node->_primary_member_;
+    VFSNode *n = _udata_(node)->primary_member;
 
     if(n) {
         if(n->funcs->mkdir) {
-            return n->funcs->mkdir(node, subdir);
+            return n->funcs->mkdir(n, subdir);
         } else {
             vfs_set_error("Primary union member doesn't support directory creation");
         }
@@ -247,9 +382,28 @@ static VFSNodeFuncs vfs_funcs_union = {
     .iter_stop = vfs_union_iter_stop,
     .mkdir = vfs_union_mkdir,
     .open = vfs_union_open,
+    .map = vfs_union_map,
 };
 
 void vfs_union_init(VFSNode *node) {
     node->funcs = &vfs_funcs_union;
-    node->data1 = node->data2 = NULL;
+    node->data1 = calloc(1, sizeof(VFSUnionData));
+    node->data2 = NULL;
+}
+
+void vfs_union_enable_cache(VFSNode *node) {
+    VFSUnionData *udata = _udata_(node);
+    SDL_mutex *mutex;
+
+    assert(node->funcs == &vfs_funcs_union);
+    assert(udata->cache == NULL);
+
+    if(!(mutex = SDL_CreateMutex())) {
+        log_warn("SDL_CreateMutex() failed, union lookups won't be cached: %s", SDL_GetError());
+        return;
+    }
+
+    udata->cache = calloc(1, sizeof(VFSUnionCache));
+    udata->cache->mutex = mutex;
+    udata->cache->generation = vfs_get_mount_generation();
 }
@@ -12,3 +12,7 @@
 #include "union_public.h"
 
 void vfs_union_init(VFSNode *node);
+
+// Makes the union remember what its paths resolve to until the next mount change or file creation.
+// Meant for long-lived (mounted) unions; must be called before the node is shared.
+void vfs_union_enable_cache(VFSNode *node);
@@ -11,5 +11,6 @@
 bool vfs_create_union_mountpoint(const char *mountpoint) {
     VFSNode *unode = vfs_alloc();
     vfs_union_init(unode);
+    vfs_union_enable_cache(unode);
     return vfs_mount_or_decref(vfs_root, mountpoint, unode);
 }
@@ -65,10 +65,10 @@ static VFSInfo vfs_vdir_query(VFSNode *vdir) {
 
 static void vfs_vdir_free(VFSNode *vdir) {
     Hashtable *ht = vdir->_contents_;
-    HashtableIterator *i;
+    HashtableIterator i;
     VFSNode *child;
 
-    for(i = hashtable_iter(ht); hashtable_iter_next(i, NULL, (void**)&child);) {
+    for(hashtable_iter_init(ht, &i); hashtable_iter_next(&i, NULL, (void**)&child);) {
         vfs_decref(child);
     }
 
@@ -9,21 +9,13 @@
 #include "zipfile.h"
 #include "zipfile_impl.h"
 
-static VFSZipFileTLS* vfs_zipfile_get_tls(VFSNode *node, bool create);
-
 #define LOG_SDL_ERROR log_debug("SDL error: %s", SDL_GetError())
 
 static zip_int64_t vfs_zipfile_srcfunc(void *userdata, void *data, zip_uint64_t len, zip_source_cmd_t cmd) {
-    VFSNode *zipnode = userdata;
-    VFSZipFileData *zdata = zipnode->data1;
-    VFSZipFileTLS *tls = vfs_zipfile_get_tls(zipnode, false);
-    VFSNode *source = zdata->source;
+    VFSZipFileTLS *tls = userdata;
+    VFSNode *source = tls->source;
     zip_int64_t ret = -1;
 
-    if(!tls) {
-        return -1;
-    }
-
     switch(cmd) {
         case ZIP_SOURCE_OPEN: {
             if(!source->funcs->open) {
@@ -111,6 +103,11 @@ static zip_int64_t vfs_zipfile_srcfunc(void *userdata, void *data, zip_uint64_t
         }
 
         case ZIP_SOURCE_FREE: {
+            if(tls->is_private) {
+                vfs_decref(tls->source);
+                free(tls);
+            }
+
             return 0;
         }
 
@@ -184,6 +181,11 @@ static char* vfs_zipfile_repr(VFSNode *node) {
 static VFSNode* vfs_zipfile_locate(VFSNode *node, const char *path) {
     VFSZipFileTLS *tls = vfs_zipfile_get_tls(node, true);
     VFSZipFileData *zdata = node->data1;
+
+    if(!tls) {
+        return NULL;
+    }
+
     zip_int64_t idx = (zip_int64_t)((intptr_t)hashtable_get_string(zdata->pathmap, path) - 1);
 
     if(idx < 0) {
@@ -195,7 +197,7 @@ static VFSNode* vfs_zipfile_locate(VFSNode *node, const char *path) {
     }
 
     VFSNode *n = vfs_alloc();
-    vfs_zippath_init(n, node, tls, idx);
+    vfs_zippath_init(n, node, tls->zip, idx);
     return n;
 }
 
@@ -258,6 +260,10 @@ static const char* vfs_zipfile_iter(VFSNode *node, void **opaque) {
     VFSZipFileIterData *idata = *opaque;
     VFSZipFileTLS *tls = vfs_zipfile_get_tls(node, true);
 
+    if(!tls) {
+        return NULL;
+    }
+
     if(!idata) {
         *opaque = idata = calloc(1, sizeof(VFSZipFileIterData));
         idata->num = zip_get_num_entries(tls->zip, 0);
@@ -314,7 +320,7 @@ static void vfs_zipfile_init_pathmap(VFSNode *node) {
     }
 }
 
-static VFSZipFileTLS* vfs_zipfile_get_tls(VFSNode *node, bool create) {
+VFSZipFileTLS* vfs_zipfile_get_tls(VFSNode *node, bool create) {
     VFSZipFileData *zdata = node->data1;
     VFSZipFileTLS *tls = SDL_TLSGet(zdata->tls_id);
 
@@ -323,9 +329,10 @@ static VFSZipFileTLS* vfs_zipfile_get_tls(VFSNode *node, bool create) {
     }
 
     tls = calloc(1, sizeof(VFSZipFileTLS));
+    tls->source = zdata->source;
     SDL_TLSSet(zdata->tls_id, tls, (void(*)(void*))vfs_zipfile_free_tls);
 
-    zip_source_t *src = zip_source_function_create(vfs_zipfile_srcfunc, node, &tls->error);
+    zip_source_t *src = zip_source_function_create(vfs_zipfile_srcfunc, tls, &tls->error);
     zip_t *zip = tls->zip = zip_open_from_source(src, ZIP_RDONLY, &tls->error);
 
     if(!zip) {
@@ -341,6 +348,35 @@ static VFSZipFileTLS* vfs_zipfile_get_tls(VFSNode *node, bool create) {
     return tls;
 }
 
+zip_t* vfs_zipfile_open_private(VFSNode *zipnode) {
+    VFSZipFileData *zdata = zipnode->data1;
+    VFSZipFileTLS *priv = calloc(1, sizeof(VFSZipFileTLS));
+    priv->source = zdata->source;
+    priv->is_private = true;
+    vfs_incref(priv->source);
+
+    zip_source_t *src = zip_source_function_create(vfs_zipfile_srcfunc, priv, &priv->error);
+
+    if(!src) {
+        vfs_set_error("Failed to create a zip source: %s", zip_error_strerror(&priv->error));
+        vfs_decref(priv->source);
+        free(priv);
+        return NULL;
+    }
+
+    zip_t *zip = zip_open_from_source(src, ZIP_RDONLY, &priv->error);
+
+    if(!zip) {
+        char *r = vfs_repr_node(zdata->source, true);
+        vfs_set_error("Failed to open zip archive '%s': %s", r, zip_error_strerror(&priv->error));
+        free(r);
+        zip_source_free(src); // frees priv as well
+        return NULL;
+    }
+
+    return zip;
+}
+
 bool vfs_zipfile_init(VFSNode *node, VFSNode *source) {
     VFSNode backup;
     memcpy(&backup, node, sizeof(VFSNode));
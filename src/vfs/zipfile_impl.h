@@ -16,6 +16,10 @@ typedef struct VFSZipFileTLS {
     zip_t *zip;
     SDL_RWops *stream;
     zip_error_t error;
+    VFSNode *source;
+
+    // not bound to a thread, but to a single zip_t; freed along with its zip_source
+    bool is_private;
 } VFSZipFileTLS;
 
 typedef struct VFSZipFileData {
@@ -32,16 +36,25 @@ typedef struct VFSZipFileIterData {
     char *allocated;
 } VFSZipFileIterData;
 
+// Returns the calling thread's instance of the archive, opening it on first use; NULL on failure.
+// zip_t handles must never be shared between threads.
+VFSZipFileTLS* vfs_zipfile_get_tls(VFSNode *node, bool create);
+
 const char* vfs_zipfile_iter_shared(VFSNode *node, VFSZipFileData *zdata, VFSZipFileIterData *idata, VFSZipFileTLS *tls);
 void vfs_zipfile_iter_stop(VFSNode *node, void **opaque);
 
+// Opens another instance of the archive, for streams that may outlive or leave the calling thread.
+// The caller owns the result and must zip_discard() it; the source node is kept alive until then.
+zip_t* vfs_zipfile_open_private(VFSNode *zipnode);
+
 /* zippath */
 
+// Path nodes may be cached and used from any thread, so they don't store a zip_t; every operation
+// goes through the calling thread's instance of the archive instead.
 typedef struct VFSZipPathData {
     VFSNode *zipnode;
-    VFSZipFileTLS *tls;
     uint64_t index;
     VFSInfo info;
 } VFSZipPathData;
 
-void vfs_zippath_init(VFSNode *node, VFSNode *zipnode, VFSZipFileTLS *tls, zip_int64_t idx);
+void vfs_zippath_init(VFSNode *node, VFSNode *zipnode, zip_t *zip, zip_int64_t idx);
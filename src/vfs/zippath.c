@@ -11,28 +11,43 @@
 #include "syspath.h"
 #include "rwops/all.h"
 
+static zip_t* vfs_zippath_zip(VFSZipPathData *zdata) {
+    VFSZipFileTLS *tls = vfs_zipfile_get_tls(zdata->zipnode, true);
+    return tls ? tls->zip : NULL;
+}
+
 static const char* vfs_zippath_name(VFSNode *node) {
     VFSZipPathData *zdata = node->data1;
-    return zip_get_name(zdata->tls->zip, zdata->index, 0);
+    zip_t *zip = vfs_zippath_zip(zdata);
+    return zip ? zip_get_name(zip, zdata->index, 0) : NULL;
 }
 
 static void vfs_zippath_free(VFSNode *node) {
-    free(node->data1);
+    VFSZipPathData *zdata = node->data1;
+    vfs_decref(zdata->zipnode);
+    free(zdata);
 }
 
 static char* vfs_zippath_repr(VFSNode *node) {
     VFSZipPathData *zdata = node->data1;
+    const char *name = vfs_zippath_name(node);
     char *ziprepr = vfs_repr_node(zdata->zipnode, false);
     char *zpathrepr = strfmt("%s '%s' in %s",
-        zdata->info.is_dir ? "directory" : "file", vfs_zippath_name(node), ziprepr);
+        zdata->info.is_dir ? "directory" : "file", name ? name : "?", ziprepr);
     free(ziprepr);
     return zpathrepr;
 }
 
 static char* vfs_zippath_syspath(VFSNode *node) {
     VFSZipPathData *zdata = node->data1;
+    const char *name = vfs_zippath_name(node);
+
+    if(!name) {
+        return NULL;
+    }
+
     char *zippath = vfs_repr_node(zdata->zipnode, true);
-    char *subpath = strfmt("%s%c%s", zippath, vfs_syspath_preferred_separator, vfs_zippath_name(node));
+    char *subpath = strfmt("%s%c%s", zippath, vfs_syspath_preferred_separator, name);
     free(zippath);
     return subpath;
 }
@@ -46,6 +61,11 @@ static VFSNode* vfs_zippath_locate(VFSNode *node, const char *path) {
     VFSZipPathData *zdata = node->data1;
 
     const char *mypath = vfs_zippath_name(node);
+
+    if(!mypath) {
+        return NULL;
+    }
+
     char fullpath[strlen(mypath) + strlen(path) + 2];
     snprintf(fullpath, sizeof(fullpath), "%s%c%s", mypath, VFS_PATH_SEP, path);
     vfs_path_normalize_inplace(fullpath);
@@ -61,16 +81,22 @@ static const char* vfs_zippath_iter(VFSNode *node, void **opaque) {
         return NULL;
     }
 
+    VFSZipFileTLS *tls = vfs_zipfile_get_tls(zdata->zipnode, true);
+
+    if(!tls) {
+        return NULL;
+    }
+
     if(!idata) {
         idata = calloc(1, sizeof(VFSZipFileIterData));
-        idata->num = zip_get_num_entries(zdata->tls->zip, 0);
+        idata->num = zip_get_num_entries(tls->zip, 0);
         idata->idx = zdata->index;
         idata->prefix = vfs_zippath_name(node);
         idata->prefix_len = strlen(idata->prefix);
         *opaque = idata;
     }
 
-    return vfs_zipfile_iter_shared(node, zdata->zipnode->data1, idata, zdata->tls);
+    return vfs_zipfile_iter_shared(node, zdata->zipnode->data1, idata, tls);
 }
 
 #define vfs_zippath_iter_stop vfs_zipfile_iter_stop
@@ -82,17 +108,40 @@ static SDL_RWops* vfs_zippath_open(VFSNode *node, VFSOpenMode mode) {
     }
 
     VFSZipPathData *zdata = node->data1;
-    zip_file_t *zipfile = zip_fopen_index(zdata->tls->zip, zdata->index, 0);
 
-    if(!zipfile) {
-        vfs_set_error("ZIP error: %s", zip_error_strerror(&zdata->tls->error));
+    if(!(mode & VFS_MODE_SEEKABLE)) {
+        zip_t *zip = vfs_zippath_zip(zdata);
+
+        if(!zip) {
+            return NULL;
+        }
+
+        SDL_RWops *ziprw = SDL_RWFromZipFile(zip, zdata->index, false);
+
+        if(!ziprw) {
+            vfs_set_error_from_sdl();
+        }
+
+        return ziprw;
+    }
+
+    // Seekable streams are typically long-lived, and may be consumed on another thread (e.g. music is
+    // decoded by the mixer), so they can't share this thread's zip_t; give them one of their own.
+    zip_t *zip = vfs_zipfile_open_private(zdata->zipnode);
+
+    if(!zip) {
         return NULL;
     }
 
-    SDL_RWops *ziprw = SDL_RWFromZipFile(zipfile, true);
-    assert(ziprw != NULL);
+    SDL_RWops *ziprw = SDL_RWFromZipFile(zip, zdata->index, true);
 
-    if(!(mode & VFS_MODE_SEEKABLE)) {
+    if(!ziprw) {
+        vfs_set_error_from_sdl();
+        zip_discard(zip);
+        return NULL;
+    }
+
+    if(SDL_RWZipFileSeeksCheaply(ziprw)) {
         return ziprw;
     }
 
@@ -114,22 +163,36 @@ static VFSNodeFuncs vfs_funcs_zippath = {
     .open = vfs_zippath_open,
 };
 
-void vfs_zippath_init(VFSNode *node, VFSNode *zipnode, VFSZipFileTLS *tls, zip_int64_t idx) {
+void vfs_zippath_init(VFSNode *node, VFSNode *zipnode, zip_t *zip, zip_int64_t idx) {
     VFSZipPathData *zdata = calloc(1, sizeof(VFSZipPathData));
     zdata->zipnode = zipnode;
-    zdata->tls = tls;
     zdata->index = idx;
     node->data1 = zdata;
 
+    // the node may outlive its lookup (e.g. in a union's cache), keep the archive alive
+    vfs_incref(zipnode);
+
     zdata->info.exists = true;
 
-    if('/' == *(strchr(vfs_zippath_name(node), 0) - 1)) {
+    if('/' == *(strchr(zip_get_name(zip, idx, 0), 0) - 1)) {
         zdata->info.is_dir = true;
+    } else {
+        zip_stat_t zstat;
+
+        if(!zip_stat_index(zip, idx, 0, &zstat)) {
+            if(zstat.valid & ZIP_STAT_SIZE) {
+                zdata->info.size = zstat.size;
+            }
+
+            if(zstat.valid & ZIP_STAT_MTIME) {
+                zdata->info.mtime = zstat.mtime;
+            }
+        }
     }
 
     node->funcs = &vfs_funcs_zippath;
 
-    const char *path = vfs_zippath_name(node);
+    const char *path = zip_get_name(zip, idx, 0);
     char buf[strlen(path)+1], *base, *name;
     strcpy(buf, path);
     vfs_path_split_right(buf, &base, &name);
@@ -11,6 +11,7 @@
 #include "global.h"
 #include "video.h"
 #include "taiseigl.h"
+#include "threadpool.h"
 
 Video video;
 static bool libgl_loaded = false;
@@ -358,78 +359,296 @@ void video_set_mode(int w, int h, bool fs, bool resizable) {
 	SDL_SetWindowResizable(video.window, resizable);
 }
 
-void video_take_screenshot(void) {
-	SDL_RWops *out;
-	char *data;
-	char outfile[128], *outpath, *syspath;
-	time_t rawtime;
-	struct tm * timeinfo;
-	int w, h, rw, rh;
+/*
+ *  Screenshots are read back into a pixel buffer object, with a fence placed right after the read.
+ *  The fence is polled once per frame without waiting; once it's signaled, the pixels are copied out
+ *  and handed off to a background thread, which encodes the PNG and writes it through the VFS.
+ *  Neither the GPU readback nor the encoding ever stalls the frame loop.
+ */
 
-	w = video.current.width;
-	h = video.current.height;
+#define SCREENSHOT_NUM_SLOTS 3
+#define SCREENSHOT_MAX_PENDING_ENCODES 8
+
+typedef struct ScreenshotSlot {
+	GLuint pbo;
+	GLsync fence;
+	size_t pbo_size;
+	int width;
+	int height;
+	int frames_waited;
+	char *path;
+	bool busy;
+} ScreenshotSlot;
+
+typedef struct ScreenshotImage {
+	uint8_t *pixels; // RGBA, bottom row first
+	int width;
+	int height;
+	char *path;
+	bool fast;
+} ScreenshotImage;
+
+static struct {
+	ScreenshotSlot slots[SCREENSHOT_NUM_SLOTS];
+	ThreadPool *encoder;
+	SDL_atomic_t pending_encodes;
+	int frames_requested; // negative means capture continuously
+	int sequence;         // numbers the frames of a burst; 0 for single screenshots
+	bool dropping;
+} screenshots;
+
+static void video_screenshot_encode(void *arg) {
+	ScreenshotImage *img = arg;
+	SDL_RWops *out = vfs_open(img->path, VFS_MODE_WRITE);
 
-	rw = video.real.width;
-	rh = video.real.height;
+	if(!out) {
+		log_warn("VFS error: %s", vfs_get_error());
+		goto done;
+	}
 
-	rw = max(rw, w);
-	rh = max(rh, h);
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_setup_error_handlers(png_ptr);
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+
+	// rows are read back bottom-up; just point libpng at them in reverse order
+	png_bytep *row_pointers = malloc(img->height * sizeof(png_bytep));
+
+	for(int y = 0; y < img->height; ++y) {
+		row_pointers[y] = img->pixels + (size_t)(img->height - 1 - y) * img->width * 4;
+	}
+
+	if(setjmp(png_jmpbuf(png_ptr))) {
+		log_warn("Failed to encode screenshot %s", img->path);
+	} else {
+		png_set_IHDR(png_ptr, info_ptr, img->width, img->height, 8, PNG_COLOR_TYPE_RGB,
+			PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 
-	data = malloc(3 * rw * rh);
+		if(img->fast) {
+			// bursts produce a lot of frames; favor keeping up over file size
+			png_set_compression_level(png_ptr, 1);
+		}
+
+		png_init_rwops_write(png_ptr, out);
+		png_set_rows(png_ptr, info_ptr, row_pointers);
+		png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_STRIP_FILLER_AFTER, NULL);
+
+		char *syspath = vfs_repr(img->path, true);
+		log_info("Saved screenshot as %s", syspath);
+		free(syspath);
+	}
+
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	free(row_pointers);
+	SDL_RWclose(out);
+
+done:
+	free(img->pixels);
+	free(img->path);
+	free(img);
+	SDL_AtomicAdd(&screenshots.pending_encodes, -1);
+}
+
+static void video_screenshot_submit(uint8_t *pixels, int w, int h, char *path) {
+	ScreenshotImage *img = malloc(sizeof(ScreenshotImage));
+	img->pixels = pixels;
+	img->width = w;
+	img->height = h;
+	img->path = path;
+	img->fast = screenshots.sequence > 0;
+
+	if(!screenshots.encoder) {
+		screenshots.encoder = threadpool_new("screenshot encoder", getenvint("TAISEI_SCREENSHOT_THREADS", 1));
+	}
+
+	threadpool_submit(screenshots.encoder, video_screenshot_encode, img, 0);
+}
+
+static char* video_screenshot_path(void) {
+	char outfile[128];
+	time_t rawtime;
 
 	time(&rawtime);
-	timeinfo = localtime(&rawtime);
-	strftime(outfile, 128, "taisei_%Y%m%d_%H-%M-%S_%Z.png", timeinfo);
+	strftime(outfile, sizeof(outfile), "taisei_%Y%m%d_%H-%M-%S_%Z", localtime(&rawtime));
+
+	if(screenshots.sequence) {
+		return strfmt("storage/screenshots/%s_%04i.png", outfile, screenshots.sequence++);
+	}
 
-	outpath = strjoin("storage/screenshots/", outfile, NULL);
-	syspath = vfs_repr(outpath, true);
-	log_info("Saving screenshot as %s", syspath);
-	free(syspath);
+	return strfmt("storage/screenshots/%s.png", outfile);
+}
 
-	out = vfs_open(outpath, VFS_MODE_WRITE);
-	free(outpath);
+static void video_screenshot_retrieve(ScreenshotSlot *slot) {
+	size_t size = (size_t)slot->width * slot->height * 4;
+	uint8_t *pixels = NULL;
 
-	if(!out) {
-		log_warn("VFS error: %s", vfs_get_error());
-		free(data);
-		return;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+	const void *mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+
+	if(mapped) {
+		pixels = malloc(size);
+		memcpy(pixels, mapped, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	} else {
+		log_warn("glMapBuffer() failed, screenshot %s lost", slot->path);
 	}
 
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot->busy = false;
+
+	if(pixels) {
+		video_screenshot_submit(pixels, slot->width, slot->height, slot->path);
+	} else {
+		free(slot->path);
+		SDL_AtomicAdd(&screenshots.pending_encodes, -1);
+	}
+
+	slot->path = NULL;
+}
+
+static bool video_screenshot_ready(ScreenshotSlot *slot, bool wait) {
+	if(slot->fence) {
+		GLenum status = glClientWaitSync(slot->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+
+		if(status == GL_TIMEOUT_EXPIRED) {
+			return false;
+		}
+
+		glDeleteSync(slot->fence);
+		slot->fence = NULL;
+		return true;
+	}
+
+	// without fences, give the GPU a couple of frames, so that mapping the buffer most likely won't stall
+	return wait || ++slot->frames_waited > 2;
+}
+
+static void video_screenshot_capture(ScreenshotSlot *slot) {
+	int w = video.current.width;
+	int h = video.current.height;
+	size_t size = (size_t)w * h * 4;
+	char *path = video_screenshot_path();
+
+	SDL_AtomicAdd(&screenshots.pending_encodes, 1);
 	glReadBuffer(GL_FRONT);
-	glReadPixels(0, 0, rw, rh, GL_RGB, GL_UNSIGNED_BYTE, data);
 
-	png_structp png_ptr;
-    png_infop info_ptr;
-	png_byte **row_pointers;
+	if(!slot) {
+		// no PBOs: the read itself stalls, but at least the encoding is done in the background
+		uint8_t *pixels = malloc(size);
+		glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		glReadBuffer(GL_BACK);
+		video_screenshot_submit(pixels, w, h, path);
+		return;
+	}
 
-	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-	png_setup_error_handlers(png_ptr);
-	info_ptr = png_create_info_struct(png_ptr);
+	if(!slot->pbo) {
+		glGenBuffers(1, &slot->pbo);
+	}
 
-	png_set_IHDR(png_ptr, info_ptr, w, h, 8, PNG_COLOR_TYPE_RGB,
-                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
 
-	row_pointers = png_malloc(png_ptr, h*sizeof(png_byte *));
+	if(slot->pbo_size != size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+		slot->pbo_size = size;
+	}
 
-	for(int y = 0; y < h; y++) {
-		row_pointers[y] = png_malloc(png_ptr, 8*3*w);
+	glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glReadBuffer(GL_BACK);
 
-		memcpy(row_pointers[y], data + rw*3*(h-1-y), w*3);
+	if(glext.sync) {
+		slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 	}
 
-	png_init_rwops_write(png_ptr, out);
-	png_set_rows(png_ptr, info_ptr, row_pointers);
-	png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+	slot->width = w;
+	slot->height = h;
+	slot->frames_waited = 0;
+	slot->path = path;
+	slot->busy = true;
+}
 
-	for(int y = 0; y < h; y++)
-		png_free(png_ptr, row_pointers[y]);
+void video_update_screenshots(void) {
+	ScreenshotSlot *free_slot = NULL;
 
-	png_free(png_ptr, row_pointers);
+	for(int i = 0; i < SCREENSHOT_NUM_SLOTS; ++i) {
+		ScreenshotSlot *slot = screenshots.slots + i;
 
-	png_destroy_write_struct(&png_ptr, &info_ptr);
+		if(slot->busy && video_screenshot_ready(slot, false)) {
+			video_screenshot_retrieve(slot);
+		}
 
-	free(data);
-	SDL_RWclose(out);
+		if(!slot->busy && !free_slot) {
+			free_slot = slot;
+		}
+	}
+
+	if(!screenshots.frames_requested) {
+		return;
+	}
+
+	if(glext.pixel_buffer_object && !free_slot) {
+		// still waiting on the GPU; try again next frame
+		return;
+	}
+
+	if(SDL_AtomicGet(&screenshots.pending_encodes) >= SCREENSHOT_MAX_PENDING_ENCODES) {
+		if(!screenshots.dropping) {
+			log_warn("Screenshot encoding can't keep up, skipping frames");
+			screenshots.dropping = true;
+		}
+
+		return;
+	}
+
+	screenshots.dropping = false;
+	video_screenshot_capture(glext.pixel_buffer_object ? free_slot : NULL);
+
+	if(screenshots.frames_requested > 0) {
+		--screenshots.frames_requested;
+	}
+}
+
+void video_take_screenshot(void) {
+	if(screenshots.frames_requested) {
+		return;
+	}
+
+	screenshots.frames_requested = getenvint("TAISEI_SCREENSHOT_BURST", 1);
+	screenshots.sequence = screenshots.frames_requested > 1;
+}
+
+void video_toggle_continuous_capture(void) {
+	if(screenshots.frames_requested < 0) {
+		log_info("Continuous capture stopped after %i frames", screenshots.sequence - 1);
+		screenshots.frames_requested = 0;
+	} else {
+		log_info("Continuous capture started");
+		screenshots.frames_requested = -1;
+		screenshots.sequence = 1;
+	}
+}
+
+static void video_screenshots_shutdown(void) {
+	// finish everything that's in flight, so that no screenshot is lost on exit
+	screenshots.frames_requested = 0;
+
+	for(int i = 0; i < SCREENSHOT_NUM_SLOTS; ++i) {
+		ScreenshotSlot *slot = screenshots.slots + i;
+
+		if(slot->busy) {
+			video_screenshot_ready(slot, true);
+			video_screenshot_retrieve(slot);
+		}
+
+		if(slot->pbo) {
+			glDeleteBuffers(1, &slot->pbo);
+		}
+	}
+
+	if(screenshots.encoder) {
+		threadpool_free(screenshots.encoder);
+	}
+
+	memset(&screenshots, 0, sizeof(screenshots));
 }
 
 bool video_is_resizable(void) {
@@ -598,6 +817,7 @@ void video_init(void) {
 }
 
 void video_shutdown(void) {
+	video_screenshots_shutdown();
 	SDL_DestroyWindow(video.window);
 	SDL_GL_DeleteContext(video.glcontext);
 	unload_gl_library();
@@ -43,4 +43,8 @@ void video_set_viewport(void);
 bool video_is_fullscreen(void);
 bool video_is_resizable(void);
 bool video_can_change_resolution(void);
+// Captures the next presented frame (or a burst of TAISEI_SCREENSHOT_BURST frames); saving happens in the background
 void video_take_screenshot(void);
+void video_toggle_continuous_capture(void);
+// Called once per frame; starts the requested readbacks and hands finished ones off to the encoder
+void video_update_screenshots(void);